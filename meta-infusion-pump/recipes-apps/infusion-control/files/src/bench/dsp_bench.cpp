@@ -0,0 +1,118 @@
+// ============================================================
+// Benchmark dos kernels de DSP
+// ============================================================
+//
+// Vazão de cada kernel (dot, multiply, butterfly, power) em cada caminho
+// compilado para a máquina (escalar, SSE2 ou NEON), nos tamanhos usados
+// pelo pipeline de pressão (FIR/decimador de 9..65 taps, FFT de 64..1024).
+// No fim, amostras/s do PressureAnalyzer completo com o caminho do
+// dispatch (ARGUS_DSP_KERNELS força um caminho).
+//
+// Uso: dsp-bench [ms_por_medida=200]
+
+#include "dsp_kernels.hpp"
+#include "pressure_dsp.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Impede o compilador de descartar o resultado
+static volatile float g_sink;
+
+// Repete 'fn' por 'ms' e retorna elementos processados por segundo
+template <class Fn>
+static double measure(unsigned ms, size_t elements_per_call, Fn&& fn)
+{
+    const auto budget = std::chrono::milliseconds(ms);
+    size_t calls = 0;
+    auto started = Clock::now();
+    auto elapsed = Clock::duration::zero();
+
+    do
+    {
+        for(int i = 0; i < 64; i++)
+            fn();
+        calls += 64;
+        elapsed = Clock::now() - started;
+    } while(elapsed < budget);
+
+    double s = std::chrono::duration<double>(elapsed).count();
+    return double(calls) * elements_per_call / s;
+}
+
+int main(int argc, char** argv)
+{
+    unsigned ms = argc > 1 ? unsigned(std::max(10, std::atoi(argv[1]))) : 200;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> a(2048), b(2048), c(2048), d(2048), zero(2048, 0.0f), out(2048);
+    for(size_t i = 0; i < a.size(); i++)
+    {
+        a[i] = dist(rng);
+        b[i] = dist(rng);
+        c[i] = dist(rng);
+        d[i] = dist(rng);
+    }
+
+    std::printf("Vazao em milhoes de elementos/s (%u ms por medida)\n", ms);
+    std::printf("%-8s %-10s %6s %10s\n", "caminho", "kernel", "n", "Melem/s");
+
+    const DspKernels* paths[] = {&dsp_kernels_scalar(), dsp_kernels_sse2(), dsp_kernels_neon()};
+    for(const DspKernels* k : paths)
+    {
+        if(!k)
+            continue;
+
+        for(size_t n : {9u, 33u, 65u})
+        {
+            double rate = measure(ms, n, [&] { g_sink = k->dot(a.data(), b.data(), n); });
+            std::printf("%-8s %-10s %6zu %10.1f\n", k->name, "dot", n, rate / 1e6);
+        }
+
+        for(size_t n : {64u, 256u, 1024u})
+        {
+            double rate = measure(ms, n, [&] {
+                k->multiply(a.data(), b.data(), out.data(), n);
+                g_sink = out[0];
+            });
+            std::printf("%-8s %-10s %6zu %10.1f\n", k->name, "multiply", n, rate / 1e6);
+
+            // Meia-largura n/2 como no último estágio de uma FFT de n pontos.
+            // Twiddles nulos: a chamada repetida não faz os valores crescerem até inf/NaN.
+            rate = measure(ms, n / 2, [&] {
+                k->butterfly(a.data(), b.data(), c.data(), d.data(), zero.data(), zero.data(), n / 2);
+                g_sink = a[0];
+            });
+            std::printf("%-8s %-10s %6zu %10.1f\n", k->name, "butterfly", n / 2, rate / 1e6);
+
+            rate = measure(ms, n, [&] {
+                k->power(a.data(), b.data(), out.data(), n);
+                g_sink = out[0];
+            });
+            std::printf("%-8s %-10s %6zu %10.1f\n", k->name, "power", n, rate / 1e6);
+        }
+    }
+
+    // Pipeline completo (biquad + decimador + FFT a cada meia janela)
+    PressureAnalyzer::Config cfg;
+    cfg.sample_rate_hz = 100.0f;
+    cfg.decimation = 4;
+    cfg.fft_size = 256;
+    PressureAnalyzer analyzer(cfg);
+
+    uint32_t raw = 0;
+    double rate = measure(ms, 1, [&] {
+        PressureAnalysis result;
+        raw = raw * 1103515245u + 12345u;
+        analyzer.push(1000 + (raw >> 24), result);
+    });
+    std::printf("\nPressureAnalyzer (%s, decimacao %u, FFT %zu): %.2f M amostras/s\n", dsp_kernels().name,
+                cfg.decimation, cfg.fft_size, rate / 1e6);
+    return 0;
+}
@@ -0,0 +1,276 @@
+// ============================================================
+// Benchmark do OTA contra um bootloader simulado
+// ============================================================
+//
+// Roda o OtaEngine de verdade (o mesmo do stm32-updater e do daemon) sobre
+// o bootloader simulado de ota_sim.hpp, sem hardware. --flash-us, --erase-ms,
+// --ack-us e --ber ajustam o modelo de tempo e de erros descrito lá.
+//
+// Varre clock x chunk x janela e imprime bytes/s, retransmissões e tempo
+// de cada combinação (mais uma linha do protocolo legado como referência).
+//
+// Uso: stm32-ota-bench [--size KB] [--image BIN] [--flash-us N] [--erase-ms N]
+//                      [--ack-us N] [--ber X] [--clocks a,b] [--chunks a,b]
+//                      [--windows a,b] [--lz] [--no-legacy] [--verbose]
+
+#include "ota_engine.hpp"
+#include "ota_sim.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+struct BenchConfig
+{
+    uint32_t size_kb = 64;
+    std::string image;
+    uint32_t flash_us = 200;
+    uint32_t erase_ms = 50;
+    uint32_t ack_us = 50;
+    double ber = 0.0;
+    std::vector<uint32_t> clocks = {500000, 1000000, 2000000};
+    std::vector<uint32_t> chunks = {64, 128, 243};
+    std::vector<uint32_t> windows = {1, 4, 16};
+    bool lz = false;
+    bool legacy = true;
+    bool verbose = false;
+};
+
+// ============================================================
+// Rodadas
+// ============================================================
+
+// Imagem "tipo firmware": vocabulário de instruções repetidas, padding 0xFF
+static std::vector<uint8_t> synthetic_image(uint32_t size)
+{
+    std::mt19937 rng(7);
+    std::vector<uint32_t> vocab(300);
+    for(auto& word : vocab)
+        word = rng();
+
+    std::vector<uint8_t> image;
+    image.reserve(size);
+    while(image.size() < size)
+    {
+        uint32_t word = (rng() % 4 == 0) ? rng() : vocab[rng() % vocab.size()];
+        for(int k = 0; k < 4 && image.size() < size; k++)
+            image.push_back(uint8_t(word >> (8 * k)));
+    }
+
+    std::fill(image.begin() + size * 7 / 8, image.end(), 0xFF);
+    return image;
+}
+
+struct Row
+{
+    bool v2;
+    uint32_t clock;
+    OtaResult result;
+    OtaStats stats;
+    bool verified;
+    uint64_t bit_errors;
+};
+
+// Logs do motor (printf) fora da tabela, a não ser com --verbose
+class QuietStdout
+{
+public:
+    explicit QuietStdout(bool quiet)
+    {
+        if(!quiet)
+            return;
+        fflush(stdout);
+        _saved = dup(STDOUT_FILENO);
+        FILE* null = fopen("/dev/null", "w");
+        if(null)
+        {
+            dup2(fileno(null), STDOUT_FILENO);
+            fclose(null);
+        }
+    }
+
+    ~QuietStdout()
+    {
+        if(_saved < 0)
+            return;
+        fflush(stdout);
+        dup2(_saved, STDOUT_FILENO);
+        close(_saved);
+    }
+
+private:
+    int _saved = -1;
+};
+
+static Row run(const BenchConfig& cfg, const std::vector<uint8_t>& image, bool v2, uint32_t clock, uint32_t chunk,
+               uint32_t window, uint32_t seed)
+{
+    SimBootloaderConfig sim;
+    sim.flash_us = cfg.flash_us;
+    sim.erase_ms = cfg.erase_ms;
+    sim.ack_us = cfg.ack_us;
+    sim.ber = cfg.ber;
+    sim.max_spi_hz = *std::max_element(cfg.clocks.begin(), cfg.clocks.end());
+    sim.lz_window_bits = cfg.lz ? OTA_LZ_MAX_WINDOW_BITS : 0;
+
+    SimBootloader bootloader(sim, v2, seed);
+    MemorySource source(image);
+
+    OtaOptions options;
+    options.allow_v2 = v2;
+    options.max_spi_hz = clock;
+    options.max_chunk = uint8_t(chunk);
+    options.window = uint8_t(window);
+    options.compress = cfg.lz;
+    options.resume = false;
+    options.skip_pages = false;
+
+    OtaEngine engine(bootloader, source, options);
+
+    Row row{v2, v2 ? clock : NEGOTIATION_HZ, OtaResult::Ok, OtaStats{}, false, 0};
+    {
+        QuietStdout quiet(!cfg.verbose);
+        row.result = engine.run();
+    }
+
+    row.stats = engine.stats();
+    row.verified = row.result == OtaResult::Ok && bootloader.flash() == image;
+    row.bit_errors = bootloader.bit_errors();
+    return row;
+}
+
+// "v2>leg": rodada v2 em que a negociação falhou e o motor caiu para o legado
+static const char* proto_name(const Row& row)
+{
+    if(!row.v2)
+        return "legado";
+    return row.stats.legacy_fallback ? "v2>leg" : "v2";
+}
+
+static std::vector<uint32_t> parse_list(const char* text)
+{
+    std::vector<uint32_t> values;
+    for(const char* p = text; *p;)
+    {
+        char* end;
+        unsigned long v = std::strtoul(p, &end, 10);
+        if(end == p)
+            break;
+        if(v > 0)
+            values.push_back(uint32_t(v));
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return values;
+}
+
+static void usage()
+{
+    std::printf("Uso: stm32-ota-bench [--size KB] [--image BIN] [--flash-us N] [--erase-ms N] [--ack-us N]\n"
+                "                     [--ber X] [--clocks a,b] [--chunks a,b] [--windows a,b] [--lz]\n"
+                "                     [--no-legacy] [--verbose]\n");
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig cfg;
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool has_value = i + 1 < argc;
+        if(std::strcmp(argv[i], "--size") == 0 && has_value)
+            cfg.size_kb = uint32_t(std::max(1, std::atoi(argv[++i])));
+        else if(std::strcmp(argv[i], "--image") == 0 && has_value)
+            cfg.image = argv[++i];
+        else if(std::strcmp(argv[i], "--flash-us") == 0 && has_value)
+            cfg.flash_us = uint32_t(std::max(0, std::atoi(argv[++i])));
+        else if(std::strcmp(argv[i], "--erase-ms") == 0 && has_value)
+            cfg.erase_ms = uint32_t(std::max(0, std::atoi(argv[++i])));
+        else if(std::strcmp(argv[i], "--ack-us") == 0 && has_value)
+            cfg.ack_us = uint32_t(std::max(0, std::atoi(argv[++i])));
+        else if(std::strcmp(argv[i], "--ber") == 0 && has_value)
+            cfg.ber = std::max(0.0, std::min(0.01, std::atof(argv[++i])));
+        else if(std::strcmp(argv[i], "--clocks") == 0 && has_value)
+            cfg.clocks = parse_list(argv[++i]);
+        else if(std::strcmp(argv[i], "--chunks") == 0 && has_value)
+            cfg.chunks = parse_list(argv[++i]);
+        else if(std::strcmp(argv[i], "--windows") == 0 && has_value)
+            cfg.windows = parse_list(argv[++i]);
+        else if(std::strcmp(argv[i], "--lz") == 0)
+            cfg.lz = true;
+        else if(std::strcmp(argv[i], "--no-legacy") == 0)
+            cfg.legacy = false;
+        else if(std::strcmp(argv[i], "--verbose") == 0)
+            cfg.verbose = true;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(cfg.clocks.empty() || cfg.chunks.empty() || cfg.windows.empty())
+    {
+        usage();
+        return 1;
+    }
+
+    std::vector<uint8_t> image;
+    if(!cfg.image.empty())
+    {
+        FileOtaSource file;
+        if(!file.open(cfg.image))
+        {
+            std::printf("Imagem %s ilegivel\n", cfg.image.c_str());
+            return 1;
+        }
+        image.assign(file.data(0, file.size()), file.data(0, file.size()) + file.size());
+    }
+    else
+        image = synthetic_image(cfg.size_kb * 1024);
+
+    for(auto& chunk : cfg.chunks)
+        chunk = std::min<uint32_t>(chunk, CMD_OTA_V2_CHUNK_MAX);
+    for(auto& window : cfg.windows)
+        window = std::min<uint32_t>(window, 255);
+
+    std::printf("Imagem %zu bytes%s, flash %u us/frame, apagamento %u ms, ACK %u us, BER %g\n", image.size(),
+                cfg.lz ? " (LZSS)" : "", cfg.flash_us, cfg.erase_ms, cfg.ack_us, cfg.ber);
+
+    std::vector<Row> rows;
+    uint32_t seed = 1;
+
+    if(cfg.legacy)
+        rows.push_back(run(cfg, image, false, NEGOTIATION_HZ, 48, 1, seed++));
+
+    for(uint32_t clock : cfg.clocks)
+    {
+        for(uint32_t chunk : cfg.chunks)
+        {
+            for(uint32_t window : cfg.windows)
+            {
+                rows.push_back(run(cfg, image, true, clock, chunk, window, seed++));
+                std::fprintf(stderr, ".");
+            }
+        }
+    }
+    std::fprintf(stderr, "\n");
+
+    std::printf("%-7s %9s %6s %6s %10s %9s %8s %7s %7s %9s %s\n", "proto", "clock", "chunk", "janela", "bytes/s",
+                "tempo s", "frames", "retx", "polls", "bits err", "resultado");
+    for(const auto& row : rows)
+    {
+        const OtaStats& st = row.stats;
+        const char* mismatch = (row.result == OtaResult::Ok && !row.verified) ? " (imagem divergente)" : "";
+        std::printf("%-7s %9u %6u %6u %10.0f %9.2f %8u %7u %7u %9llu %s%s\n", proto_name(row), row.clock,
+                    st.chunk, st.window, st.bytes_per_second(), st.elapsed.count() / 1000.0, st.frames,
+                    st.retransmissions, st.polls, static_cast<unsigned long long>(row.bit_errors),
+                    ota_result_name(row.result), mismatch);
+    }
+
+    return 0;
+}
@@ -0,0 +1,519 @@
+#ifndef OTA_SIM_HPP
+#define OTA_SIM_HPP
+
+// ============================================================
+// Bootloader simulado (stm32-ota-bench e ota-engine-test)
+// ============================================================
+//
+// OtaLink que imita o bootloader do STM32, sem hardware: CAPS, START/CHUNK/END
+// do legado, WCHUNK + ACK/SACK do v2 e, conforme as features anunciadas,
+// LZSS, delta (contra o banco ativo), páginas (CRC do banco inativo) e
+// retomada (STATUS + START com RESUME). A sessão sobrevive entre execuções
+// do motor, como no bootloader de verdade quando o hub cai.
+//
+// Modelo de tempo (relógio real, o motor mede com steady_clock):
+//   - transferência: len * 8 / clock, mais os 100 us de estabilização do DMA
+//   - READY baixa por flash_us depois de cada frame de dados (gravação) e
+//     por erase_ms depois do START (apagamento do banco)
+//   - a resposta (ACK/RES) só fica armada no DMA ack_us depois do frame;
+//     uma transação antes disso não a recebe
+//   - cada bit, nos dois sentidos, inverte com probabilidade ber (o CRC do
+//     frame descarta o que chegou corrompido)
+
+#include "ota_delta.hpp"
+#include "ota_link.hpp"
+#include "ota_lz.hpp"
+#include "ota_source.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "cmd.h"
+#include "utl_crc16.h"
+#include "utl_io.h"
+}
+
+using SimClock = std::chrono::steady_clock;
+
+// Clock da negociação (o mesmo do stm32-updater)
+static constexpr uint32_t NEGOTIATION_HZ = 100000;
+
+// Estabilização do DMA após a READY (mesmo valor do HalOtaLink)
+static constexpr std::chrono::microseconds DMA_SETTLE{100};
+
+struct SimBootloaderConfig
+{
+    uint32_t flash_us = 200;
+    uint32_t erase_ms = 50;
+    uint32_t ack_us = 50;
+    double ber = 0.0;
+    uint32_t max_spi_hz = 2000000;
+    uint8_t lz_window_bits = 0; // 0 = sem LZSS
+    uint8_t features = 0;       // CMD_OTA_FEAT_*
+    uint32_t page_size = 1024;  // CMD_OTA_FEAT_PAGES
+};
+
+// Espera ativa: sleep_for tem granularidade pior que uma transferência
+inline void sim_busy_wait(std::chrono::nanoseconds duration)
+{
+    auto until = SimClock::now() + duration;
+    while(SimClock::now() < until)
+    {
+    }
+}
+
+inline void sim_wait_until(SimClock::time_point when)
+{
+    auto now = SimClock::now();
+    if(when <= now)
+        return;
+
+    // Dorme o grosso e termina em espera ativa
+    if(when - now > std::chrono::milliseconds(1))
+        std::this_thread::sleep_until(when - std::chrono::microseconds(500));
+    sim_busy_wait(when - SimClock::now());
+}
+
+class SimBootloader : public OtaLink
+{
+public:
+    SimBootloader(const SimBootloaderConfig& cfg, bool v2, uint32_t seed) : _cfg(cfg), _v2(v2), _rng(seed) {}
+
+    bool exchange(const uint8_t* tx, uint8_t* rx, size_t len) override
+    {
+        sim_wait_until(_busy_until); // READY baixa
+        std::this_thread::sleep_for(DMA_SETTLE);
+
+        auto started = SimClock::now();
+        sim_busy_wait(std::chrono::nanoseconds(uint64_t(len) * 8 * 1000000000ull / _hz));
+
+        // O que estava armado no DMA quando a transação começou
+        std::memset(rx, 0, len);
+        if(!_armed.empty() && _armed.front().at <= started)
+        {
+            const auto& frame = _armed.front().frame;
+            std::memcpy(rx, frame.data(), std::min(len, frame.size()));
+            _armed.pop_front();
+        }
+
+        _mosi.assign(tx, tx + len);
+        flip_bits(_mosi.data(), len);
+        flip_bits(rx, len);
+
+        ota_scan_frames(_mosi.data(), len, [&](const OtaFrameView& f) { handle(f, started); });
+        return true;
+    }
+
+    uint32_t speed() const override
+    {
+        return _hz;
+    }
+
+    bool set_speed(uint32_t hz) override
+    {
+        _hz = hz;
+        return true;
+    }
+
+    // Banco ativo (base do delta) e conteúdo inicial do banco inativo
+    void set_active(std::vector<uint8_t> image)
+    {
+        _active = std::move(image);
+    }
+
+    void set_inactive(std::vector<uint8_t> image)
+    {
+        _flash = std::move(image);
+    }
+
+    // Banco inativo: imagem montada no END (descomprimida/reconstruída)
+    const std::vector<uint8_t>& flash() const
+    {
+        return _flash;
+    }
+
+    bool session_open() const
+    {
+        return _open;
+    }
+
+    uint64_t bit_errors() const
+    {
+        return _bit_errors;
+    }
+
+private:
+    struct Armed
+    {
+        SimClock::time_point at;
+        std::vector<uint8_t> frame;
+        bool is_ack;
+    };
+
+    const SimBootloaderConfig _cfg;
+    const bool _v2;
+    std::mt19937 _rng;
+    uint32_t _hz = NEGOTIATION_HZ;
+    SimClock::time_point _busy_until{};
+    std::deque<Armed> _armed;
+    std::vector<uint8_t> _mosi;
+    uint64_t _bit_errors = 0;
+
+    std::vector<uint8_t> _active;
+
+    // Sessão
+    bool _open = false;
+    uint32_t _total = 0;      // total_size do START
+    uint32_t _image_size = 0; // imagem gravada (delta: a reconstruída)
+    uint16_t _crc = 0;
+    uint8_t _chunk = 0;
+    uint8_t _flags = 0;     // start.flags sem RESUME
+    uint8_t _lz_bits = 0;   // 0 = imagem crua
+    uint32_t _base_size = 0;
+    bool _start_v2 = false; // START v2 traz o CRC da imagem; o legado não
+    std::vector<uint8_t> _stream;
+    size_t _stream_len = 0; // maior offset + len recebido (fim do stream LZSS)
+    std::vector<uint8_t> _flash;
+    std::vector<bool> _received; // por seq
+    uint32_t _next = 0;
+    uint16_t _end_status = CMD_OK;
+    bool _ended = false;
+
+    void flip_bits(uint8_t* buf, size_t len)
+    {
+        if(_cfg.ber <= 0.0)
+            return;
+
+        // Distância até o próximo bit errado (geométrica), em vez de sortear bit a bit
+        std::geometric_distribution<uint64_t> gap(_cfg.ber);
+        for(uint64_t bit = gap(_rng); bit < uint64_t(len) * 8; bit += gap(_rng) + 1)
+        {
+            buf[bit / 8] ^= uint8_t(1u << (bit % 8));
+            _bit_errors++;
+        }
+    }
+
+    void arm(uint8_t id, const uint8_t* payload, uint16_t len, SimClock::time_point at, bool is_ack = false)
+    {
+        // O DMA só guarda um ACK: o mais novo substitui o que não foi lido
+        if(is_ack)
+        {
+            _armed.erase(std::remove_if(_armed.begin(), _armed.end(), [](const Armed& a) { return a.is_ack; }),
+                         _armed.end());
+        }
+
+        std::vector<uint8_t> frame(FRAME_MAX_CMD_SIZE);
+        frame.resize(ota_build_frame(frame.data(), id, payload, len));
+        _armed.push_back(Armed{at + std::chrono::microseconds(_cfg.ack_us), std::move(frame), is_ack});
+    }
+
+    void result(uint8_t req_id, uint8_t status, SimClock::time_point at)
+    {
+        uint8_t payload[2] = {req_id, status};
+        arm(CMD_OTA_RES_ID, payload, sizeof(payload), at);
+    }
+
+    void ack(SimClock::time_point at)
+    {
+        uint32_t sack = 0;
+        for(uint32_t i = 0; i < CMD_OTA_SACK_BITS; i++)
+        {
+            uint32_t seq = _next + 1 + i;
+            if(seq < _received.size() && _received[seq])
+                sack |= 1u << i;
+        }
+
+        uint8_t payload[sizeof(cmd_ota_ack_t)];
+        uint8_t* p = payload;
+        utl_io_put16_tl_ap(uint16_t(_next), p);
+        utl_io_put32_tl_ap(sack, p);
+        utl_io_put8_tl_ap(CMD_OK, p);
+        arm(CMD_OTA_ACK_ID, payload, sizeof(payload), at, true);
+    }
+
+    // Bytes do stream gravados em ordem (múltiplo do chunk)
+    uint32_t committed() const
+    {
+        if(!_chunk)
+            return 0;
+        return uint32_t(std::min<size_t>(_next, _stream_len / _chunk) * _chunk);
+    }
+
+    void handle(const OtaFrameView& f, SimClock::time_point at)
+    {
+        uint8_t* p = const_cast<uint8_t*>(f.payload);
+
+        switch(f.id)
+        {
+        case CMD_OTA_CAPS_REQ_ID:
+            if(_v2)
+            {
+                cmd_ota_caps_t caps{};
+                caps.proto = CMD_OTA_PROTO_V2;
+                caps.max_window = CMD_OTA_SACK_BITS;
+                caps.max_chunk = CMD_OTA_V2_CHUNK_MAX;
+                caps.features = _cfg.features;
+                caps.max_spi_hz = _cfg.max_spi_hz;
+                caps.lz_window_bits = _cfg.lz_window_bits;
+                caps.page_size = _cfg.page_size;
+                arm(CMD_OTA_CAPS_RES_ID, reinterpret_cast<uint8_t*>(&caps), sizeof(caps), at);
+            }
+            else
+                result(f.id, CMD_ERR_UNKNOWN_CMD, at);
+            break;
+
+        case CMD_OTA_STATUS_REQ_ID:
+            if(_v2 && (_cfg.features & CMD_OTA_FEAT_RESUME))
+                status(at);
+            else
+                result(f.id, CMD_ERR_UNKNOWN_CMD, at);
+            break;
+
+        case CMD_OTA_PAGES_REQ_ID:
+            if(_v2 && (_cfg.features & CMD_OTA_FEAT_PAGES) && f.len >= sizeof(cmd_ota_pages_req_t))
+                pages(p, at);
+            else
+                result(f.id, CMD_ERR_UNKNOWN_CMD, at);
+            break;
+
+        case CMD_OTA_START_REQ_ID:
+            start(f, p, at);
+            break;
+
+        case CMD_OTA_CHUNK_REQ_ID:
+        {
+            uint32_t offset = utl_io_get32_fl(p);
+            uint8_t len = p[4];
+            if(!_open || size_t(offset) + len > _stream.size())
+            {
+                result(f.id, CMD_ERR_PARAM_RANGE, at);
+                break;
+            }
+            std::memcpy(&_stream[offset], p + 5, len);
+            _stream_len = std::max(_stream_len, size_t(offset) + len);
+            _busy_until = at + std::chrono::microseconds(_cfg.flash_us);
+            result(f.id, CMD_OK, at);
+            break;
+        }
+
+        case CMD_OTA_WCHUNK_REQ_ID:
+        {
+            uint16_t seq16 = utl_io_get16_fl(p);
+            uint32_t offset = utl_io_get32_fl(p + 2);
+            uint8_t len = p[6];
+            uint32_t seq = _next + uint32_t(int16_t(uint16_t(seq16 - uint16_t(_next))));
+
+            if(_open && size_t(offset) + len <= _stream.size() && seq < _received.size())
+            {
+                std::memcpy(&_stream[offset], p + 7, len);
+                _stream_len = std::max(_stream_len, size_t(offset) + len);
+                _received[seq] = true;
+                while(_next < _received.size() && _received[_next])
+                    _next++;
+                _busy_until = at + std::chrono::microseconds(_cfg.flash_us);
+            }
+            ack(at);
+            break;
+        }
+
+        case CMD_OTA_END_REQ_ID:
+            if(!_ended)
+                end();
+            result(f.id, uint8_t(_end_status), at);
+            break;
+        }
+    }
+
+    void status(SimClock::time_point at)
+    {
+        cmd_ota_status_t st{};
+        if(_open)
+        {
+            st.open = 1;
+            st.flags = _flags;
+            st.chunk = _chunk;
+            st.total_size = _total;
+            st.image_crc = _crc;
+            st.committed = committed();
+            st.stream_crc = utl_crc16_data(_stream.data(), st.committed, 0xFFFF);
+        }
+        arm(CMD_OTA_STATUS_RES_ID, reinterpret_cast<uint8_t*>(&st), sizeof(st), at);
+    }
+
+    // CRC de cada página do banco inativo, limitada a image_size (apagado = 0xFF)
+    void pages(uint8_t* p, SimClock::time_point at)
+    {
+        uint32_t image_size = utl_io_get32_fl_ap(p);
+        uint16_t first = utl_io_get16_fl_ap(p);
+        uint8_t count = std::min<uint8_t>(utl_io_get8_fl_ap(p), CMD_OTA_PAGES_MAX);
+
+        uint8_t payload[sizeof(cmd_ota_pages_res_t)];
+        uint8_t* r = payload;
+        utl_io_put16_tl_ap(first, r);
+        utl_io_put8_tl_ap(count, r);
+
+        std::vector<uint8_t> page;
+        for(uint32_t k = 0; k < count; k++)
+        {
+            size_t offset = size_t(first + k) * _cfg.page_size;
+            size_t len = offset < image_size ? std::min<size_t>(_cfg.page_size, image_size - offset) : 0;
+
+            page.assign(len, 0xFF);
+            if(offset < _flash.size())
+                std::copy_n(_flash.begin() + offset, std::min(len, _flash.size() - offset), page.begin());
+            utl_io_put16_tl_ap(utl_crc16_data(page.data(), page.size(), 0xFFFF), r);
+        }
+
+        arm(CMD_OTA_PAGES_RES_ID, payload, uint16_t(r - payload), at);
+    }
+
+    void start(const OtaFrameView& f, uint8_t* p, SimClock::time_point at)
+    {
+        const bool v2 = f.len >= sizeof(cmd_ota_start_v2_t);
+        const uint32_t total = utl_io_get32_fl(p);
+        uint8_t chunk = 48;
+        uint8_t flags = 0;
+        uint16_t crc = 0;
+
+        if(v2)
+        {
+            chunk = p[6];
+            flags = p[7];
+            crc = utl_io_get16_fl(p + 8);
+        }
+
+        const bool resume = flags & CMD_OTA_START_RESUME;
+        flags &= uint8_t(~CMD_OTA_START_RESUME);
+
+        // Infos depois do cmd_ota_start_v2_t: delta e, em seguida, LZSS
+        uint8_t* info = p + sizeof(cmd_ota_start_v2_t);
+        uint32_t image_size = total;
+        uint32_t base_size = 0;
+        uint16_t base_crc = 0;
+        if(flags & CMD_OTA_START_DELTA)
+        {
+            image_size = utl_io_get32_fl(info);
+            base_size = utl_io_get32_fl(info + 4);
+            base_crc = utl_io_get16_fl(info + 8);
+            info += sizeof(cmd_ota_delta_info_t);
+        }
+        const uint8_t lz_bits = (flags & CMD_OTA_START_LZ) ? info[0] : 0;
+
+        const bool same = _open && v2 == _start_v2 && total == _total && flags == _flags && chunk == _chunk &&
+                          crc == _crc;
+
+        // Retomada: mesma sessão, banco preservado, envio a partir do committed
+        if(resume)
+        {
+            if(!same || !(_cfg.features & CMD_OTA_FEAT_RESUME))
+            {
+                result(f.id, CMD_ERR_INVALID_STATE, at);
+                return;
+            }
+
+            _next = committed() / _chunk;
+            std::fill(_received.begin() + _next, _received.end(), false);
+            result(f.id, CMD_OK, at);
+            return;
+        }
+
+        // START repetido (resultado perdido): só repete o CMD_OTA_RES
+        if(same && _next == 0)
+        {
+            result(f.id, CMD_OK, at);
+            return;
+        }
+
+        // Delta: a base tem que ser o banco ativo
+        if((flags & CMD_OTA_START_DELTA) &&
+           (base_size > _active.size() || utl_crc16_data(_active.data(), base_size, 0xFFFF) != base_crc))
+        {
+            result(f.id, CMD_ERR_CHECKSUM, at);
+            return;
+        }
+
+        _open = true;
+        _ended = false;
+        _start_v2 = v2;
+        _total = total;
+        _image_size = image_size;
+        _base_size = base_size;
+        _chunk = chunk;
+        _flags = flags;
+        _lz_bits = lz_bits;
+        _crc = crc;
+
+        // Stream comprimido pode passar da imagem (dado incompressível)
+        size_t capacity = _lz_bits ? ota_lz_bound(image_size) : total;
+        _stream.assign(capacity, 0xFF);
+
+        // Páginas: banco não é apagado; frames com offset explícito, um seq por frame
+        size_t frames = (capacity + _chunk - 1) / _chunk;
+        if(flags & CMD_OTA_START_PAGES)
+        {
+            std::copy_n(_flash.begin(), std::min(_flash.size(), capacity), _stream.begin());
+            frames += capacity / _cfg.page_size + 1;
+        }
+        else
+            _busy_until = at + std::chrono::milliseconds(_cfg.erase_ms);
+
+        _received.assign(frames, false);
+        _next = 0;
+        _stream_len = 0;
+
+        result(f.id, CMD_OK, at);
+    }
+
+    void end()
+    {
+        _ended = true;
+        _open = false;
+
+        bool ok = true;
+        if(_flags & CMD_OTA_START_DELTA)
+            ok = ota_delta_apply(_active.data(), _base_size, _stream.data(), _total, _flash, _image_size);
+        else if(_lz_bits)
+            ok = ota_lz_decompress(_stream.data(), _stream_len, _lz_bits, _flash, _image_size);
+        else
+            _flash.assign(_stream.begin(), _stream.begin() + _total);
+
+        if(!ok)
+        {
+            _end_status = CMD_ERR_PARAM_RANGE;
+            return;
+        }
+
+        bool crc_ok = !_start_v2 || utl_crc16_data(_flash.data(), _flash.size(), 0xFFFF) == _crc;
+        _end_status = (_flash.size() == _image_size && crc_ok) ? CMD_OK : CMD_ERR_CHECKSUM;
+    }
+};
+
+// Imagem em memória (a do benchmark ou a do teste)
+class MemorySource : public OtaSource
+{
+public:
+    explicit MemorySource(const std::vector<uint8_t>& image) : _image(image) {}
+
+    uint32_t size() const override
+    {
+        return uint32_t(_image.size());
+    }
+
+    const uint8_t* data(uint32_t offset, size_t len) override
+    {
+        if(size_t(offset) + len > _image.size())
+            return nullptr;
+        return _image.data() + offset;
+    }
+
+private:
+    const std::vector<uint8_t>& _image;
+};
+
+#endif
@@ -0,0 +1,168 @@
+// ============================================================
+// Benchmark do SpiBusArbiter (multi-bomba)
+// ============================================================
+//
+// Simula N canais no mesmo controlador SPI, sem hardware: cada canal tem
+// uma thread de polling (GET_STATUS a cada poll_ms) e uma de comandos
+// (intervalo aleatório), serializadas pelo mutex do canal como no
+// InfusionManager. Cada transação = 2 transferências de 64 bytes
+// (comando + resposta) no clock configurado.
+//
+// Mede a latência de comando e de poll por canal (pedido -> resposta)
+// enquanto o número de canais cresce.
+//
+// Uso: spi-bus-bench [max_canais=4] [segundos=3] [poll_ms=50] [spi_hz=1000000]
+
+#include "spi_bus_arbiter.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig
+{
+    unsigned max_channels = 4;
+    unsigned seconds = 3;
+    unsigned poll_ms = 50;
+    uint32_t spi_hz = 1000000;
+};
+
+struct Channel
+{
+    std::mutex spi_mutex; // equivalente ao _spi_mutex do InfusionManager
+    std::vector<double> cmd_us;
+    std::vector<double> poll_us;
+};
+
+// Espera ativa: sleep_for tem granularidade pior que uma transferência
+static void busy_wait(std::chrono::nanoseconds duration)
+{
+    auto until = Clock::now() + duration;
+    while(Clock::now() < until)
+    {
+    }
+}
+
+static double transaction(SpiBusArbiter& bus, SpiPriority prio, std::chrono::nanoseconds xfer)
+{
+    auto started = Clock::now();
+
+    // Comando e resposta: o barramento é liberado entre as duas (espera da READY)
+    for(int i = 0; i < 2; i++)
+    {
+        SpiBusArbiter::Lease lease = bus.acquire(prio);
+        busy_wait(xfer);
+        lease.reset();
+        std::this_thread::sleep_for(std::chrono::microseconds(100)); // estabilização DMA
+    }
+
+    return std::chrono::duration<double, std::micro>(Clock::now() - started).count();
+}
+
+static double percentile(std::vector<double>& v, double p)
+{
+    if(v.empty())
+        return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = static_cast<size_t>(p * (v.size() - 1));
+    return v[idx];
+}
+
+static void run(const BenchConfig& cfg, unsigned n_channels)
+{
+    SpiBusArbiter bus;
+    std::vector<std::unique_ptr<Channel>> channels;
+    for(unsigned i = 0; i < n_channels; i++)
+        channels.push_back(std::make_unique<Channel>());
+
+    // 64 bytes * 8 bits no clock do SPI
+    const std::chrono::nanoseconds xfer(64ull * 8ull * 1000000000ull / cfg.spi_hz);
+
+    std::atomic<bool> running{true};
+    std::vector<std::thread> threads;
+
+    for(unsigned i = 0; i < n_channels; i++)
+    {
+        Channel& ch = *channels[i];
+
+        threads.emplace_back([&, i] {
+            auto next = Clock::now() + std::chrono::milliseconds(i); // desalinha os canais
+            while(running)
+            {
+                std::this_thread::sleep_until(next);
+                next += std::chrono::milliseconds(cfg.poll_ms);
+
+                std::lock_guard<std::mutex> lock(ch.spi_mutex);
+                ch.poll_us.push_back(transaction(bus, SpiPriority::Poll, xfer));
+            }
+        });
+
+        threads.emplace_back([&, i] {
+            std::mt19937 rng(1234 + i);
+            std::uniform_int_distribution<int> gap_ms(5, 40);
+            while(running)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(gap_ms(rng)));
+
+                auto requested = Clock::now();
+                std::lock_guard<std::mutex> lock(ch.spi_mutex);
+                transaction(bus, SpiPriority::Command, xfer);
+                ch.cmd_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - requested).count());
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(cfg.seconds));
+    running = false;
+    for(auto& t : threads)
+        t.join();
+
+    std::printf("\n== %u canal(is) ==\n", n_channels);
+    std::printf("%-6s %8s %10s %10s %10s %10s %10s\n", "canal", "cmds", "cmd p50", "cmd p99", "cmd max", "poll p50",
+                "poll p99");
+    for(unsigned i = 0; i < n_channels; i++)
+    {
+        Channel& ch = *channels[i];
+        size_t n_cmds = ch.cmd_us.size();
+        double cmd_max = ch.cmd_us.empty() ? 0.0 : *std::max_element(ch.cmd_us.begin(), ch.cmd_us.end());
+        std::printf("%-6u %8zu %10.0f %10.0f %10.0f %10.0f %10.0f\n", i, n_cmds, percentile(ch.cmd_us, 0.50),
+                    percentile(ch.cmd_us, 0.99), cmd_max, percentile(ch.poll_us, 0.50),
+                    percentile(ch.poll_us, 0.99));
+    }
+
+    auto st = bus.stats();
+    for(int p = 0; p < 2; p++)
+    {
+        double avg = st.grants[p] ? double(st.total_wait[p].count()) / st.grants[p] : 0.0;
+        std::printf("espera no barramento (%s): media %.0f us, max %lld us\n", p == 0 ? "comando" : "poll", avg,
+                    static_cast<long long>(st.max_wait[p].count()));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchConfig cfg;
+    if(argc > 1)
+        cfg.max_channels = std::max(1, std::atoi(argv[1]));
+    if(argc > 2)
+        cfg.seconds = std::max(1, std::atoi(argv[2]));
+    if(argc > 3)
+        cfg.poll_ms = std::max(1, std::atoi(argv[3]));
+    if(argc > 4)
+        cfg.spi_hz = std::max(1000, std::atoi(argv[4]));
+
+    std::printf("SPI %u Hz, poll %u ms, %u s por rodada (latências em us)\n", cfg.spi_hz, cfg.poll_ms, cfg.seconds);
+
+    for(unsigned n = 1; n <= cfg.max_channels; n++)
+        run(cfg, n);
+
+    return 0;
+}
@@ -37,6 +37,14 @@ typedef enum cmd_ids_e
     CMD_OTA_START_REQ_ID = 0x50,
     CMD_OTA_CHUNK_REQ_ID = 0x51,
     CMD_OTA_END_REQ_ID = 0x52,
+    CMD_OTA_CAPS_REQ_ID = 0x53,   /* OTA v2: pergunta as capacidades do bootloader */
+    CMD_OTA_WCHUNK_REQ_ID = 0x54, /* OTA v2: chunk com número de sequência (janela) */
+    CMD_OTA_STATUS_REQ_ID = 0x55, /* OTA v2: sessão em andamento (retomada) */
+    CMD_OTA_PAGES_REQ_ID = 0x56,  /* OTA v2: CRC16 por página do banco inativo */
+    CMD_OTA_PAGES_RES_ID = 0x5B,
+    CMD_OTA_STATUS_RES_ID = 0x5C,
+    CMD_OTA_CAPS_RES_ID = 0x5D,
+    CMD_OTA_ACK_ID = 0x5E, /* OTA v2: ACK cumulativo + seletivo */
     CMD_OTA_RES_ID = 0x5F,
 } cmd_ids_t;
 
@@ -240,4 +248,186 @@ typedef struct
 {
 } cmd_ota_end_t;
 
+/* --- OTA v2 (janela deslizante) ---
+ *
+ * Negociado antes do START: o hub envia CMD_OTA_CAPS_REQ (sem payload). Um
+ * bootloader v2 responde CMD_OTA_CAPS_RES; qualquer outra resposta (ou
+ * nenhuma) mantém o protocolo legado (START/CHUNK/END, um chunk por ACK).
+ *
+ * No v2 o START leva cmd_ota_start_v2_t e os dados vão em
+ * CMD_OTA_WCHUNK_REQ com até 'window' frames sem confirmação. O SPI é
+ * full-duplex: o bootloader deixa o último cmd_ota_ack_t armado no DMA e o
+ * hub o recebe durante a transação do frame seguinte (ou de um poll com
+ * zeros quando a janela está cheia). Só os seq fora do ACK cumulativo e
+ * ausentes no SACK são retransmitidos. O END continua igual e é confirmado
+ * por CMD_OTA_RES depois que o bootloader confere o CRC da imagem.
+ *
+ * START e END do v2 são idempotentes: sem resultado, o hub os reenvia (um
+ * frame perdido não derruba o OTA). Repetição de um START igual ao da sessão
+ * em andamento, ou de um END já processado, só repete o CMD_OTA_RES. */
+
+#define CMD_OTA_PROTO_V2        2
+#define CMD_OTA_SACK_BITS       32
+#define CMD_OTA_WCHUNK_HDR_SIZE 7 /* seq + offset + len */
+#define CMD_OTA_V2_CHUNK_MAX    (CMD_MAX_DATA_SIZE - CMD_OTA_WCHUNK_HDR_SIZE)
+
+/* Transação do v2: tamanho do frame WCHUNK com o chunk negociado. Depois do
+ * ACK do START o bootloader arma o DMA com esse tamanho e o hub passa para
+ * o clock anunciado no START (ambos valem até o END). */
+#define CMD_OTA_V2_XFER_SIZE(chunk) (CMD_HDR_SIZE + CMD_OTA_WCHUNK_HDR_SIZE + (chunk) + CMD_TRAILER_SIZE)
+
+/* --- OTA v2: delta contra a imagem instalada ---
+ *
+ * Com CMD_OTA_FEAT_DELTA no caps, o hub pode mandar CMD_OTA_START_DELTA em
+ * flags: o START leva cmd_ota_start_v2_t seguido de cmd_ota_delta_info_t,
+ * total_size passa a ser o tamanho do stream de delta e image_crc continua
+ * sendo o da imagem nova (reconstruída). Antes de apagar o banco inativo o
+ * bootloader confere base_crc sobre os base_size primeiros bytes do banco
+ * ativo; se não bater responde CMD_ERR_CHECKSUM e o hub manda a imagem
+ * inteira.
+ *
+ * O stream é uma sequência de operações aplicadas em ordem, escrevendo no
+ * banco inativo a partir do offset 0 (as fronteiras de operação não
+ * coincidem com as de frame):
+ *
+ *   ADD  00 LEN(2) BYTES[LEN]   bytes novos
+ *   COPY 01 SRC(4) LEN(2)       LEN bytes do banco ativo a partir de SRC
+ *   RUN  02 LEN(2) BYTE         LEN cópias de BYTE (padding, tabelas zeradas)
+ *
+ * Campos little-endian. Qualquer operação fora dos limites (SRC + LEN além
+ * de base_size, saída além de image_size) aborta com CMD_ERR_PARAM_RANGE. */
+
+#define CMD_OTA_FEAT_DELTA  0x01 /* caps.features */
+#define CMD_OTA_START_DELTA 0x01 /* start.flags */
+
+#define CMD_OTA_DELTA_ADD  0x00
+#define CMD_OTA_DELTA_COPY 0x01
+#define CMD_OTA_DELTA_RUN  0x02
+
+/* --- OTA v2: imagem comprimida (LZSS) ---
+ *
+ * Com caps.lz_window_bits != 0 o hub pode mandar CMD_OTA_START_LZ: o START
+ * leva cmd_ota_start_v2_t seguido de cmd_ota_lz_info_t (depois do
+ * cmd_ota_delta_info_t, se houver). total_size continua sendo o tamanho da
+ * imagem gravada; os WCHUNK carregam o stream comprimido, cujo tamanho não é
+ * anunciado (termina no END). image_crc é o da imagem descomprimida.
+ *
+ * Stream: grupos de um byte de flags + até 8 itens, bit 0 primeiro.
+ *   bit 0: literal (1 byte)
+ *   bit 1: referência u16 LE = (dist - 1) | ((len - 3) << window_bits)
+ * dist <= 2^window_bits: o bootloader só precisa de um buffer circular
+ * desse tamanho. window_bits <= caps.lz_window_bits. */
+
+#define CMD_OTA_START_LZ     0x02 /* start.flags */
+#define CMD_OTA_LZ_MIN_MATCH 3
+
+/* --- OTA v2: retomada ---
+ *
+ * Com CMD_OTA_FEAT_RESUME o bootloader mantém a sessão aberta (START aceito
+ * e END ainda não recebido) mesmo se o hub cair, e grava em flash, junto com
+ * os dados, quantos bytes do stream já foram gravados em ordem e o CRC16
+ * deles. CMD_OTA_STATUS_REQ (sem payload) devolve cmd_ota_status_t.
+ *
+ * Se o stream do hub tiver o mesmo prefixo (CRC de [0, committed)), o hub
+ * repete o START da sessão (mesmos campos e infos) com CMD_OTA_START_RESUME:
+ * o bootloader não apaga o banco e o envio continua no seq committed/chunk.
+ * START com RESUME que não confere com a sessão aberta recebe NACK
+ * CMD_ERR_INVALID_STATE e o hub recomeça com um START normal. */
+
+#define CMD_OTA_FEAT_RESUME  0x02 /* caps.features */
+#define CMD_OTA_START_RESUME 0x04 /* start.flags */
+
+/* --- OTA v2: só as páginas alteradas ---
+ *
+ * Com CMD_OTA_FEAT_PAGES, CMD_OTA_PAGES_REQ pede o CRC16 (semente 0xFFFF)
+ * de até CMD_OTA_PAGES_MAX páginas do banco inativo, cada uma limitada a
+ * image_size (a última página da imagem só até o fim dela). O hub compara
+ * com a imagem nova e manda START com CMD_OTA_START_PAGES: o bootloader não
+ * apaga o banco, apaga cada página na primeira escrita nela e os WCHUNK
+ * trazem só as páginas diferentes (offset explícito, seq contínuo). O END
+ * confere image_crc sobre a imagem inteira, inclusive as páginas mantidas.
+ *
+ * Uma sessão PAGES interrompida não precisa de retomada: a próxima consulta
+ * já encontra as páginas gravadas iguais. */
+
+#define CMD_OTA_FEAT_PAGES  0x04 /* caps.features */
+#define CMD_OTA_START_PAGES 0x08 /* start.flags */
+
+/* Cabe na transação de 64 bytes da negociação (antes do START) */
+#define CMD_OTA_PAGES_MAX 26
+
+typedef struct __attribute__((packed))
+{
+    uint8_t proto;      /* CMD_OTA_PROTO_V2 */
+    uint8_t max_window; /* frames que o bootloader consegue bufferizar */
+    uint8_t max_chunk;  /* bytes de dados por frame */
+    uint8_t features;   /* CMD_OTA_FEAT_* */
+    uint32_t max_spi_hz; /* clock máximo aceito durante a transferência */
+    uint8_t lz_window_bits; /* janela do descompressor (0 = sem LZSS) */
+    uint32_t page_size;     /* página de flash (CMD_OTA_FEAT_PAGES) */
+} cmd_ota_caps_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t total_size;
+    uint8_t proto;
+    uint8_t window;
+    uint8_t chunk;
+    uint8_t flags;      /* CMD_OTA_START_* */
+    uint16_t image_crc; /* CRC16 (semente 0xFFFF) da imagem inteira, conferido no END */
+    uint32_t spi_hz;    /* clock dos frames seguintes (<= max_spi_hz) */
+} cmd_ota_start_v2_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t image_size; /* tamanho da imagem reconstruída */
+    uint32_t base_size;  /* bytes do banco ativo usados como base */
+    uint16_t base_crc;   /* CRC16 (semente 0xFFFF) desses bytes */
+} cmd_ota_delta_info_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t window_bits; /* janela usada pelo compressor */
+} cmd_ota_lz_info_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t open;        /* 1 = sessão aberta */
+    uint8_t flags;       /* start.flags da sessão (sem RESUME) */
+    uint8_t chunk;       /* chunk da sessão */
+    uint32_t total_size; /* total_size do START */
+    uint16_t image_crc;  /* image_crc do START */
+    uint32_t committed;  /* bytes do stream gravados em ordem (múltiplo de chunk) */
+    uint16_t stream_crc; /* CRC16 (semente 0xFFFF) de [0, committed) do stream */
+} cmd_ota_status_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t image_size;
+    uint16_t first; /* primeira página */
+    uint8_t count;  /* <= CMD_OTA_PAGES_MAX */
+} cmd_ota_pages_req_t;
+
+typedef struct __attribute__((packed))
+{
+    uint16_t first;
+    uint8_t count;
+    uint16_t crc[CMD_OTA_PAGES_MAX];
+} cmd_ota_pages_res_t;
+
+typedef struct __attribute__((packed))
+{
+    uint16_t seq; /* contador de frames (volta em 65536) */
+    uint32_t offset;
+    uint8_t len;
+    uint8_t data[CMD_OTA_V2_CHUNK_MAX];
+} cmd_ota_wchunk_t;
+
+typedef struct __attribute__((packed))
+{
+    uint16_t next_seq; /* todos os seq anteriores gravados (cumulativo) */
+    uint32_t sack;     /* bit i = seq next_seq + 1 + i recebido */
+    uint8_t status;    /* cmd_status_t (erro aborta a sessão) */
+} cmd_ota_ack_t;
+
 #endif
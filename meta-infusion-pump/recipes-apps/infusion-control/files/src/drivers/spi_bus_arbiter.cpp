@@ -0,0 +1,74 @@
+#include "spi_bus_arbiter.hpp"
+
+SpiBusArbiter::SpiBusArbiter(std::chrono::microseconds poll_max_defer) : _poll_max_defer(poll_max_defer) {}
+
+const SpiBusArbiter::Waiter* SpiBusArbiter::next_waiter(SpiPriority& prio) const
+{
+    const auto& commands = _queues[static_cast<size_t>(SpiPriority::Command)];
+    const auto& polls = _queues[static_cast<size_t>(SpiPriority::Poll)];
+
+    if(!polls.empty() && std::chrono::steady_clock::now() - polls.front().since >= _poll_max_defer)
+    {
+        prio = SpiPriority::Poll;
+        return &polls.front();
+    }
+
+    if(!commands.empty())
+    {
+        prio = SpiPriority::Command;
+        return &commands.front();
+    }
+
+    if(!polls.empty())
+    {
+        prio = SpiPriority::Poll;
+        return &polls.front();
+    }
+
+    return nullptr;
+}
+
+SpiBusArbiter::Lease SpiBusArbiter::acquire(SpiPriority prio)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    const uint64_t ticket = _next_ticket++;
+    const auto since = std::chrono::steady_clock::now();
+    _queues[static_cast<size_t>(prio)].push_back(Waiter{ticket, since});
+
+    // A decisão é refeita a cada release(); só o escolhido sai do wait
+    _cv.wait(lock, [&] {
+        if(_busy)
+            return false;
+        SpiPriority next_prio;
+        const Waiter* next = next_waiter(next_prio);
+        return next && next->ticket == ticket;
+    });
+
+    _queues[static_cast<size_t>(prio)].pop_front();
+    _busy = true;
+
+    auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - since);
+    size_t idx = static_cast<size_t>(prio);
+    _stats.grants[idx]++;
+    _stats.total_wait[idx] += waited;
+    if(waited > _stats.max_wait[idx])
+        _stats.max_wait[idx] = waited;
+
+    return Lease(this);
+}
+
+void SpiBusArbiter::release()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _busy = false;
+    }
+    _cv.notify_all();
+}
+
+SpiBusArbiter::Stats SpiBusArbiter::stats() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _stats;
+}
@@ -0,0 +1,111 @@
+#ifndef SPI_BUS_ARBITER_HPP
+#define SPI_BUS_ARBITER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+// ============================================================
+// Arbitragem do controlador SPI compartilhado
+// ============================================================
+//
+// Vários canais (um STM32 por chip select) dividem o mesmo controlador.
+// Cada Stm32Bridge pede o barramento só em volta da transferência (a
+// espera da READY fica fora), então um STM32 lento não bloqueia os outros.
+//
+// Política:
+//   - Comandos passam na frente de polls de status (latência percebida).
+//   - Dentro de cada classe, FIFO por ordem de chegada: como cada canal tem
+//     no máximo uma transação pendente, isso equivale a round-robin.
+//   - Envelhecimento: um poll que já esperou mais que 'poll_max_defer' é
+//     atendido antes dos comandos (evita inanição sob rajada de comandos).
+
+enum class SpiPriority : uint8_t
+{
+    Command = 0,
+    Poll = 1,
+};
+
+class SpiBusArbiter
+{
+public:
+    struct Stats
+    {
+        uint64_t grants[2] = {0, 0};
+        std::chrono::microseconds total_wait[2]{};
+        std::chrono::microseconds max_wait[2]{};
+    };
+
+    // Posse do barramento (RAII). Lease vazio = sem arbitragem.
+    class Lease
+    {
+    public:
+        Lease() = default;
+        explicit Lease(SpiBusArbiter* owner) : _owner(owner) {}
+
+        Lease(Lease&& other) noexcept : _owner(other._owner)
+        {
+            other._owner = nullptr;
+        }
+
+        Lease& operator=(Lease&& other) noexcept
+        {
+            if(this != &other)
+            {
+                reset();
+                _owner = other._owner;
+                other._owner = nullptr;
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease()
+        {
+            reset();
+        }
+
+        void reset()
+        {
+            if(_owner)
+                _owner->release();
+            _owner = nullptr;
+        }
+
+    private:
+        SpiBusArbiter* _owner = nullptr;
+    };
+
+    explicit SpiBusArbiter(std::chrono::microseconds poll_max_defer = std::chrono::milliseconds(20));
+
+    // Bloqueia até o barramento ser concedido
+    Lease acquire(SpiPriority prio);
+
+    Stats stats() const;
+
+private:
+    struct Waiter
+    {
+        uint64_t ticket;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    const std::chrono::microseconds _poll_max_defer;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<Waiter> _queues[2]; // indexado por SpiPriority
+    bool _busy = false;
+    uint64_t _next_ticket = 0;
+    Stats _stats;
+
+    // Próximo a ser atendido (chamar com _mutex)
+    const Waiter* next_waiter(SpiPriority& prio) const;
+    void release();
+};
+
+#endif
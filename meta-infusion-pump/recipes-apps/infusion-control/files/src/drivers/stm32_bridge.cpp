@@ -11,10 +11,13 @@ extern "C"
 #include "utl_io.h"
 }
 
-Stm32Bridge::Stm32Bridge(HalSpi& spi, HalGpio& ready_pin) : _spi(spi), _ready_pin(ready_pin) {}
+Stm32Bridge::Stm32Bridge(HalSpi& spi, HalGpio& ready_pin, SpiBusArbiter* arbiter)
+    : _spi(spi), _ready_pin(ready_pin), _arbiter(arbiter)
+{
+}
 
 // Transação Segura: Espera Hardware -> Delay -> Transfere
-bool Stm32Bridge::_safe_transfer(size_t len)
+bool Stm32Bridge::_safe_transfer(size_t len, SpiPriority prio)
 {
     int retries = 500; // Timeout de segurança (~5s)
 
@@ -32,11 +35,37 @@ bool Stm32Bridge::_safe_transfer(size_t len)
     // 2. Delay de Estabilização DMA (Crítico)
     std::this_thread::sleep_for(std::chrono::microseconds(100));
 
-    // 3. Transferência SPI
+    // 3. Transferência SPI (o barramento compartilhado só é ocupado aqui)
+    SpiBusArbiter::Lease lease = _arbiter ? _arbiter->acquire(prio) : SpiBusArbiter::Lease();
     return _spi.transfer(_tx_buf, _rx_buf, len);
 }
 
-bool Stm32Bridge::send_command(cmd_ids_t req_id, cmd_cmds_t* req_data, cmd_cmds_t* res_data)
+// Polling da READY no OTA: milhares de transações seguidas, os 10 ms do
+// _safe_transfer dominariam o tempo de transferência
+static constexpr std::chrono::microseconds EXCHANGE_READY_POLL{50};
+static constexpr std::chrono::milliseconds EXCHANGE_READY_TIMEOUT{5000};
+
+bool Stm32Bridge::exchange(const uint8_t* tx, uint8_t* rx, size_t len, SpiPriority prio)
+{
+    auto deadline = std::chrono::steady_clock::now() + EXCHANGE_READY_TIMEOUT;
+
+    while(!_ready_pin.get())
+    {
+        if(std::chrono::steady_clock::now() > deadline)
+        {
+            std::cerr << "[BRIDGE] Timeout Hardware: STM32 nao levantou Ready Pin" << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for(EXCHANGE_READY_POLL);
+    }
+
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+    SpiBusArbiter::Lease lease = _arbiter ? _arbiter->acquire(prio) : SpiBusArbiter::Lease();
+    return _spi.transfer(tx, rx, len);
+}
+
+bool Stm32Bridge::send_command(cmd_ids_t req_id, cmd_cmds_t* req_data, cmd_cmds_t* res_data, SpiPriority prio)
 {
     // Limpa buffers
     std::memset(_tx_buf, 0, sizeof(_tx_buf));
@@ -58,7 +87,7 @@ bool Stm32Bridge::send_command(cmd_ids_t req_id, cmd_cmds_t* req_data, cmd_cmds_
     size_t xfer_len = (encoded_size < 64) ? 64 : encoded_size;
 
     // 2. Envia o Comando
-    if(!_safe_transfer(xfer_len))
+    if(!_safe_transfer(xfer_len, prio))
     {
         return false;
     }
@@ -68,7 +97,7 @@ bool Stm32Bridge::send_command(cmd_ids_t req_id, cmd_cmds_t* req_data, cmd_cmds_
     std::memset(_tx_buf, 0, 64);
 
     // Lê 64 bytes de resposta (pode conter lixo + resposta)
-    if(!_safe_transfer(64))
+    if(!_safe_transfer(64, prio))
     {
         return false;
     }
@@ -3,6 +3,7 @@
 
 #include "hal_spi.hpp"
 #include "hal_gpio.hpp"
+#include "spi_bus_arbiter.hpp"
 #include <cstdint>
 #include <vector>
 
@@ -14,34 +15,47 @@ extern "C"
 class Stm32Bridge
 {
 public:
-    // Recebe referências para as HALs já instanciadas
-    Stm32Bridge(HalSpi& spi, HalGpio& ready_pin);
+    // Recebe referências para as HALs já instanciadas.
+    // arbiter: controlador SPI compartilhado com outros canais (nullptr = exclusivo)
+    Stm32Bridge(HalSpi& spi, HalGpio& ready_pin, SpiBusArbiter* arbiter = nullptr);
 
-    // Método principal síncrono
-    bool send_command(cmd_ids_t req_id, cmd_cmds_t* req_data, cmd_cmds_t* res_data);
+    // Método principal síncrono. prio só importa com barramento compartilhado.
+    bool send_command(cmd_ids_t req_id, cmd_cmds_t* req_data, cmd_cmds_t* res_data,
+                      SpiPriority prio = SpiPriority::Command);
 
-    void suspend_hardware()
+    // Transação crua (sem cmd_encode/scanner de resposta): espera a READY e
+    // transfere 'len' bytes full-duplex. Usada pelo OTA (BridgeOtaLink), que
+    // tem framing próprio; espera da READY com polling curto.
+    bool exchange(const uint8_t* tx, uint8_t* rx, size_t len, SpiPriority prio = SpiPriority::Command);
+
+    // Clock do SPI deste canal (o OTA v2 negocia e restaura)
+    uint32_t speed() const
+    {
+        return _spi.speed();
+    }
+
+    bool set_speed(uint32_t hz)
     {
-        _ready_pin.release();
-        _spi.close_device();
+        return _spi.set_speed(hz);
     }
 
-    void resume_hardware()
+    // Linha READY do STM32 (usada para detectar o boot após reset/OTA)
+    HalGpio& ready_line()
     {
-        _spi.open_device();
-        _ready_pin.acquire();
+        return _ready_pin;
     }
 
 private:
     HalSpi& _spi;
     HalGpio& _ready_pin;
+    SpiBusArbiter* _arbiter;
 
     // Buffers internos
     uint8_t _tx_buf[300];
     uint8_t _rx_buf[300];
 
     // O método que replica o spi_transaction do loopback
-    bool _safe_transfer(size_t len);
+    bool _safe_transfer(size_t len, SpiPriority prio);
 };
 
 #endif
@@ -0,0 +1,66 @@
+#include "dsp_kernels.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__aarch64__) || defined(__arm__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+// ============================================================
+// Detecção de CPU
+// ============================================================
+
+static bool cpu_has_neon()
+{
+#if defined(__aarch64__)
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#elif defined(__arm__)
+    return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+    return false;
+#endif
+}
+
+static bool cpu_has_sse2()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("sse2");
+#else
+    return false;
+#endif
+}
+
+static const DspKernels& select_kernels()
+{
+    const char* forced = std::getenv("ARGUS_DSP_KERNELS");
+
+    const DspKernels* neon = cpu_has_neon() ? dsp_kernels_neon() : nullptr;
+    const DspKernels* sse2 = cpu_has_sse2() ? dsp_kernels_sse2() : nullptr;
+
+    if(forced)
+    {
+        if(std::strcmp(forced, "scalar") == 0)
+            return dsp_kernels_scalar();
+        if(std::strcmp(forced, "neon") == 0 && neon)
+            return *neon;
+        if(std::strcmp(forced, "sse2") == 0 && sse2)
+            return *sse2;
+
+        std::cerr << "[DSP] ARGUS_DSP_KERNELS=" << forced << " indisponivel nesta CPU — usando deteccao\n";
+    }
+
+    if(neon)
+        return *neon;
+    if(sse2)
+        return *sse2;
+    return dsp_kernels_scalar();
+}
+
+const DspKernels& dsp_kernels()
+{
+    // Escolha feita uma única vez (thread-safe em C++11)
+    static const DspKernels& kernels = select_kernels();
+    return kernels;
+}
@@ -0,0 +1,44 @@
+#ifndef DSP_KERNELS_HPP
+#define DSP_KERNELS_HPP
+
+#include <cstddef>
+
+// ============================================================
+// Kernels vetoriais de DSP
+// ============================================================
+//
+// Cada caminho (escalar, SSE2, NEON) preenche a mesma tabela de ponteiros.
+// A seleção acontece em tempo de execução (dsp_kernels()), de forma que o
+// mesmo binário roda em qualquer máquina Linux e aproveita NEON no Cortex-A53.
+//
+// Todos os kernels operam sobre arrays contíguos de float e aceitam qualquer
+// tamanho (a cauda não múltipla da largura do vetor é tratada em escalar).
+
+struct DspKernels
+{
+    const char* name;
+
+    // Produto interno: sum(a[i] * b[i])  (núcleo do FIR e do decimador)
+    float (*dot)(const float* a, const float* b, size_t n);
+
+    // Multiplicação elemento a elemento: out[i] = a[i] * b[i]  (janelamento)
+    void (*multiply)(const float* a, const float* b, float* out, size_t n);
+
+    // Borboleta radix-2 (DIT) com twiddles contíguos:
+    //   t = w[j] * b[j];  b[j] = a[j] - t;  a[j] = a[j] + t
+    void (*butterfly)(float* a_re, float* a_im, float* b_re, float* b_im, const float* w_re, const float* w_im,
+                      size_t n);
+
+    // Espectro de potência: out[i] = re[i]^2 + im[i]^2
+    void (*power)(const float* re, const float* im, float* out, size_t n);
+};
+
+// Tabela escolhida em tempo de execução (pode ser forçada com ARGUS_DSP_KERNELS=scalar|sse2|neon)
+const DspKernels& dsp_kernels();
+
+// Caminhos individuais. SSE2/NEON retornam nullptr quando não compilados para a arquitetura.
+const DspKernels& dsp_kernels_scalar();
+const DspKernels* dsp_kernels_sse2();
+const DspKernels* dsp_kernels_neon();
+
+#endif
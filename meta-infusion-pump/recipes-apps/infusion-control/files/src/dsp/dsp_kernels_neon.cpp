@@ -0,0 +1,113 @@
+#include "dsp_kernels.hpp"
+
+// ============================================================
+// Caminho NEON (Cortex-A53 do RPi Zero 2W, AArch64 ou ARMv7+NEON)
+// ============================================================
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+
+static inline float neon_hsum(float32x4_t v)
+{
+#if defined(__aarch64__)
+    return vaddvq_f32(v);
+#else
+    float32x2_t s = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    s = vpadd_f32(s, s);
+    return vget_lane_f32(s, 0);
+#endif
+}
+
+static float neon_dot(const float* a, const float* b, size_t n)
+{
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+
+    // vmlaq (e não vfmaq) para manter compatibilidade com ARMv7 sem VFPv4
+    for(; i + 8 <= n; i += 8)
+    {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    for(; i + 4 <= n; i += 4)
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+
+    float acc = neon_hsum(vaddq_f32(acc0, acc1));
+    for(; i < n; i++)
+        acc += a[i] * b[i];
+    return acc;
+}
+
+static void neon_multiply(const float* a, const float* b, float* out, size_t n)
+{
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    for(; i < n; i++)
+        out[i] = a[i] * b[i];
+}
+
+static void neon_butterfly(float* a_re, float* a_im, float* b_re, float* b_im, const float* w_re, const float* w_im,
+                           size_t n)
+{
+    size_t j = 0;
+    for(; j + 4 <= n; j += 4)
+    {
+        float32x4_t wr = vld1q_f32(w_re + j);
+        float32x4_t wi = vld1q_f32(w_im + j);
+        float32x4_t br = vld1q_f32(b_re + j);
+        float32x4_t bi = vld1q_f32(b_im + j);
+        float32x4_t ar = vld1q_f32(a_re + j);
+        float32x4_t ai = vld1q_f32(a_im + j);
+
+        float32x4_t t_re = vmlsq_f32(vmulq_f32(wr, br), wi, bi);
+        float32x4_t t_im = vmlaq_f32(vmulq_f32(wr, bi), wi, br);
+
+        vst1q_f32(b_re + j, vsubq_f32(ar, t_re));
+        vst1q_f32(b_im + j, vsubq_f32(ai, t_im));
+        vst1q_f32(a_re + j, vaddq_f32(ar, t_re));
+        vst1q_f32(a_im + j, vaddq_f32(ai, t_im));
+    }
+    for(; j < n; j++)
+    {
+        float t_re = w_re[j] * b_re[j] - w_im[j] * b_im[j];
+        float t_im = w_re[j] * b_im[j] + w_im[j] * b_re[j];
+
+        b_re[j] = a_re[j] - t_re;
+        b_im[j] = a_im[j] - t_im;
+        a_re[j] = a_re[j] + t_re;
+        a_im[j] = a_im[j] + t_im;
+    }
+}
+
+static void neon_power(const float* re, const float* im, float* out, size_t n)
+{
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        float32x4_t r = vld1q_f32(re + i);
+        float32x4_t m = vld1q_f32(im + i);
+        vst1q_f32(out + i, vmlaq_f32(vmulq_f32(r, r), m, m));
+    }
+    for(; i < n; i++)
+        out[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+const DspKernels* dsp_kernels_neon()
+{
+    static const DspKernels kernels = {
+        "neon", neon_dot, neon_multiply, neon_butterfly, neon_power,
+    };
+    return &kernels;
+}
+
+#else
+
+const DspKernels* dsp_kernels_neon()
+{
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#include "dsp_kernels.hpp"
+
+// ============================================================
+// Caminho escalar (referência numérica e fallback)
+// ============================================================
+
+static float scalar_dot(const float* a, const float* b, size_t n)
+{
+    float acc = 0.0f;
+    for(size_t i = 0; i < n; i++)
+        acc += a[i] * b[i];
+    return acc;
+}
+
+static void scalar_multiply(const float* a, const float* b, float* out, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        out[i] = a[i] * b[i];
+}
+
+static void scalar_butterfly(float* a_re, float* a_im, float* b_re, float* b_im, const float* w_re, const float* w_im,
+                             size_t n)
+{
+    for(size_t j = 0; j < n; j++)
+    {
+        float t_re = w_re[j] * b_re[j] - w_im[j] * b_im[j];
+        float t_im = w_re[j] * b_im[j] + w_im[j] * b_re[j];
+
+        b_re[j] = a_re[j] - t_re;
+        b_im[j] = a_im[j] - t_im;
+        a_re[j] = a_re[j] + t_re;
+        a_im[j] = a_im[j] + t_im;
+    }
+}
+
+static void scalar_power(const float* re, const float* im, float* out, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        out[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+const DspKernels& dsp_kernels_scalar()
+{
+    static const DspKernels kernels = {
+        "scalar", scalar_dot, scalar_multiply, scalar_butterfly, scalar_power,
+    };
+    return kernels;
+}
@@ -0,0 +1,110 @@
+#include "dsp_kernels.hpp"
+
+// ============================================================
+// Caminho SSE2 (x86 / x86_64 — hosts de desenvolvimento e CI)
+// ============================================================
+
+#if defined(__SSE2__)
+
+#include <emmintrin.h>
+
+static float sse2_dot(const float* a, const float* b, size_t n)
+{
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+
+    // Dois acumuladores para esconder a latência da soma
+    for(; i + 8 <= n; i += 8)
+    {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for(; i + 4 <= n; i += 4)
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+
+    acc0 = _mm_add_ps(acc0, acc1);
+
+    // Soma horizontal
+    __m128 shuf = _mm_shuffle_ps(acc0, acc0, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(acc0, shuf);
+    shuf = _mm_movehl_ps(shuf, sums);
+    sums = _mm_add_ss(sums, shuf);
+
+    float acc = _mm_cvtss_f32(sums);
+    for(; i < n; i++)
+        acc += a[i] * b[i];
+    return acc;
+}
+
+static void sse2_multiply(const float* a, const float* b, float* out, size_t n)
+{
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    for(; i < n; i++)
+        out[i] = a[i] * b[i];
+}
+
+static void sse2_butterfly(float* a_re, float* a_im, float* b_re, float* b_im, const float* w_re, const float* w_im,
+                           size_t n)
+{
+    size_t j = 0;
+    for(; j + 4 <= n; j += 4)
+    {
+        __m128 wr = _mm_loadu_ps(w_re + j);
+        __m128 wi = _mm_loadu_ps(w_im + j);
+        __m128 br = _mm_loadu_ps(b_re + j);
+        __m128 bi = _mm_loadu_ps(b_im + j);
+        __m128 ar = _mm_loadu_ps(a_re + j);
+        __m128 ai = _mm_loadu_ps(a_im + j);
+
+        __m128 t_re = _mm_sub_ps(_mm_mul_ps(wr, br), _mm_mul_ps(wi, bi));
+        __m128 t_im = _mm_add_ps(_mm_mul_ps(wr, bi), _mm_mul_ps(wi, br));
+
+        _mm_storeu_ps(b_re + j, _mm_sub_ps(ar, t_re));
+        _mm_storeu_ps(b_im + j, _mm_sub_ps(ai, t_im));
+        _mm_storeu_ps(a_re + j, _mm_add_ps(ar, t_re));
+        _mm_storeu_ps(a_im + j, _mm_add_ps(ai, t_im));
+    }
+    for(; j < n; j++)
+    {
+        float t_re = w_re[j] * b_re[j] - w_im[j] * b_im[j];
+        float t_im = w_re[j] * b_im[j] + w_im[j] * b_re[j];
+
+        b_re[j] = a_re[j] - t_re;
+        b_im[j] = a_im[j] - t_im;
+        a_re[j] = a_re[j] + t_re;
+        a_im[j] = a_im[j] + t_im;
+    }
+}
+
+static void sse2_power(const float* re, const float* im, float* out, size_t n)
+{
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4)
+    {
+        __m128 r = _mm_loadu_ps(re + i);
+        __m128 m = _mm_loadu_ps(im + i);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(r, r), _mm_mul_ps(m, m)));
+    }
+    for(; i < n; i++)
+        out[i] = re[i] * re[i] + im[i] * im[i];
+}
+
+const DspKernels* dsp_kernels_sse2()
+{
+    static const DspKernels kernels = {
+        "sse2", sse2_dot, sse2_multiply, sse2_butterfly, sse2_power,
+    };
+    return &kernels;
+}
+
+#else
+
+const DspKernels* dsp_kernels_sse2()
+{
+    return nullptr;
+}
+
+#endif
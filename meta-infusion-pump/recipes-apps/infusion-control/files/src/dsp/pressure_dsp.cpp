@@ -0,0 +1,303 @@
+#include "pressure_dsp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+static constexpr float PI_F = 3.14159265358979323846f;
+
+// ============================================================
+// FIR
+// ============================================================
+
+FirFilter::FirFilter(std::vector<float> taps) : _taps(std::move(taps))
+{
+    if(_taps.empty())
+        _taps.push_back(1.0f);
+    _history.assign(_taps.size() * 2, 0.0f);
+}
+
+void FirFilter::reset()
+{
+    std::fill(_history.begin(), _history.end(), 0.0f);
+    _pos = 0;
+}
+
+void FirFilter::_push(float x)
+{
+    // Histórico cresce "para trás": _history[_pos] é sempre a amostra mais nova,
+    // e [_pos, _pos + N) é a janela contígua na ordem dos taps.
+    const size_t n = _taps.size();
+    _pos = (_pos == 0) ? n - 1 : _pos - 1;
+    _history[_pos] = x;
+    _history[_pos + n] = x;
+}
+
+float FirFilter::_output() const
+{
+    return dsp_kernels().dot(&_history[_pos], _taps.data(), _taps.size());
+}
+
+float FirFilter::process(float x)
+{
+    _push(x);
+    return _output();
+}
+
+void FirFilter::process(const float* in, float* out, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        out[i] = process(in[i]);
+}
+
+std::vector<float> FirFilter::design_lowpass(size_t num_taps, float cutoff)
+{
+    std::vector<float> taps(num_taps);
+    const float mid = (num_taps - 1) / 2.0f;
+    float sum = 0.0f;
+
+    for(size_t i = 0; i < num_taps; i++)
+    {
+        float t = i - mid;
+        float sinc = (t == 0.0f) ? 2.0f * cutoff : std::sin(2.0f * PI_F * cutoff * t) / (PI_F * t);
+        float hamming = (num_taps > 1) ? 0.54f - 0.46f * std::cos(2.0f * PI_F * i / (num_taps - 1)) : 1.0f;
+        taps[i] = sinc * hamming;
+        sum += taps[i];
+    }
+
+    // Ganho unitário em DC
+    for(auto& tap : taps)
+        tap /= sum;
+
+    return taps;
+}
+
+// ============================================================
+// Biquad
+// ============================================================
+
+float BiquadFilter::process(float x)
+{
+    float y = _c.b0 * x + _z1;
+    _z1 = _c.b1 * x - _c.a1 * y + _z2;
+    _z2 = _c.b2 * x - _c.a2 * y;
+    return y;
+}
+
+void BiquadFilter::process(const float* in, float* out, size_t n)
+{
+    for(size_t i = 0; i < n; i++)
+        out[i] = process(in[i]);
+}
+
+void BiquadFilter::reset()
+{
+    _z1 = 0.0f;
+    _z2 = 0.0f;
+}
+
+BiquadFilter::Coeffs BiquadFilter::design_lowpass(float sample_rate_hz, float cutoff_hz, float q)
+{
+    float w0 = 2.0f * PI_F * cutoff_hz / sample_rate_hz;
+    float cos_w0 = std::cos(w0);
+    float alpha = std::sin(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+
+    Coeffs c;
+    c.b0 = ((1.0f - cos_w0) / 2.0f) / a0;
+    c.b1 = (1.0f - cos_w0) / a0;
+    c.b2 = c.b0;
+    c.a1 = (-2.0f * cos_w0) / a0;
+    c.a2 = (1.0f - alpha) / a0;
+    return c;
+}
+
+// ============================================================
+// Decimador
+// ============================================================
+
+Decimator::Decimator(unsigned factor, size_t num_taps)
+    : _factor(factor < 1 ? 1 : factor),
+      _fir(_factor > 1 ? FirFilter::design_lowpass(num_taps, 0.4f / _factor) : std::vector<float>{1.0f})
+{
+}
+
+bool Decimator::push(float x, float& out)
+{
+    if(_factor == 1)
+    {
+        out = x;
+        return true;
+    }
+
+    _fir._push(x);
+    if(++_phase < _factor)
+        return false;
+
+    _phase = 0;
+    out = _fir._output();
+    return true;
+}
+
+void Decimator::reset()
+{
+    _fir.reset();
+    _phase = 0;
+}
+
+// ============================================================
+// Espectro (FFT radix-2)
+// ============================================================
+
+SpectrumAnalyzer::SpectrumAnalyzer(size_t size) : _size(size)
+{
+    if(size < 8 || (size & (size - 1)) != 0)
+        throw std::invalid_argument("SpectrumAnalyzer: tamanho deve ser potencia de 2 >= 8");
+
+    _window.resize(size);
+    for(size_t i = 0; i < size; i++)
+        _window[i] = 0.5f - 0.5f * std::cos(2.0f * PI_F * i / (size - 1));
+
+    unsigned bits = 0;
+    while((size_t(1) << bits) < size)
+        bits++;
+
+    _bitrev.resize(size);
+    for(size_t i = 0; i < size; i++)
+    {
+        uint32_t r = 0;
+        for(unsigned b = 0; b < bits; b++)
+            r |= ((i >> b) & 1u) << (bits - 1 - b);
+        _bitrev[i] = r;
+    }
+
+    // Estágio com meia-largura h usa w_j = exp(-i*pi*j/h), j < h, no offset h - 1
+    _tw_re.resize(size - 1);
+    _tw_im.resize(size - 1);
+    for(size_t h = 1; h < size; h <<= 1)
+    {
+        for(size_t j = 0; j < h; j++)
+        {
+            double angle = -M_PI * double(j) / double(h);
+            _tw_re[h - 1 + j] = float(std::cos(angle));
+            _tw_im[h - 1 + j] = float(std::sin(angle));
+        }
+    }
+
+    _re.resize(size);
+    _im.resize(size);
+    _scratch.resize(size);
+    _power.resize(size / 2 + 1);
+}
+
+void SpectrumAnalyzer::_fft()
+{
+    const DspKernels& k = dsp_kernels();
+
+    for(size_t h = 1; h < _size; h <<= 1)
+    {
+        const float* wr = &_tw_re[h - 1];
+        const float* wi = &_tw_im[h - 1];
+
+        for(size_t base = 0; base < _size; base += 2 * h)
+            k.butterfly(&_re[base], &_im[base], &_re[base + h], &_im[base + h], wr, wi, h);
+    }
+}
+
+size_t SpectrumAnalyzer::analyze(const float* samples)
+{
+    const DspKernels& k = dsp_kernels();
+
+    float mean = 0.0f;
+    for(size_t i = 0; i < _size; i++)
+        mean += samples[i];
+    mean /= _size;
+
+    for(size_t i = 0; i < _size; i++)
+        _scratch[i] = samples[i] - mean;
+
+    k.multiply(_scratch.data(), _window.data(), _scratch.data(), _size);
+
+    for(size_t i = 0; i < _size; i++)
+    {
+        _re[_bitrev[i]] = _scratch[i];
+        _im[i] = 0.0f;
+    }
+
+    _fft();
+
+    k.power(_re.data(), _im.data(), _power.data(), _power.size());
+
+    size_t best = 1;
+    for(size_t bin = 2; bin < _power.size(); bin++)
+    {
+        if(_power[bin] > _power[best])
+            best = bin;
+    }
+    return best;
+}
+
+// ============================================================
+// PressureAnalyzer
+// ============================================================
+
+static float default_lowpass(const PressureAnalyzer::Config& cfg)
+{
+    return cfg.lowpass_hz > 0.0f ? cfg.lowpass_hz : 0.2f * cfg.sample_rate_hz;
+}
+
+PressureAnalyzer::PressureAnalyzer(const Config& cfg)
+    : _cfg(cfg), _analysis_rate_hz(cfg.sample_rate_hz / (cfg.decimation < 1 ? 1 : cfg.decimation)),
+      _smoother(BiquadFilter::design_lowpass(cfg.sample_rate_hz, default_lowpass(cfg))),
+      _decimator(cfg.decimation, 8 * (cfg.decimation < 1 ? 1 : cfg.decimation) + 1), _spectrum(cfg.fft_size),
+      _ring(cfg.fft_size * 2, 0.0f)
+{
+}
+
+void PressureAnalyzer::reset()
+{
+    _smoother.reset();
+    _decimator.reset();
+    std::fill(_ring.begin(), _ring.end(), 0.0f);
+    _ring_pos = 0;
+    _filled = 0;
+    _since_last = 0;
+}
+
+bool PressureAnalyzer::push(uint32_t raw_pressure, PressureAnalysis& out)
+{
+    _last_filtered = _smoother.process(float(raw_pressure));
+
+    float decimated;
+    if(!_decimator.push(_last_filtered, decimated))
+        return false;
+
+    // Anel duplicado: [_ring_pos, _ring_pos + N) vai da mais antiga à mais nova
+    const size_t n = _spectrum.size();
+    _ring[_ring_pos] = decimated;
+    _ring[_ring_pos + n] = decimated;
+    _ring_pos = (_ring_pos + 1) % n;
+
+    if(_filled < n)
+        _filled++;
+    _since_last++;
+
+    // Janelas com 50% de sobreposição
+    if(_filled < n || _since_last < n / 2)
+        return false;
+    _since_last = 0;
+
+    const float* window = &_ring[_ring_pos];
+    size_t bin = _spectrum.analyze(window);
+
+    auto mm = std::minmax_element(window, window + n);
+    float mean = 0.0f;
+    for(size_t i = 0; i < n; i++)
+        mean += window[i];
+
+    out.filtered = _last_filtered;
+    out.mean = mean / n;
+    out.peak_to_peak = *mm.second - *mm.first;
+    out.dominant_hz = bin * _analysis_rate_hz / n;
+    out.dominant_power = _spectrum.power()[bin];
+    return true;
+}
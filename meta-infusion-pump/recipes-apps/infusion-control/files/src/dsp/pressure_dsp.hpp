@@ -0,0 +1,167 @@
+#ifndef PRESSURE_DSP_HPP
+#define PRESSURE_DSP_HPP
+
+#include "dsp_kernels.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// ============================================================
+// Blocos de processamento
+// ============================================================
+
+// FIR com histórico duplicado: a janela de N amostras é sempre contígua,
+// então cada saída é um único dot() vetorizado.
+class FirFilter
+{
+public:
+    explicit FirFilter(std::vector<float> taps);
+
+    float process(float x);
+    void process(const float* in, float* out, size_t n);
+    void reset();
+
+    // Passa-baixa por sinc janelado (Hamming). cutoff em fração de fs (0 < cutoff < 0.5)
+    static std::vector<float> design_lowpass(size_t num_taps, float cutoff);
+
+private:
+    friend class Decimator;
+
+    std::vector<float> _taps;
+    std::vector<float> _history; // 2 * N
+    size_t _pos = 0;
+
+    void _push(float x);
+    float _output() const;
+};
+
+// Biquad (Direct Form II transposta). IIR é recursivo amostra a amostra,
+// portanto roda em escalar em todos os caminhos.
+class BiquadFilter
+{
+public:
+    struct Coeffs
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    explicit BiquadFilter(const Coeffs& c) : _c(c) {}
+
+    float process(float x);
+    void process(const float* in, float* out, size_t n);
+    void reset();
+
+    // Passa-baixa RBJ (Audio EQ Cookbook)
+    static Coeffs design_lowpass(float sample_rate_hz, float cutoff_hz, float q = 0.7071f);
+
+private:
+    Coeffs _c;
+    float _z1 = 0.0f;
+    float _z2 = 0.0f;
+};
+
+// Decimação por M com FIR anti-aliasing: só calcula o dot() nas amostras que saem.
+class Decimator
+{
+public:
+    Decimator(unsigned factor, size_t num_taps);
+
+    // Retorna true quando uma amostra decimada foi produzida em 'out'
+    bool push(float x, float& out);
+    void reset();
+
+    unsigned factor() const
+    {
+        return _factor;
+    }
+
+private:
+    unsigned _factor;
+    unsigned _phase = 0;
+    FirFilter _fir;
+};
+
+// FFT radix-2 real (via complexa) com janela de Hann e espectro de potência.
+class SpectrumAnalyzer
+{
+public:
+    explicit SpectrumAnalyzer(size_t size); // size potência de 2, >= 8
+
+    // Analisa 'size' amostras; a média é removida antes do janelamento.
+    // Retorna o bin dominante (ignorando DC). Espectro disponível em power().
+    size_t analyze(const float* samples);
+
+    const std::vector<float>& power() const
+    {
+        return _power;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+private:
+    size_t _size;
+    std::vector<float> _window;
+    std::vector<uint32_t> _bitrev;
+    std::vector<float> _tw_re; // twiddles por estágio, concatenados (N - 1 valores)
+    std::vector<float> _tw_im;
+    std::vector<float> _re;
+    std::vector<float> _im;
+    std::vector<float> _scratch;
+    std::vector<float> _power; // N/2 + 1 bins
+
+    void _fft();
+};
+
+// ============================================================
+// Pipeline de pressão (alimentado pelo monitor_loop)
+// ============================================================
+
+struct PressureAnalysis
+{
+    float filtered;       // pressão após passa-baixa
+    float mean;           // média da janela analisada
+    float peak_to_peak;   // excursão na janela
+    float dominant_hz;    // frequência do ciclo da bomba
+    float dominant_power; // potência do bin dominante
+};
+
+class PressureAnalyzer
+{
+public:
+    struct Config
+    {
+        float sample_rate_hz = 1.0f;
+        unsigned decimation = 1;
+        size_t fft_size = 64;
+        float lowpass_hz = 0.0f; // 0 = 0.2 * taxa de amostragem
+    };
+
+    explicit PressureAnalyzer(const Config& cfg);
+
+    // Retorna true quando uma nova janela espectral foi concluída (a cada fft_size/2 amostras decimadas)
+    bool push(uint32_t raw_pressure, PressureAnalysis& out);
+    void reset();
+
+    float filtered() const
+    {
+        return _last_filtered;
+    }
+
+private:
+    Config _cfg;
+    float _analysis_rate_hz;
+    BiquadFilter _smoother;
+    Decimator _decimator;
+    SpectrumAnalyzer _spectrum;
+
+    std::vector<float> _ring; // 2 * fft_size (janela sempre contígua)
+    size_t _ring_pos = 0;
+    size_t _filled = 0;
+    size_t _since_last = 0;
+    float _last_filtered = 0.0f;
+};
+
+#endif
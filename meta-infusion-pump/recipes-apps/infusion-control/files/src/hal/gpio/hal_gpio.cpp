@@ -118,6 +118,13 @@ bool HalGpio::get() const
     return val == GPIOD_LINE_VALUE_ACTIVE;
 }
 
+int HalGpio::event_fd() const
+{
+    if(!_req || !_buffer)
+        return -1;
+    return gpiod_line_request_get_fd(_req);
+}
+
 HalGpio::Edge HalGpio::wait_for_edge(int timeout_ns)
 {
     if(!_req || !_buffer)
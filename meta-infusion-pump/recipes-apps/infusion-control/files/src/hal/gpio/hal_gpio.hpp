@@ -35,6 +35,10 @@ public:
 
     Edge wait_for_edge(int timeout_ns);
 
+    // FD de eventos de borda (pollable). -1 se o pino não está adquirido.
+    // O FD pertence à libgpiod: não fechar, e é invalidado por release().
+    int event_fd() const;
+
 private:
     // Configurações salvas (para poder fazer o acquire de volta)
     unsigned int _pin;
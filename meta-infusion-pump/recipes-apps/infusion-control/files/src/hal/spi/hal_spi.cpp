@@ -67,6 +67,21 @@ bool HalSpi::open_device()
     return true;
 }
 
+bool HalSpi::set_speed(uint32_t speed_hz)
+{
+    if(speed_hz == 0)
+        return false;
+
+    if(_fd >= 0 && ioctl(_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0)
+    {
+        std::cerr << "[SPI] Erro setando Speed" << std::endl;
+        return false;
+    }
+
+    _speed = speed_hz;
+    return true;
+}
+
 bool HalSpi::transfer(const uint8_t* tx_buf, uint8_t* rx_buf, size_t len)
 {
     if(_fd < 0)
@@ -12,6 +12,13 @@ public:
     ~HalSpi();
     bool transfer(const uint8_t* tx_buf, uint8_t* rx_buf, size_t len);
 
+    // Troca o clock das próximas transferências (ex.: OTA negociado)
+    bool set_speed(uint32_t speed_hz);
+    uint32_t speed() const
+    {
+        return _speed;
+    }
+
     void close_device();
     bool open_device();
 
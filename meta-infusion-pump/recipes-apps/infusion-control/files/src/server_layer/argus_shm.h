@@ -0,0 +1,239 @@
+#ifndef ARGUS_SHM_H
+#define ARGUS_SHM_H
+
+/*
+ * Feed de status em memória compartilhada (/dev/shm/argus-status)
+ *
+ * Para consumidores locais (ex.: display de beira de leito) lerem o status
+ * sem MQTT/TCP/JSON. O daemon é o único escritor; a região é mapeada uma vez
+ * e, em regime, a leitura não faz syscalls.
+ *
+ * Layout (um bloco por canal de bomba, ver device_registry.hpp):
+ *
+ *   argus_shm_header_t
+ *   argus_shm_channel_t[ARGUS_SHM_MAX_CHANNELS]
+ *     - latest: último status, protegido por seqlock (escritor nunca espera)
+ *     - ring:   eventos (mudança de estado, alarme) em fila SPSC; o leitor
+ *               mapeia RW para avançar 'tail'. Fila cheia = evento descartado
+ *               (contado em 'dropped'), o daemon nunca bloqueia no leitor.
+ *
+ * Uso mínimo (C99, GCC/Clang):
+ *
+ *   argus_shm_map_t map;
+ *   if(argus_shm_open(&map) == 0) {
+ *       argus_shm_status_t st;
+ *       argus_shm_read_status(map.region, 0, &st);
+ *
+ *       const argus_shm_event_t* ev;
+ *       while((ev = argus_shm_event_peek(map.region, 0)) != NULL) {
+ *           ... usa *ev direto na região (sem cópia) ...
+ *           argus_shm_event_pop(map.region, 0);
+ *       }
+ *   }
+ *
+ * Cada canal tem um único consumidor de eventos; 'latest' pode ser lido por
+ * qualquer número de processos.
+ *
+ * Permissão: a região é criada 0660 com o grupo ARGUS_SHM_GROUP; o consumidor
+ * precisa ser desse grupo (o mapeamento é RW por causa de 'tail').
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ARGUS_SHM_NAME         "/argus-status"
+#define ARGUS_SHM_GROUP        "argus-status"
+#define ARGUS_SHM_MAGIC        0x53475241u /* "ARGS" */
+#define ARGUS_SHM_VERSION      1
+#define ARGUS_SHM_MAX_CHANNELS 8
+#define ARGUS_SHM_EVENT_SLOTS  256 /* potência de 2 */
+#define ARGUS_SHM_ID_SIZE      16
+#define ARGUS_SHM_CACHE_LINE   64
+
+/* Alinhamento a linha de cache (C99 e C++ com GCC/Clang) */
+#define ARGUS_SHM_ALIGNED __attribute__((aligned(ARGUS_SHM_CACHE_LINE)))
+
+typedef enum argus_shm_event_type_e
+{
+    ARGUS_SHM_EVENT_STATE = 1,     /* value[0] = estado anterior, value[1] = novo */
+    ARGUS_SHM_EVENT_ALARM_ON = 2,  /* value[0] = estado atual */
+    ARGUS_SHM_EVENT_ALARM_OFF = 3, /* value[0] = estado atual */
+} argus_shm_event_type_t;
+
+/* Mesmo conteúdo do StatusSample do daemon */
+typedef struct argus_shm_status_s
+{
+    uint64_t timestamp_ms; /* relógio de parede (ms desde epoch) */
+    uint32_t volume;       /* ml infundidos */
+    uint32_t flow_rate;    /* ml/h configurado */
+    uint32_t pressure;     /* bruta */
+    uint32_t samples;      /* amostras publicadas desde o início */
+    uint8_t state;         /* estado bruto do firmware */
+    uint8_t alarm;
+    uint8_t reserved[6];
+} argus_shm_status_t;
+
+typedef struct argus_shm_event_s
+{
+    uint64_t timestamp_ms;
+    uint16_t type; /* argus_shm_event_type_t */
+    uint16_t reserved;
+    uint32_t value[3];
+} argus_shm_event_t;
+
+typedef struct argus_shm_channel_s
+{
+    /* Seqlock: ímpar = escrita em andamento */
+    uint32_t seq ARGUS_SHM_ALIGNED;
+    uint32_t active; /* 1 = canal configurado no daemon */
+    char id[ARGUS_SHM_ID_SIZE];
+    argus_shm_status_t latest;
+
+    /* Fila SPSC: head escrito pelo daemon, tail pelo consumidor */
+    uint32_t head ARGUS_SHM_ALIGNED;
+    uint32_t dropped;
+    uint32_t tail ARGUS_SHM_ALIGNED;
+    argus_shm_event_t ring[ARGUS_SHM_EVENT_SLOTS] ARGUS_SHM_ALIGNED;
+} argus_shm_channel_t;
+
+typedef struct argus_shm_header_s
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size; /* sizeof(argus_shm_region_t) do escritor */
+    uint32_t channel_count;
+    uint32_t writer_pid;
+} argus_shm_header_t;
+
+typedef struct argus_shm_region_s
+{
+    argus_shm_header_t header ARGUS_SHM_ALIGNED;
+    argus_shm_channel_t channels[ARGUS_SHM_MAX_CHANNELS];
+} argus_shm_region_t;
+
+/* ============================================================
+ * Leitura
+ * ============================================================ */
+
+/* Cópia consistente do último status (retorna 0, ou -1 se o canal não existe) */
+static inline int argus_shm_read_status(const argus_shm_region_t* region, unsigned channel, argus_shm_status_t* out)
+{
+    const argus_shm_channel_t* ch;
+    uint32_t s1, s2;
+
+    if(channel >= ARGUS_SHM_MAX_CHANNELS)
+        return -1;
+
+    ch = &region->channels[channel];
+    if(!__atomic_load_n(&ch->active, __ATOMIC_ACQUIRE))
+        return -1;
+
+    do
+    {
+        s1 = __atomic_load_n(&ch->seq, __ATOMIC_ACQUIRE);
+        if(s1 & 1u)
+            continue;
+
+        memcpy(out, (const void*)&ch->latest, sizeof(*out));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        s2 = __atomic_load_n(&ch->seq, __ATOMIC_RELAXED);
+    } while((s1 & 1u) || s1 != s2);
+
+    return 0;
+}
+
+/* Próximo evento, lido direto na região (NULL = fila vazia ou canal inexistente) */
+static inline const argus_shm_event_t* argus_shm_event_peek(const argus_shm_region_t* region, unsigned channel)
+{
+    const argus_shm_channel_t* ch;
+    uint32_t tail, head;
+
+    if(channel >= ARGUS_SHM_MAX_CHANNELS)
+        return NULL;
+
+    ch = &region->channels[channel];
+    tail = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+    head = __atomic_load_n(&ch->head, __ATOMIC_ACQUIRE);
+
+    if(tail == head)
+        return NULL;
+
+    return &ch->ring[tail & (ARGUS_SHM_EVENT_SLOTS - 1)];
+}
+
+/* Libera o slot devolvido por argus_shm_event_peek() (canal inexistente: nada) */
+static inline void argus_shm_event_pop(argus_shm_region_t* region, unsigned channel)
+{
+    argus_shm_channel_t* ch;
+    uint32_t tail;
+
+    if(channel >= ARGUS_SHM_MAX_CHANNELS)
+        return;
+
+    ch = &region->channels[channel];
+    tail = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+    __atomic_store_n(&ch->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* ============================================================
+ * Mapeamento (só na inicialização do leitor)
+ * ============================================================ */
+
+#if defined(__unix__) && !defined(ARGUS_SHM_NO_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+typedef struct argus_shm_map_s
+{
+    argus_shm_region_t* region;
+    int fd;
+} argus_shm_map_t;
+
+/* Retorna 0 em sucesso; -1 se o daemon não criou a região ou a versão difere */
+static inline int argus_shm_open(argus_shm_map_t* map)
+{
+    void* addr;
+
+    map->region = NULL;
+    map->fd = shm_open(ARGUS_SHM_NAME, O_RDWR, 0);
+    if(map->fd < 0)
+        return -1;
+
+    addr = mmap(NULL, sizeof(argus_shm_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, map->fd, 0);
+    if(addr == MAP_FAILED)
+    {
+        close(map->fd);
+        map->fd = -1;
+        return -1;
+    }
+
+    map->region = (argus_shm_region_t*)addr;
+
+    if(__atomic_load_n(&map->region->header.magic, __ATOMIC_ACQUIRE) != ARGUS_SHM_MAGIC ||
+       map->region->header.version != ARGUS_SHM_VERSION || map->region->header.size != sizeof(argus_shm_region_t))
+    {
+        munmap(addr, sizeof(argus_shm_region_t));
+        close(map->fd);
+        map->region = NULL;
+        map->fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+static inline void argus_shm_close(argus_shm_map_t* map)
+{
+    if(map->region)
+        munmap(map->region, sizeof(argus_shm_region_t));
+    if(map->fd >= 0)
+        close(map->fd);
+    map->region = NULL;
+    map->fd = -1;
+}
+#endif
+
+#endif
@@ -0,0 +1,250 @@
+#ifndef COMMAND_DISPATCH_HPP
+#define COMMAND_DISPATCH_HPP
+
+#include <boost/json.hpp>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// ============================================================
+// Ações do tópico de comando
+// ============================================================
+//
+// O nome da ação é resolvido por hash perfeito calculado em tempo de
+// compilação: FNV-1a com finalizador e uma semente escolhida pelo próprio
+// compilador de forma que nenhum par de nomes colida na tabela. A busca
+// custa um hash e uma única comparação de string (rejeita desconhecidos).
+
+enum class CommandAction : uint8_t
+{
+    Start,
+    Pause,
+    Stop,
+    Config,
+    Purge,
+    Bolus,
+    UpdateFirmware,
+    ResetMcu,
+    CancelOta,
+    ResumeOta,
+    FirmwareUploadBegin,
+    FirmwareUploadEnd,
+    Count,
+    Unknown = 0xFF,
+};
+
+struct ActionName
+{
+    std::string_view name;
+    CommandAction action;
+};
+
+static constexpr ActionName ACTION_NAMES[] = {
+    {"start", CommandAction::Start},
+    {"pause", CommandAction::Pause},
+    {"stop", CommandAction::Stop},
+    {"abort", CommandAction::Stop},
+    {"config", CommandAction::Config},
+    {"purge", CommandAction::Purge},
+    {"bolus", CommandAction::Bolus},
+    {"update_firmware", CommandAction::UpdateFirmware},
+    {"reset_mcu", CommandAction::ResetMcu},
+    {"cancel_ota", CommandAction::CancelOta},
+    {"resume_ota", CommandAction::ResumeOta},
+    {"fw_upload_begin", CommandAction::FirmwareUploadBegin},
+    {"fw_upload_end", CommandAction::FirmwareUploadEnd},
+};
+
+static constexpr size_t ACTION_NAMES_COUNT = sizeof(ACTION_NAMES) / sizeof(ACTION_NAMES[0]);
+
+// Potência de 2 >= número de nomes
+static constexpr size_t ACTION_TABLE_SIZE = 16;
+static_assert(ACTION_TABLE_SIZE >= ACTION_NAMES_COUNT, "Tabela de ações pequena demais");
+
+constexpr uint32_t action_hash(std::string_view name, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ seed;
+    for(char c : name)
+    {
+        h ^= static_cast<uint8_t>(c);
+        h *= 16777619u;
+    }
+
+    // Finalizador (fmix32): o FNV puro só mistura para cima e os bits baixos,
+    // que indexam a tabela, dependeriam só dos bits baixos da semente.
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+constexpr bool action_seed_is_perfect(uint32_t seed)
+{
+    bool used[ACTION_TABLE_SIZE] = {};
+    for(const auto& entry : ACTION_NAMES)
+    {
+        size_t slot = action_hash(entry.name, seed) & (ACTION_TABLE_SIZE - 1);
+        if(used[slot])
+            return false;
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t find_action_seed()
+{
+    for(uint32_t seed = 0; seed < 100000; seed++)
+    {
+        if(action_seed_is_perfect(seed))
+            return seed;
+    }
+    return UINT32_MAX;
+}
+
+static constexpr uint32_t ACTION_SEED = find_action_seed();
+static_assert(ACTION_SEED != UINT32_MAX, "Sem semente de hash perfeito para as ações");
+
+// Slot -> índice em ACTION_NAMES (-1 = vazio)
+constexpr std::array<int8_t, ACTION_TABLE_SIZE> build_action_slots()
+{
+    std::array<int8_t, ACTION_TABLE_SIZE> slots{};
+    for(auto& slot : slots)
+        slot = -1;
+    for(size_t i = 0; i < ACTION_NAMES_COUNT; i++)
+        slots[action_hash(ACTION_NAMES[i].name, ACTION_SEED) & (ACTION_TABLE_SIZE - 1)] = static_cast<int8_t>(i);
+    return slots;
+}
+
+static constexpr std::array<int8_t, ACTION_TABLE_SIZE> ACTION_SLOTS = build_action_slots();
+
+constexpr CommandAction lookup_action(std::string_view name)
+{
+    int8_t idx = ACTION_SLOTS[action_hash(name, ACTION_SEED) & (ACTION_TABLE_SIZE - 1)];
+    if(idx < 0 || ACTION_NAMES[idx].name != name)
+        return CommandAction::Unknown;
+    return ACTION_NAMES[idx].action;
+}
+
+// Nome canônico (primeira entrada da tabela) para logs e respostas
+constexpr std::string_view action_name(CommandAction action)
+{
+    for(const auto& entry : ACTION_NAMES)
+    {
+        if(entry.action == action)
+            return entry.name;
+    }
+    return "unknown";
+}
+
+// Ações de estado absoluto, em que só o último pedido importa: podem ser
+// coalescidas na fila do executor (ver command_executor.hpp)
+constexpr bool action_coalesces(CommandAction action)
+{
+    return action == CommandAction::Config;
+}
+
+// Parada da bomba: faixa própria no executor, nunca recusada nem atrás de
+// outros comandos (ver CommandExecutor::submit_stop)
+constexpr bool action_is_stop(CommandAction action)
+{
+    return action == CommandAction::Stop;
+}
+
+static_assert(lookup_action("abort") == CommandAction::Stop, "Hash perfeito inconsistente");
+static_assert(lookup_action("update_firmware") == CommandAction::UpdateFirmware, "Hash perfeito inconsistente");
+static_assert(lookup_action("bogus") == CommandAction::Unknown, "Hash perfeito inconsistente");
+
+// ============================================================
+// Extração tipada de campos
+// ============================================================
+
+enum class FieldResult
+{
+    Ok,
+    Missing,
+    WrongType,
+    OutOfRange,
+};
+
+// Inteiro sem sinal em [min, max]. Campo ausente usa 'fallback' quando não obrigatório.
+inline FieldResult get_u32_field(const boost::json::object& obj, std::string_view key, uint32_t min, uint32_t max,
+                                 uint32_t& out, bool required, uint32_t fallback = 0)
+{
+    const boost::json::value* v = obj.if_contains(key);
+    if(!v)
+    {
+        if(required)
+            return FieldResult::Missing;
+        out = fallback;
+        return FieldResult::Ok;
+    }
+
+    int64_t n;
+    if(const int64_t* i = v->if_int64())
+        n = *i;
+    else if(const uint64_t* u = v->if_uint64())
+        n = (*u > uint64_t(INT64_MAX)) ? INT64_MAX : int64_t(*u);
+    else
+        return FieldResult::WrongType;
+
+    if(n < int64_t(min) || n > int64_t(max))
+        return FieldResult::OutOfRange;
+
+    out = static_cast<uint32_t>(n);
+    return FieldResult::Ok;
+}
+
+// Inteiro sem sinal de 64 bits (ex.: timestamps em ms)
+inline FieldResult get_u64_field(const boost::json::object& obj, std::string_view key, uint64_t& out)
+{
+    const boost::json::value* v = obj.if_contains(key);
+    if(!v)
+        return FieldResult::Missing;
+
+    if(const uint64_t* u = v->if_uint64())
+        out = *u;
+    else if(const int64_t* i = v->if_int64())
+    {
+        if(*i < 0)
+            return FieldResult::OutOfRange;
+        out = uint64_t(*i);
+    }
+    else
+        return FieldResult::WrongType;
+
+    return FieldResult::Ok;
+}
+
+inline FieldResult get_string_field(const boost::json::object& obj, std::string_view key, std::string_view& out)
+{
+    const boost::json::value* v = obj.if_contains(key);
+    if(!v)
+        return FieldResult::Missing;
+
+    const boost::json::string* s = v->if_string();
+    if(!s)
+        return FieldResult::WrongType;
+
+    out = std::string_view(s->data(), s->size());
+    return FieldResult::Ok;
+}
+
+inline const char* field_result_name(FieldResult r)
+{
+    switch(r)
+    {
+    case FieldResult::Ok:
+        return "ok";
+    case FieldResult::Missing:
+        return "ausente";
+    case FieldResult::WrongType:
+        return "tipo invalido";
+    case FieldResult::OutOfRange:
+        return "fora da faixa";
+    }
+    return "?";
+}
+
+#endif
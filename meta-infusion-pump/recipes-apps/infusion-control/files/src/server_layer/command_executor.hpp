@@ -0,0 +1,278 @@
+#ifndef COMMAND_EXECUTOR_HPP
+#define COMMAND_EXECUTOR_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include "infusion_manager.hpp"
+
+// ============================================================
+// Executor de comandos
+// ============================================================
+//
+// Os comandos do MQTT chegam na thread do io_context, mas executá-los ali
+// bloquearia rede e watchdog enquanto o STM32 responde (_safe_transfer pode
+// esperar segundos). O executor roda os comandos numa thread dedicada, com
+// fila limitada, e devolve o resultado ao io_context via post().
+//
+// Coalescência: um job submetido com chave != 0 substitui o último da fila
+// quando ele tem a mesma chave (último vence). Só a cauda: com "config A,
+// start, config B" o B não pode passar na frente do start, então entra no
+// fim como qualquer job. Uma rajada de config após reconexão vira uma única
+// transação SPI; o job substituído termina com CMD_HUB_SUPERSEDED sem tocar
+// no barramento.
+//
+// Faixa de parada (submit_stop): stop/abort nunca é recusado por fila cheia
+// e é o próximo a executar. Os jobs comuns ainda na fila foram pedidos antes
+// da parada e não podem rodar depois dela (um start enfileirado religaria a
+// bomba): terminam com CMD_HUB_SUPERSEDED. O job que já está executando não
+// é interrompido; a parada roda assim que ele devolve o SPI.
+
+// Convenções locais (acima dos códigos do firmware)
+static constexpr CommandStatus CMD_HUB_OVERLOAD = 0xFE;   // fila cheia
+static constexpr CommandStatus CMD_HUB_SUPERSEDED = 0xFD; // substituído por um mais novo na fila
+static constexpr CommandStatus CMD_HUB_STALE = 0xFC;      // descartado na entrada por idade (ts)
+
+struct CommandTiming
+{
+    std::chrono::microseconds queue_wait{0}; // submit -> início da execução
+    std::chrono::microseconds exec{0};       // duração do job (SPI + lock)
+    std::chrono::microseconds spi{0};        // round trip SPI medido pelo manager (0 = sem SPI)
+};
+
+struct ExecutorMetrics
+{
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;  // overload (fila cheia)
+    uint64_t coalesced = 0; // substituídos na fila (mesma chave)
+    uint64_t stops = 0;     // submetidos pela faixa de parada
+    uint64_t flushed = 0;   // descartados da fila por uma parada
+    size_t queue_depth = 0;
+    size_t high_watermark = 0;
+    std::chrono::microseconds max_queue_wait{0};
+    std::chrono::microseconds max_exec{0};
+};
+
+class CommandExecutor
+{
+public:
+    using Job = std::function<CommandStatus()>;
+    using Completion = std::function<void(CommandStatus, const CommandTiming&)>;
+
+    // Lida na thread do executor logo após cada job (ver InfusionManager::take_command_rtt)
+    using SpiTimer = std::function<std::chrono::microseconds()>;
+
+    // 0 = job comum (nunca coalesce)
+    using CoalesceKey = uint32_t;
+
+    CommandExecutor(boost::asio::io_context& io, size_t capacity) : _io(io), _capacity(capacity) {}
+
+    ~CommandExecutor()
+    {
+        stop();
+    }
+
+    // Deve ser configurado antes de start()
+    void set_spi_timer(SpiTimer timer)
+    {
+        _spi_timer = std::move(timer);
+    }
+
+    void start()
+    {
+        if(_running)
+            return;
+
+        _running = true;
+        _worker = std::thread(&CommandExecutor::worker_loop, this);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _running = false;
+        }
+        _cv.notify_all();
+
+        if(_worker.joinable())
+            _worker.join();
+    }
+
+    // Retorna false quando a fila está cheia (backpressure). Nesse caso
+    // 'done' não é chamado e quem submeteu decide como sinalizar a recusa.
+    // Substituir um job já enfileirado nunca é recusado.
+    bool submit(Job job, Completion done, CoalesceKey key = 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if(!_running)
+            {
+                _metrics.rejected++;
+                return false;
+            }
+
+            if(key != 0 && !_queue.empty() && _queue.back().key == key)
+            {
+                Entry& entry = _queue.back();
+                if(entry.done)
+                {
+                    CommandTiming timing;
+                    timing.queue_wait = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - entry.enqueued);
+                    boost::asio::post(_io, [done = std::move(entry.done), timing]() {
+                        done(CMD_HUB_SUPERSEDED, timing);
+                    });
+                }
+
+                entry.job = std::move(job);
+                entry.done = std::move(done);
+                _metrics.submitted++;
+                _metrics.coalesced++;
+                return true;
+            }
+
+            if(_queue.size() >= _capacity)
+            {
+                _metrics.rejected++;
+                return false;
+            }
+
+            _queue.push_back(Entry{std::move(job), std::move(done), std::chrono::steady_clock::now(), key});
+            _metrics.submitted++;
+            _metrics.queue_depth = _stops.size() + _queue.size();
+            if(_queue.size() > _metrics.high_watermark)
+                _metrics.high_watermark = _queue.size();
+        }
+
+        _cv.notify_one();
+        return true;
+    }
+
+    // Parada: fura a fila e ignora a capacidade (só falha com o executor parado)
+    bool submit_stop(Job job, Completion done)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if(!_running)
+            {
+                _metrics.rejected++;
+                return false;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            for(auto& entry : _queue)
+            {
+                _metrics.flushed++;
+                if(!entry.done)
+                    continue;
+
+                CommandTiming timing;
+                timing.queue_wait = std::chrono::duration_cast<std::chrono::microseconds>(now - entry.enqueued);
+                boost::asio::post(_io, [done = std::move(entry.done), timing]() { done(CMD_HUB_SUPERSEDED, timing); });
+            }
+            _queue.clear();
+
+            _stops.push_back(Entry{std::move(job), std::move(done), now, 0});
+            _metrics.submitted++;
+            _metrics.stops++;
+            _metrics.queue_depth = _stops.size();
+        }
+
+        _cv.notify_one();
+        return true;
+    }
+
+    ExecutorMetrics metrics() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _metrics;
+    }
+
+private:
+    struct Entry
+    {
+        Job job;
+        Completion done;
+        std::chrono::steady_clock::time_point enqueued;
+        CoalesceKey key = 0;
+    };
+
+    boost::asio::io_context& _io;
+    const size_t _capacity;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<Entry> _queue;
+    std::deque<Entry> _stops; // faixa de parada, sempre atendida antes de _queue
+    ExecutorMetrics _metrics;
+
+    bool _running = false;
+    std::thread _worker;
+    SpiTimer _spi_timer;
+
+    void worker_loop()
+    {
+        for(;;)
+        {
+            Entry entry;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait(lock, [this] { return !_running || !_stops.empty() || !_queue.empty(); });
+
+                if(!_running)
+                    return;
+
+                std::deque<Entry>& lane = _stops.empty() ? _queue : _stops;
+                entry = std::move(lane.front());
+                lane.pop_front();
+                _metrics.queue_depth = _stops.size() + _queue.size();
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            CommandStatus status = CMD_TRANSPORT_ERROR;
+
+            try
+            {
+                status = entry.job();
+            }
+            catch(const std::exception& e)
+            {
+                std::cerr << "[EXEC] Erro no comando: " << e.what() << "\n";
+            }
+
+            auto finished = std::chrono::steady_clock::now();
+
+            CommandTiming timing;
+            timing.queue_wait = std::chrono::duration_cast<std::chrono::microseconds>(started - entry.enqueued);
+            timing.exec = std::chrono::duration_cast<std::chrono::microseconds>(finished - started);
+            if(_spi_timer)
+                timing.spi = _spi_timer();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _metrics.completed++;
+                if(timing.queue_wait > _metrics.max_queue_wait)
+                    _metrics.max_queue_wait = timing.queue_wait;
+                if(timing.exec > _metrics.max_exec)
+                    _metrics.max_exec = timing.exec;
+            }
+
+            if(entry.done)
+            {
+                boost::asio::post(_io, [done = std::move(entry.done), status, timing]() { done(status, timing); });
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef LINK_MONITOR_HPP
+#define LINK_MONITOR_HPP
+
+#include <algorithm>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+
+// ============================================================
+// Detecção de queda do broker
+// ============================================================
+//
+// O mqtt5 reconecta sozinho e não expõe o estado da conexão; publishes
+// QoS 0 durante a queda simplesmente se perdem. O monitor mantém um probe
+// QoS 1 em voo: PUBACK dentro do prazo = online; probe parado além do prazo
+// (ou erro de publish reportado) = offline. Offline, o probe continua em voo
+// e o mqtt5 o reenvia ao reconectar, então o PUBACK marca a volta do link.
+//
+// Métricas de queda: tempo até reconectar (do último PUBACK antes da queda
+// até o primeiro depois dela) e tempo até o primeiro comando recebido após
+// a volta do link.
+//
+// Só acessado na thread do io_context.
+
+struct LinkTiming
+{
+    std::chrono::milliseconds interval_online{2000};  // probe com link ok
+    std::chrono::milliseconds interval_offline{250}; // probe durante a queda (base do backoff)
+    std::chrono::milliseconds offline_max{800};       // teto do backoff (sub-segundo)
+    std::chrono::milliseconds timeout{3000};          // PUBACK além disso = offline
+};
+
+struct LinkMetrics
+{
+    uint64_t flaps = 0;
+    std::chrono::milliseconds last_reconnect{0};
+    std::chrono::milliseconds max_reconnect{0};
+    std::chrono::milliseconds last_first_command{0};
+};
+
+// Backoff exponencial com jitter: sorteia entre metade e o teto da tentativa,
+// para que várias bombas não reconectem em sincronia
+class JitteredBackoff
+{
+public:
+    JitteredBackoff(std::chrono::milliseconds base, std::chrono::milliseconds max)
+        : _base(base), _max(max), _rng(std::random_device{}())
+    {
+    }
+
+    std::chrono::milliseconds next()
+    {
+        auto ceiling = _base * (1 << std::min(_attempt, 8u));
+        if(ceiling > _max)
+            ceiling = _max;
+        _attempt++;
+
+        std::uniform_int_distribution<long> jitter(ceiling.count() / 2, ceiling.count());
+        return std::chrono::milliseconds(jitter(_rng));
+    }
+
+    void reset()
+    {
+        _attempt = 0;
+    }
+
+private:
+    std::chrono::milliseconds _base;
+    std::chrono::milliseconds _max;
+    unsigned _attempt = 0;
+    std::minstd_rand _rng;
+};
+
+class LinkMonitor
+{
+public:
+    using ProbeDone = std::function<void(bool ok)>;
+    using ProbeFn = std::function<void(ProbeDone)>;
+    using StateFn = std::function<void(bool online)>;
+
+    LinkMonitor(boost::asio::io_context& io, ProbeFn probe, StateFn on_change, LinkTiming timing = LinkTiming{})
+        : _tick(io), _deadline(io), _probe(std::move(probe)), _on_change(std::move(on_change)), _timing(timing),
+          _offline_backoff(timing.interval_offline, timing.offline_max)
+    {
+    }
+
+    void start()
+    {
+        send_probe();
+    }
+
+    bool online() const
+    {
+        return _online;
+    }
+
+    // Erro de um publish qualquer: não espera o prazo do probe
+    void report_error()
+    {
+        set_online(false);
+    }
+
+    // Chamado a cada comando recebido (mede o primeiro após a reconexão)
+    void note_command()
+    {
+        if(!_awaiting_first_command)
+            return;
+
+        _awaiting_first_command = false;
+        _metrics.last_first_command =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _up_since);
+        std::cout << "[LINK] Primeiro comando " << _metrics.last_first_command.count() << " ms após reconectar\n";
+    }
+
+    const LinkMetrics& metrics() const
+    {
+        return _metrics;
+    }
+
+private:
+    boost::asio::steady_timer _tick;
+    boost::asio::steady_timer _deadline;
+    ProbeFn _probe;
+    StateFn _on_change;
+    LinkTiming _timing;
+
+    JitteredBackoff _offline_backoff;
+
+    bool _online = false; // só vira online após o primeiro PUBACK
+    bool _in_flight = false;
+    unsigned _generation = 0;
+
+    // Instrumentação
+    LinkMetrics _metrics;
+    bool _had_link = false; // já esteve online (distingue conexão inicial de reconexão)
+    bool _awaiting_first_command = false;
+    std::chrono::steady_clock::time_point _last_ack;
+    std::chrono::steady_clock::time_point _up_since;
+
+    void send_probe()
+    {
+        if(_in_flight)
+        {
+            schedule_next();
+            return;
+        }
+
+        _in_flight = true;
+        unsigned gen = ++_generation;
+
+        _deadline.expires_after(_timing.timeout);
+        _deadline.async_wait([this, gen](boost::system::error_code ec) {
+            if(!ec && gen == _generation && _in_flight)
+                set_online(false);
+        });
+
+        _probe([this, gen](bool ok) {
+            if(gen != _generation)
+                return;
+
+            _in_flight = false;
+            _deadline.cancel();
+            set_online(ok);
+            if(ok)
+                _last_ack = std::chrono::steady_clock::now();
+            schedule_next();
+        });
+    }
+
+    void schedule_next()
+    {
+        _tick.expires_after(_online ? _timing.interval_online : _offline_backoff.next());
+        _tick.async_wait([this](boost::system::error_code ec) {
+            if(!ec)
+                send_probe();
+        });
+    }
+
+    void set_online(bool online)
+    {
+        if(online == _online)
+            return;
+
+        _online = online;
+
+        if(!online)
+        {
+            std::cout << "[LINK] Broker offline\n";
+            _offline_backoff.reset();
+            _awaiting_first_command = false;
+        }
+        else if(_had_link)
+        {
+            auto now = std::chrono::steady_clock::now();
+            _metrics.flaps++;
+            _metrics.last_reconnect = std::chrono::duration_cast<std::chrono::milliseconds>(now - _last_ack);
+            if(_metrics.last_reconnect > _metrics.max_reconnect)
+                _metrics.max_reconnect = _metrics.last_reconnect;
+
+            _up_since = now;
+            _awaiting_first_command = true;
+
+            std::cout << "[LINK] Broker online: reconectado em " << _metrics.last_reconnect.count() << " ms (max "
+                      << _metrics.max_reconnect.count() << " ms, quedas " << _metrics.flaps << ")\n";
+        }
+        else
+        {
+            _had_link = true;
+            std::cout << "[LINK] Broker online\n";
+        }
+
+        if(_on_change)
+            _on_change(online);
+    }
+};
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef LOCAL_STREAM_HPP
+#define LOCAL_STREAM_HPP
+
+#include <boost/asio.hpp>
+#include <string>
+#include <utility>
+
+// ============================================================
+// Transporte MQTT por unix socket (broker local)
+// ============================================================
+//
+// O mosquitto roda na mesma placa; o listener unix evita a pilha TCP/IP
+// de loopback em todo publish. O boost::mqtt5 só sabe conectar streams
+// "tipo TCP" (resolve host/porta e chama async_connect com tcp::endpoint),
+// então este adaptador expõe a mesma interface de camada mais baixa e
+// ignora o endpoint resolvido: conecta sempre no caminho configurado.
+// As opções de socket TCP (no_delay, reuse_address) não têm efeito aqui.
+
+static constexpr const char* BROKER_SOCKET_PATH = "/run/mosquitto/mosquitto.sock";
+
+class LocalBrokerStream
+{
+public:
+    using protocol_type = boost::asio::local::stream_protocol;
+    using executor_type = boost::asio::any_io_executor;
+    using lowest_layer_type = LocalBrokerStream;
+
+    template <class ExecutorOrContext>
+    explicit LocalBrokerStream(ExecutorOrContext&& ex) : _socket(std::forward<ExecutorOrContext>(ex))
+    {
+    }
+
+    // Caminho do socket do broker (configurar antes de iniciar o cliente)
+    static void set_path(std::string path)
+    {
+        socket_path() = std::move(path);
+    }
+
+    static const std::string& path()
+    {
+        return socket_path();
+    }
+
+    executor_type get_executor() noexcept
+    {
+        return _socket.get_executor();
+    }
+
+    lowest_layer_type& lowest_layer() noexcept
+    {
+        return *this;
+    }
+
+    // --------------------------------------------------------
+    // Interface de socket usada pelo mqtt5 na (re)conexão
+    // --------------------------------------------------------
+
+    void open(const boost::asio::ip::tcp&, boost::system::error_code& ec)
+    {
+        _socket.open(protocol_type(), ec);
+    }
+
+    template <class Option>
+    void set_option(const Option&, boost::system::error_code& ec)
+    {
+        ec = {};
+    }
+
+    bool is_open() const
+    {
+        return _socket.is_open();
+    }
+
+    void close(boost::system::error_code& ec)
+    {
+        _socket.close(ec);
+    }
+
+    void close()
+    {
+        boost::system::error_code ec;
+        _socket.close(ec);
+    }
+
+    void cancel(boost::system::error_code& ec)
+    {
+        _socket.cancel(ec);
+    }
+
+    void shutdown(boost::asio::socket_base::shutdown_type what, boost::system::error_code& ec)
+    {
+        _socket.shutdown(what, ec);
+    }
+
+    template <class ConnectToken>
+    auto async_connect(const boost::asio::ip::tcp::endpoint&, ConnectToken&& token)
+    {
+        return _socket.async_connect(protocol_type::endpoint(path()), std::forward<ConnectToken>(token));
+    }
+
+    // --------------------------------------------------------
+    // AsyncReadStream / AsyncWriteStream
+    // --------------------------------------------------------
+
+    template <class MutableBuffers, class ReadToken>
+    auto async_read_some(const MutableBuffers& buffers, ReadToken&& token)
+    {
+        return _socket.async_read_some(buffers, std::forward<ReadToken>(token));
+    }
+
+    template <class ConstBuffers, class WriteToken>
+    auto async_write_some(const ConstBuffers& buffers, WriteToken&& token)
+    {
+        return _socket.async_write_some(buffers, std::forward<WriteToken>(token));
+    }
+
+private:
+    protocol_type::socket _socket;
+
+    static std::string& socket_path()
+    {
+        static std::string path = BROKER_SOCKET_PATH;
+        return path;
+    }
+};
+
+#endif
@@ -7,10 +7,21 @@
 #include <boost/mqtt5/reason_codes.hpp>
 #include <boost/json.hpp>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "infusion_manager.hpp"
+#include "command_executor.hpp"
+#include "status_codec.hpp"
+#include "command_dispatch.hpp"
+#include "publish_batcher.hpp"
+#include "local_stream.hpp"
+#include "link_monitor.hpp"
+#include "telemetry_spool.hpp"
+#include "status_streams.hpp"
+#include "firmware_staging.hpp"
 
 // ============================================================
 // Configurações MQTT
@@ -18,34 +29,171 @@
 
 const std::string BROKER_ADDR = "127.0.0.1";
 const uint16_t BROKER_PORT = 1883;
+
+// Sessão persistente: o broker guarda a inscrição (e os QoS 1 pendentes)
+// por este tempo após uma queda. O mqtt5 reconecta com Clean Start = 0,
+// então só há re-subscribe quando o broker perdeu a sessão (session_expired).
+const uint32_t SESSION_EXPIRY_INTERVAL_S = 600;
 const std::string CLIENT_ID = "infusion_pump_rpi";
 
 const std::string TOPIC_CMD = "bomba/comando";
 const std::string TOPIC_STATUS = "bomba/status";
+const std::string TOPIC_PRESSURE = "bomba/pressao";
+
+// Multi-bomba: cada canal com id usa bomba/<id>/comando, bomba/<id>/status, ...
+const std::string TOPIC_ROOT = "bomba";
 
+// Vazão de purge (padrão e teto). Os demais volumes/vazões só têm o tipo
+// conferido no HUB (u32): a faixa clínica é do firmware, que responde
+// CMD_ERR_PARAM_RANGE.
 const uint32_t MAX_PURGE_RATE = 1200; // ml/h
 
+// Arena do DOM dos comandos JSON (mensagens maiores são recusadas com PARAM_RANGE)
+const size_t COMMAND_JSON_ARENA = 2048;
+
+// Fila do executor de comandos: acima disso o HUB recusa (overload)
+const size_t COMMAND_QUEUE_DEPTH = 8;
+
+// Idade máxima de um comando com "ts" (ms desde epoch) antes de ser
+// descartado na entrada. Com sessão persistente e QoS 1, o broker reentrega
+// o backlog acumulado durante a queda; comandos sem "ts" seguem valendo
+// (publishers MQTT5 devem usar message-expiry-interval, que o broker aplica).
+const std::chrono::milliseconds COMMAND_MAX_AGE{10000};
+
+// Replay do spool após queda do broker: lotes QoS 1 espaçados, um em voo
+// por vez, para não competir com o tráfego ao vivo
+const size_t REPLAY_BATCH = 64;                       // amostras por publish
+const std::chrono::milliseconds REPLAY_INTERVAL{100}; // entre lotes
+
+// fw_upload_end que chega antes do último chunk (tópicos diferentes não têm
+// ordem entre si) espera os chunks que faltam até este limite
+const std::chrono::milliseconds UPLOAD_END_WAIT{5000};
+
+// ============================================================
+// Configuração por canal
+// ============================================================
+
+struct MqttClientConfig
+{
+    std::string channel; // vazio = tópicos legados (bomba/comando, ...)
+    StatusEncoding status_encoding = StatusEncoding::Json;
+    BatchPolicy status_batch;
+    BatchPolicy pressure_batch;
+
+    // Streams adicionais de status (bomba/status/<sufixo>), ver status_streams.hpp
+    std::vector<StatusStreamSpec> status_streams;
+
+    // Store-and-forward do status (vazio ou 0 registros = desativado).
+    // Com canal, o arquivo recebe o sufixo ".<canal>".
+    std::string spool_path;
+    uint32_t spool_records = 0;
+
+    // 0 = não descarta por idade
+    std::chrono::milliseconds command_max_age = COMMAND_MAX_AGE;
+
+    // Upload da imagem pelo MQTT (vazio = desativado). Com canal, sufixo ".<canal>".
+    std::string firmware_staging = FIRMWARE_STAGING_PATH;
+};
+
+struct MqttTopics
+{
+    std::string client_id;
+    std::string cmd;
+    std::string status;
+    std::string pressure;
+    std::string status_replay; // amostras do spool (sempre em lote, com ts)
+    std::string link;          // probe QoS 1 do LinkMonitor
+    std::string ota;           // andamento do OTA (ver publish_ota)
+    std::string firmware;      // chunks do upload da imagem (ver on_firmware_chunk)
+
+    static MqttTopics for_channel(const std::string& channel)
+    {
+        if(channel.empty())
+            return MqttTopics{CLIENT_ID, TOPIC_CMD, TOPIC_STATUS, TOPIC_PRESSURE, TOPIC_STATUS + "/replay",
+                              TOPIC_ROOT + "/link", TOPIC_ROOT + "/ota", TOPIC_ROOT + "/firmware"};
+
+        const std::string base = TOPIC_ROOT + "/" + channel + "/";
+        return MqttTopics{CLIENT_ID + "_" + channel,
+                          base + "comando",
+                          base + "status",
+                          base + "pressao",
+                          base + "status/replay",
+                          base + "link",
+                          base + "ota",
+                          base + "firmware"};
+    }
+};
+
 // ============================================================
 // Classe
 // ============================================================
+//
+// Parametrizada pelo stream do transporte: TCP (padrão) ou unix socket
+// para o mosquitto local (ver local_stream.hpp e os aliases no fim).
 
-class MqttClient
+template <class Stream>
+class BasicMqttClient
 {
 public:
-    using client_type = boost::mqtt5::mqtt_client<boost::asio::ip::tcp::socket>;
+    using client_type = boost::mqtt5::mqtt_client<Stream>;
 
-    MqttClient(boost::asio::io_context& io, InfusionManager& manager)
-        : _io(io), _client(io), _manager(manager), _retry_timer(io)
+    BasicMqttClient(boost::asio::io_context& io, InfusionManager& manager,
+                    const MqttClientConfig& config = MqttClientConfig{})
+        : _io(io), _client(io), _manager(manager), _retry_timer(io), _executor(io, COMMAND_QUEUE_DEPTH),
+          _topics(MqttTopics::for_channel(config.channel)), _status_encoding(config.status_encoding),
+          _command_max_age(config.command_max_age),
+          _status_batcher(io, config.status_batch, [this](const std::vector<StatusSample>& batch) { publish_status(batch); },
+                          [](const StatusSample& prev, const StatusSample& cur) {
+                              return cur.state != prev.state || cur.alarm != prev.alarm;
+                          }),
+          _pressure_batcher(io, config.pressure_batch,
+                            [this](const std::vector<PressureAnalysis>& batch) { publish_pressure(batch); }),
+          _json_parser(boost::json::storage_ptr(), json_parse_options(), _json_parse_stack, sizeof(_json_parse_stack)),
+          _link(io, [this](LinkMonitor::ProbeDone done) { send_link_probe(std::move(done)); },
+                [this](bool online) { on_link_change(online); }),
+          _replay_timer(io), _upload_end_timer(io)
     {
+        if(!config.spool_path.empty() && config.spool_records > 0)
+        {
+            std::string path = config.spool_path;
+            if(!config.channel.empty())
+                path += "." + config.channel;
+            _spool.open(path, config.spool_records);
+        }
+
+        if(!config.firmware_staging.empty())
+        {
+            std::string path = config.firmware_staging;
+            if(!config.channel.empty())
+                path += "." + config.channel;
+            _staging = std::make_unique<FirmwareStaging>(path);
+        }
+
+        for(const auto& spec : config.status_streams)
+        {
+            _streams.push_back(std::make_unique<StatusStream>(
+                io, spec, _topics.status + "/" + spec.suffix,
+                [this](const StatusStream& stream, const std::vector<StatusSample>& batch) {
+                    publish_stream(stream, batch);
+                }));
+        }
+
         setup_manager_callbacks();
     }
 
     void start()
     {
-        _client.brokers(BROKER_ADDR, BROKER_PORT).credentials(CLIENT_ID).async_run(boost::asio::detached);
+        _executor.set_spi_timer([this] { return _manager.take_command_rtt(); });
+        _executor.start();
+
+        _client.brokers(BROKER_ADDR, BROKER_PORT)
+            .credentials(_topics.client_id)
+            .connect_property(boost::mqtt5::prop::session_expiry_interval, SESSION_EXPIRY_INTERVAL_S)
+            .async_run(boost::asio::detached);
 
         subscribe_topics();
         receive_loop();
+        _link.start();
     }
 
 private:
@@ -53,6 +201,44 @@ private:
     client_type _client;
     InfusionManager& _manager;
     boost::asio::steady_timer _retry_timer;
+    JitteredBackoff _subscribe_backoff{std::chrono::milliseconds(100), std::chrono::milliseconds(1000)};
+    CommandExecutor _executor;
+    const MqttTopics _topics;
+    StatusEncoding _status_encoding;
+    std::chrono::milliseconds _command_max_age;
+    uint64_t _stale_commands = 0;
+
+    // Agrupamento por tópico (só acessados no io_context)
+    PublishBatcher<StatusSample> _status_batcher;
+    PublishBatcher<PressureAnalysis> _pressure_batcher;
+    std::vector<std::unique_ptr<StatusStream>> _streams;
+
+    // Parsing de comandos: DOM numa arena fixa + pilha temporária do parser.
+    // Comandos comuns cabem nos 1 KB da pilha; acima disso o boost::json
+    // estende a pilha no heap (só o DOM é limitado pela arena).
+    alignas(16) unsigned char _json_arena[COMMAND_JSON_ARENA];
+    unsigned char _json_parse_stack[1024];
+    boost::json::parser _json_parser;
+
+    // Store-and-forward (só acessados no io_context)
+    TelemetrySpool _spool;
+    LinkMonitor _link;
+    boost::asio::steady_timer _replay_timer;
+    bool _replay_in_flight = false;
+
+    // Upload da imagem (nullptr = desativado). begin e chunks no io_context,
+    // commit do end na thread do executor: o FirmwareStaging tem mutex próprio.
+    std::unique_ptr<FirmwareStaging> _staging;
+    std::chrono::steady_clock::time_point _upload_started;
+    unsigned _upload_pct = 0;
+    bool _upload_orphan_reported = false;
+
+    static boost::json::parse_options json_parse_options()
+    {
+        boost::json::parse_options opt;
+        opt.max_depth = 4; // comandos são objetos planos
+        return opt;
+    }
 
     // ========================================================
     // MQTT
@@ -60,22 +246,32 @@ private:
 
     void subscribe_topics()
     {
-        _client.async_subscribe(boost::mqtt5::subscribe_topic{TOPIC_CMD, boost::mqtt5::qos_e::at_least_once},
-                                boost::mqtt5::subscribe_props{},
+        std::vector<boost::mqtt5::subscribe_topic> topics{
+            boost::mqtt5::subscribe_topic{_topics.cmd, boost::mqtt5::qos_e::at_least_once}};
+
+        // QoS 1 num tópico só: o broker entrega os chunks na ordem publicada
+        if(_staging)
+            topics.push_back(boost::mqtt5::subscribe_topic{_topics.firmware, boost::mqtt5::qos_e::at_least_once});
+
+        _client.async_subscribe(topics, boost::mqtt5::subscribe_props{},
                                 [this](boost::mqtt5::error_code ec, std::vector<boost::mqtt5::reason_code>, auto) {
                                     if(!ec)
-                                        std::cout << "[MQTT] Inscrito em " << TOPIC_CMD << "\n";
-                                    else
                                     {
-                                        std::cerr << "[MQTT] Falha inscrição: " << ec.message() << " — retry em 5s\n";
-                                        schedule_subscribe_retry();
+                                        _subscribe_backoff.reset();
+                                        std::cout << "[MQTT] Inscrito em " << _topics.cmd
+                                                  << (_staging ? " e " + _topics.firmware : std::string()) << "\n";
                                     }
+                                    else
+                                        schedule_subscribe_retry(ec);
                                 });
     }
 
-    void schedule_subscribe_retry()
+    void schedule_subscribe_retry(boost::mqtt5::error_code ec)
     {
-        _retry_timer.expires_after(std::chrono::seconds(5));
+        auto delay = _subscribe_backoff.next();
+        std::cerr << "[MQTT] Falha inscrição: " << ec.message() << " — retry em " << delay.count() << " ms\n";
+
+        _retry_timer.expires_after(delay);
         _retry_timer.async_wait([this](boost::system::error_code ec) {
             if(!ec)
                 subscribe_topics();
@@ -84,10 +280,15 @@ private:
 
     void receive_loop()
     {
-        _client.async_receive([this](boost::mqtt5::error_code ec, std::string, std::string payload, auto) {
+        _client.async_receive([this](boost::mqtt5::error_code ec, std::string topic, std::string payload,
+                                     boost::mqtt5::publish_props props) {
             if(!ec)
             {
-                process_command(payload);
+                _link.note_command();
+                if(_staging && topic == _topics.firmware)
+                    on_firmware_chunk(payload);
+                else
+                    process_command(payload, reply_target(props));
                 receive_loop();
                 return;
             }
@@ -107,131 +308,552 @@ private:
     // Tradução JSON → Firmware
     // ========================================================
 
-    void process_command(const std::string& json_str)
+    // Cada handler extrai e valida os campos (antes de qualquer SPI) e monta
+    // o job do executor. Retorna false quando a mensagem é rejeitada.
+    using CommandHandler = bool (BasicMqttClient::*)(const boost::json::object&, CommandExecutor::Job&);
+
+    static CommandHandler handler_for(CommandAction action)
+    {
+        // Indexado por CommandAction
+        static const CommandHandler handlers[] = {
+            &BasicMqttClient::cmd_start,
+            &BasicMqttClient::cmd_pause,
+            &BasicMqttClient::cmd_stop,
+            &BasicMqttClient::cmd_config,
+            &BasicMqttClient::cmd_purge,
+            &BasicMqttClient::cmd_bolus,
+            &BasicMqttClient::cmd_update_firmware,
+            &BasicMqttClient::cmd_reset_mcu,
+            &BasicMqttClient::cmd_cancel_ota,
+            &BasicMqttClient::cmd_resume_ota,
+            &BasicMqttClient::cmd_fw_upload_begin,
+            &BasicMqttClient::cmd_fw_upload_end,
+        };
+        static_assert(sizeof(handlers) / sizeof(handlers[0]) == size_t(CommandAction::Count),
+                      "Tabela de handlers desalinhada com CommandAction");
+
+        return handlers[size_t(action)];
+    }
+
+    // ========================================================
+    // Request/response MQTT5
+    // ========================================================
+    //
+    // Se o comando traz response-topic, o resultado é publicado nele (com a
+    // correlation-data devolvida sem alteração):
+    //   {"action":"config","status":0,"queue_us":85,"exec_us":2410,"spi_us":2302}
+    // status é o código bruto do firmware ou uma convenção do HUB
+    // (CMD_HUB_OVERLOAD, CMD_TRANSPORT_ERROR). Sem response-topic: só log.
+
+    struct ReplyTarget
+    {
+        std::string topic;
+        std::string correlation;
+    };
+
+    static ReplyTarget reply_target(const boost::mqtt5::publish_props& props)
+    {
+        ReplyTarget target;
+
+        std::optional<std::string> topic = props[boost::mqtt5::prop::response_topic];
+        if(topic)
+            target.topic = std::move(*topic);
+
+        std::optional<std::string> correlation = props[boost::mqtt5::prop::correlation_data];
+        if(correlation)
+            target.correlation = std::move(*correlation);
+
+        return target;
+    }
+
+    // fw_upload_end aguardando o último chunk (só acessados no io_context)
+    struct PendingUploadEnd
+    {
+        CommandExecutor::Job job;
+        CommandExecutor::Completion done;
+        ReplyTarget reply;
+    };
+
+    std::optional<PendingUploadEnd> _upload_end;
+    boost::asio::steady_timer _upload_end_timer;
+
+    void send_reply(const ReplyTarget& target, CommandAction action, CommandStatus status,
+                    const CommandTiming& timing = CommandTiming{})
+    {
+        if(target.topic.empty())
+            return;
+
+        boost::json::object json;
+        json["action"] = action_name(action);
+        json["status"] = int(status);
+        json["queue_us"] = timing.queue_wait.count();
+        json["exec_us"] = timing.exec.count();
+        json["spi_us"] = timing.spi.count();
+
+        boost::mqtt5::publish_props props;
+        props[boost::mqtt5::prop::content_type] = std::string(STATUS_CONTENT_TYPE_JSON);
+        props[boost::mqtt5::prop::payload_format_indicator] = uint8_t(1);
+        if(!target.correlation.empty())
+            props[boost::mqtt5::prop::correlation_data] = target.correlation;
+
+        _client.template async_publish<boost::mqtt5::qos_e::at_least_once>(
+            target.topic, boost::json::serialize(json), boost::mqtt5::retain_e::no, props,
+            [](boost::mqtt5::error_code ec, boost::mqtt5::reason_code, boost::mqtt5::puback_props) {
+                if(ec)
+                    std::cerr << "[MQTT] Erro resposta: " << ec.message() << "\n";
+            });
+    }
+
+    // ========================================================
+    // Execução de comandos
+    // ========================================================
+
+    void process_command(std::string_view payload, ReplyTarget reply)
     {
         try
         {
+            // DOM da mensagem numa arena fixa: nenhum acesso ao heap por comando comum.
+            // Mensagem maior que a arena lança bad_alloc e é recusada (PARAM_RANGE).
+            boost::json::static_resource arena(_json_arena, sizeof(_json_arena));
             boost::system::error_code ec;
-            auto json_val = boost::json::parse(json_str, ec);
+
+            _json_parser.reset(&arena);
+            _json_parser.write(payload.data(), payload.size(), ec);
 
             if(ec)
             {
                 std::cerr << "[MQTT] JSON inválido\n";
+                send_reply(reply, CommandAction::Unknown, CMD_ERR_UNKNOWN_CMD);
                 return;
             }
 
-            auto json = json_val.as_object();
+            boost::json::value json_val = _json_parser.release();
 
-            if(!json.contains("action"))
+            const boost::json::object* json = json_val.if_object();
+            if(!json)
+            {
+                std::cerr << "[MQTT] JSON inválido\n";
+                send_reply(reply, CommandAction::Unknown, CMD_ERR_UNKNOWN_CMD);
                 return;
+            }
 
-            std::string action = boost::json::value_to<std::string>(json.at("action"));
+            std::string_view action_str;
+            CommandAction action = CommandAction::Unknown;
+            if(get_string_field(*json, "action", action_str) == FieldResult::Ok)
+                action = lookup_action(action_str);
 
-            std::cout << "[MQTT] Ação: " << action << "\n";
+            if(action == CommandAction::Unknown)
+            {
+                std::cerr << "[MQTT] Ação desconhecida: " << action_str << "\n";
+                send_reply(reply, CommandAction::Unknown, CMD_ERR_UNKNOWN_CMD);
+                return;
+            }
+
+            // Backlog reentregue após a queda: descarta sem tocar no SPI
+            std::chrono::milliseconds age;
+            if(is_stale(*json, age))
+            {
+                _stale_commands++;
+                std::cerr << "-> NACK (" << action_name(action) << "): " << int(CMD_HUB_STALE) << " comando com "
+                          << age.count() << " ms (descartados: " << _stale_commands << ")\n";
+                send_reply(reply, action, CMD_HUB_STALE);
+                return;
+            }
+
+            std::cout << "[MQTT] Ação: " << action_name(action) << "\n";
 
-            CommandStatus status = CMD_TRANSPORT_ERROR;
+            CommandExecutor::Job job;
+            if(!(this->*handler_for(action))(*json, job))
+            {
+                std::cerr << "-> NACK (" << action_name(action) << "): " << int(CMD_ERR_PARAM_RANGE)
+                          << " rejeitado no HUB\n";
+                send_reply(reply, action, CMD_ERR_PARAM_RANGE);
+                return;
+            }
 
             // ----------------------------------------------------
-            // Comandos diretos
+            // Execução (fora do io_context) e resultado
             // ----------------------------------------------------
 
-            if(action == "start")
-                status = _manager.start_infusion();
+            // A conclusão roda no io_context (post do executor)
+            CommandExecutor::Completion done = [this, action, reply](CommandStatus status,
+                                                                     const CommandTiming& timing) {
+                if(status == CMD_OK)
+                    std::cout << "-> ACK (" << action_name(action) << ") spi " << timing.spi.count() << " us\n";
+                else if(status == CMD_HUB_SUPERSEDED)
+                    std::cout << "-> (" << action_name(action) << ") substituído por um mais novo na fila\n";
+                else
+                    std::cerr << "-> NACK (" << action_name(action) << "): " << int(status) << "\n";
 
-            else if(action == "pause")
-                status = _manager.pause_infusion();
+                send_reply(reply, action, status, timing);
+            };
 
-            else if(action == "stop" || action == "abort")
-                status = _manager.stop_infusion();
+            // fw_upload_begin já rodou no handler (io_context): resposta direta. Pela
+            // fila, um overload ou uma parada responderiam falha com o staging aberto.
+            if(action == CommandAction::FirmwareUploadBegin)
+            {
+                done(job(), CommandTiming{});
+                return;
+            }
 
-            // ----------------------------------------------------
-            // Configuração contínua
-            // ----------------------------------------------------
+            if(action == CommandAction::FirmwareUploadEnd && defer_upload_end(job, done, reply))
+                return;
 
-            else if(action == "config")
-            {
-                if(json.contains("volume") && json.contains("rate"))
-                {
-                    uint32_t vol = json.at("volume").as_int64();
-                    uint32_t rate = json.at("rate").as_int64();
+            submit_command(action, std::move(job), std::move(done), reply);
+        }
+        catch(const std::bad_alloc&)
+        {
+            std::cerr << "[MQTT] Comando excede a arena de " << sizeof(_json_arena) << " bytes\n";
+            send_reply(reply, CommandAction::Unknown, CMD_ERR_PARAM_RANGE);
+        }
+        catch(const std::exception& e)
+        {
+            std::cerr << "[MQTT] Erro lógico: " << e.what() << "\n";
+        }
+    }
 
-                    status = _manager.set_config(vol, rate);
-                }
-                else
-                {
-                    std::cerr << "[MQTT] Config incompleta\n";
-                    return;
-                }
-            }
+    // Stop/abort pela faixa de parada; config coalescido (último vence
+    // enquanto é o último da fila). Fila cheia: NACK overload.
+    void submit_command(CommandAction action, CommandExecutor::Job job, CommandExecutor::Completion done,
+                        const ReplyTarget& reply)
+    {
+        CommandExecutor::CoalesceKey key = action_coalesces(action) ? uint32_t(action) + 1 : 0;
 
-            // ----------------------------------------------------
-            // PURGE
-            // ----------------------------------------------------
+        bool queued = action_is_stop(action) ? _executor.submit_stop(std::move(job), std::move(done))
+                                             : _executor.submit(std::move(job), std::move(done), key);
 
-            else if(action == "purge")
-            {
-                uint32_t rate = json.contains("rate") ? json.at("rate").as_int64() : MAX_PURGE_RATE;
+        if(!queued)
+        {
+            auto m = _executor.metrics();
+            std::cerr << "-> NACK (" << action_name(action) << "): " << int(CMD_HUB_OVERLOAD) << " overload — fila "
+                      << m.queue_depth << "/" << COMMAND_QUEUE_DEPTH << ", recusados " << m.rejected
+                      << ", espera max " << m.max_queue_wait.count() << " us\n";
+            send_reply(reply, action, CMD_HUB_OVERLOAD);
+        }
+    }
 
-                status = _manager.start_purge(rate);
-            }
+    // "ts" opcional (ms desde epoch, relógio de parede do publisher).
+    // Relógio do publisher adiantado resulta em idade negativa: aceito.
+    bool is_stale(const boost::json::object& json, std::chrono::milliseconds& age) const
+    {
+        uint64_t ts;
+        if(_command_max_age.count() == 0 || get_u64_field(json, "ts", ts) != FieldResult::Ok)
+            return false;
 
-            // ----------------------------------------------------
-            // BOLUS
-            // ----------------------------------------------------
+        auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
 
-            else if(action == "bolus")
-            {
-                uint32_t vol = json.contains("volume") ? json.at("volume").as_int64() : 5;
+        age = now - std::chrono::milliseconds(int64_t(ts));
+        return age > _command_max_age;
+    }
 
-                uint32_t rate = json.contains("rate") ? json.at("rate").as_int64() : 600;
+    static bool check_field(FieldResult r, const char* key)
+    {
+        if(r == FieldResult::Ok)
+            return true;
 
-                status = _manager.start_bolus(vol, rate);
-            }
+        std::cerr << "[MQTT] Campo '" << key << "' " << field_result_name(r) << "\n";
+        return false;
+    }
 
-            // ----------------------------------------------------
-            // OTA
-            // ----------------------------------------------------
+    // ----------------------------------------------------
+    // Comandos diretos
+    // ----------------------------------------------------
 
-            else if(action == "update_firmware")
-            {
-                if(json.contains("file_path"))
-                {
-                    std::string path = boost::json::value_to<std::string>(json.at("file_path"));
+    bool cmd_start(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        job = [this] { return _manager.start_infusion(); };
+        return true;
+    }
 
-                    std::cout << "[OTA] Iniciando: " << path << "\n";
-                    _manager.start_ota_process(path);
-                    return;
-                }
-                else
-                {
-                    std::cerr << "[MQTT] OTA sem file_path\n";
-                    return;
-                }
-            }
+    bool cmd_pause(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        job = [this] { return _manager.pause_infusion(); };
+        return true;
+    }
 
-            // ----------------------------------------------------
-            // Reset físico
-            // ----------------------------------------------------
+    bool cmd_stop(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        job = [this] { return _manager.stop_infusion(); };
+        return true;
+    }
+
+    // ----------------------------------------------------
+    // Configuração contínua
+    // ----------------------------------------------------
+
+    bool cmd_config(const boost::json::object& json, CommandExecutor::Job& job)
+    {
+        uint32_t vol, rate;
+
+        if(!check_field(get_u32_field(json, "volume", 0, UINT32_MAX, vol, true), "volume") ||
+           !check_field(get_u32_field(json, "rate", 0, UINT32_MAX, rate, true), "rate"))
+            return false;
+
+        job = [this, vol, rate] { return _manager.set_config(vol, rate); };
+        return true;
+    }
+
+    // ----------------------------------------------------
+    // PURGE
+    // ----------------------------------------------------
+
+    // O PURGE do firmware não tem payload: purga na vazão do próprio firmware.
+    // "rate" segue validado (0..MAX_PURGE_RATE) por compatibilidade, mas é ignorado.
+    bool cmd_purge(const boost::json::object& json, CommandExecutor::Job& job)
+    {
+        uint32_t rate;
+
+        if(!check_field(get_u32_field(json, "rate", 0, MAX_PURGE_RATE, rate, false, MAX_PURGE_RATE), "rate"))
+            return false;
 
-            else if(action == "reset_mcu")
+        job = [this, rate] { return _manager.start_purge(rate); };
+        return true;
+    }
+
+    // ----------------------------------------------------
+    // BOLUS
+    // ----------------------------------------------------
+
+    bool cmd_bolus(const boost::json::object& json, CommandExecutor::Job& job)
+    {
+        uint32_t vol, rate;
+
+        if(!check_field(get_u32_field(json, "volume", 0, UINT32_MAX, vol, false, 5), "volume") ||
+           !check_field(get_u32_field(json, "rate", 0, UINT32_MAX, rate, false, 600), "rate"))
+            return false;
+
+        job = [this, vol, rate] { return _manager.start_bolus(vol, rate); };
+        return true;
+    }
+
+    // ----------------------------------------------------
+    // OTA
+    // ----------------------------------------------------
+
+    bool cmd_update_firmware(const boost::json::object& json, CommandExecutor::Job& job)
+    {
+        std::string_view path_view;
+
+        if(!check_field(get_string_field(json, "file_path", path_view), "file_path") || path_view.empty())
+            return false;
+
+        std::string path(path_view);
+        std::cout << "[OTA] Iniciando: " << path << "\n";
+
+        job = [this, path] { return _manager.start_ota_process(path); };
+        return true;
+    }
+
+    // Só a transferência é cancelável; depois do END o swap já foi pedido
+    bool cmd_cancel_ota(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        job = [this] { return _manager.cancel_ota() ? CommandStatus(CMD_OK) : CommandStatus(CMD_ERR_INVALID_STATE); };
+        return true;
+    }
+
+    // OTA interrompido anunciado na subida (phase "resumable"): só com a bomba ociosa
+    bool cmd_resume_ota(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        job = [this] { return _manager.resume_ota(); };
+        return true;
+    }
+
+    // ----------------------------------------------------
+    // Upload da imagem
+    // ----------------------------------------------------
+    //
+    //   {"action":"fw_upload_begin","size":204800,"sha256":"<64 hexa>","crc":4660}
+    //   chunks binários em <raiz>/firmware: offset (u32 LE) + dados, em ordem
+    //   {"action":"fw_upload_end"} -> confere SHA-256/CRC e inicia o OTA
+    //
+    // O MQTT não ordena mensagens de tópicos diferentes: o publisher só
+    // manda o primeiro chunk depois da resposta do begin (o begin roda já
+    // na chegada, no io_context). Chunk sem upload aberto é descartado e
+    // avisado no tópico ota. O end pode seguir logo o último chunk: se
+    // chegar antes dele, espera os que faltam (UPLOAD_END_WAIT).
+    //
+    // "crc" (CRC16 do START) é opcional. Andamento e recusas no tópico ota
+    // (phase "upload"; "failed" com o motivo).
+
+    bool cmd_fw_upload_begin(const boost::json::object& json, CommandExecutor::Job& job)
+    {
+        uint32_t size;
+        uint32_t crc;
+        std::string_view sha_hex;
+        Sha256Digest sha;
+
+        if(!_staging)
+            return false;
+
+        if(!check_field(get_u32_field(json, "size", FIRMWARE_MIN_SIZE, FIRMWARE_MAX_SIZE, size, true), "size") ||
+           !check_field(get_string_field(json, "sha256", sha_hex), "sha256") ||
+           !check_field(get_u32_field(json, "crc", 0, 0xFFFF, crc, false), "crc"))
+            return false;
+
+        if(!sha256_from_hex(sha_hex, sha))
+        {
+            std::cerr << "[MQTT] Campo 'sha256': esperado 64 digitos hexa\n";
+            return false;
+        }
+
+        // Um end pendente é do upload anterior: segue para o executor e falha lá
+        release_upload_end();
+
+        // Aqui mesmo, antes de ler a próxima mensagem: nenhum chunk depois
+        // desta pode encontrar o staging do upload anterior
+        int32_t expected_crc = json.contains("crc") ? int32_t(crc) : -1;
+        CommandStatus status = _staging->begin(size, sha, expected_crc);
+        _upload_pct = 0;
+        _upload_orphan_reported = false;
+
+        job = [status] { return status; };
+        return true;
+    }
+
+    bool cmd_fw_upload_end(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        if(!_staging)
+            return false;
+
+        job = [this] {
+            StagedFirmware staged;
+            CommandStatus status = _staging->commit(staged);
+            if(status != CMD_OK)
             {
-                _manager.hard_reset_stm32();
-                return;
+                // Incompleto: o upload continua aberto para os chunks que faltam
+                if(!_staging->active() && *_staging->error())
+                    boost::asio::post(_io, [this] { publish_upload_failure(); });
+                return status;
             }
 
-            // ----------------------------------------------------
-            // Resultado
-            // ----------------------------------------------------
+            // Recusado (manutenção em andamento): a imagem fica no staging e
+            // pode ser gravada depois com update_firmware
+            std::cout << "[OTA] Iniciando: " << staged.path << " (upload)\n";
+            return _manager.start_ota_process(staged.path, std::move(staged.image), staged.crc);
+        };
+        return true;
+    }
+
+    // Chamado no io_context com o end já validado. true = guardado até o último chunk.
+    bool defer_upload_end(CommandExecutor::Job& job, CommandExecutor::Completion& done, const ReplyTarget& reply)
+    {
+        if(!_staging->active() || _staging->received() == _staging->size())
+            return false;
+
+        release_upload_end();
+
+        std::cout << "[OTA] fw_upload_end com " << _staging->received() << " de " << _staging->size()
+                  << " bytes: aguardando os chunks que faltam\n";
+
+        _upload_end = PendingUploadEnd{std::move(job), std::move(done), reply};
+        _upload_end_timer.expires_after(UPLOAD_END_WAIT);
+        _upload_end_timer.async_wait([this](boost::system::error_code ec) {
+            if(!ec)
+                release_upload_end();
+        });
+        return true;
+    }
+
+    // Upload completo, abortado ou prazo esgotado: o commit decide o resultado
+    void release_upload_end()
+    {
+        if(!_upload_end)
+            return;
+
+        _upload_end_timer.cancel();
+        PendingUploadEnd pending = std::move(*_upload_end);
+        _upload_end.reset();
+        submit_command(CommandAction::FirmwareUploadEnd, std::move(pending.job), std::move(pending.done),
+                       pending.reply);
+    }
 
-            if(status == CMD_OK)
-                std::cout << "-> ACK\n";
-            else
-                std::cerr << "-> NACK: " << int(status) << "\n";
+    // io_context. Recusa aborta o upload; os chunks seguintes são ignorados
+    // até o próximo fw_upload_begin.
+    void on_firmware_chunk(std::string_view payload)
+    {
+        if(payload.size() <= 4)
+        {
+            std::cerr << "[MQTT] Chunk de firmware sem dados\n";
+            return;
         }
-        catch(const std::exception& e)
+
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(payload.data());
+        uint32_t offset = uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 |
+                          uint32_t(bytes[3]) << 24;
+
+        bool was_active = _staging->active();
+        StagingChunk result = _staging->write(offset, bytes + 4, payload.size() - 4);
+
+        if(result == StagingChunk::Rejected)
         {
-            std::cerr << "[MQTT] Erro lógico: " << e.what() << "\n";
+            if(was_active)
+            {
+                publish_upload_failure();
+                release_upload_end();
+                return;
+            }
+
+            // QoS 1 já confirmou o chunk ao broker: sem este aviso ele sumiria.
+            // Reentrega de um upload já concluído não conta.
+            bool redelivered = offset < _staging->size() && _staging->received() == _staging->size();
+            if(!redelivered && !_upload_orphan_reported)
+            {
+                _upload_orphan_reported = true;
+                std::cerr << "[OTA] Chunk em " << offset << " sem fw_upload_begin aceito — descartado\n";
+                publish_upload_failure("chunk sem upload ativo");
+            }
+            return;
         }
+
+        if(result != StagingChunk::Stored)
+            return;
+
+        uint32_t received = _staging->received();
+        uint32_t total = _staging->size();
+        if(received == total)
+            release_upload_end();
+        if(received == payload.size() - 4)
+            _upload_started = std::chrono::steady_clock::now();
+
+        unsigned pct = unsigned(uint64_t(received) * 100 / total);
+        if(pct == _upload_pct)
+            return;
+        _upload_pct = pct;
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                             _upload_started);
+        OtaProgress progress;
+        progress.phase = OtaPhase::Upload;
+        progress.acked = received;
+        progress.total = total;
+        progress.elapsed_ms = uint32_t(elapsed.count());
+        if(elapsed.count() > 0)
+            progress.bytes_per_second = uint32_t(uint64_t(received) * 1000 / elapsed.count());
+        publish_ota(progress);
+    }
+
+    void publish_upload_failure(const char* reason = nullptr)
+    {
+        OtaProgress progress;
+        progress.phase = OtaPhase::Failed;
+        progress.acked = _staging->received();
+        progress.total = _staging->size();
+        progress.result = reason ? reason : _staging->error();
+        publish_ota(progress);
+    }
+
+    // ----------------------------------------------------
+    // Reset físico
+    // ----------------------------------------------------
+
+    bool cmd_reset_mcu(const boost::json::object&, CommandExecutor::Job& job)
+    {
+        job = [this] {
+            _manager.hard_reset_stm32();
+            return CommandStatus(CMD_OK);
+        };
+        return true;
     }
 
     // ========================================================
@@ -240,17 +862,244 @@ private:
 
     void setup_manager_callbacks()
     {
-        _manager.set_status_callback([this](std::string json_payload) {
-            boost::asio::post(_io, [this, json_payload]() {
-                _client.async_publish<boost::mqtt5::qos_e::at_most_once>(
-                    TOPIC_STATUS, json_payload, boost::mqtt5::retain_e::no, boost::mqtt5::publish_props{},
-                    [](boost::system::error_code ec) {
-                        if(ec)
-                            std::cerr << "[MQTT] Erro publish: " << ec.message() << "\n";
-                    });
+        // A thread de monitoramento só copia a amostra (POD); agrupamento e
+        // codificação rodam no io_context. Um único post alimenta todos os streams.
+        _manager.set_status_callback([this](const StatusSample& sample) {
+            boost::asio::post(_io, [this, sample]() {
+                _status_batcher.push(sample);
+                for(auto& stream : _streams)
+                    stream->push(sample);
             });
         });
+
+        _manager.set_pressure_callback([this](const PressureAnalysis& analysis) {
+            boost::asio::post(_io, [this, analysis]() { _pressure_batcher.push(analysis); });
+        });
+
+        _manager.set_ota_progress_callback([this](const OtaProgress& progress) {
+            boost::asio::post(_io, [this, progress]() { publish_ota(progress); });
+        });
+    }
+
+    // ========================================================
+    // Andamento do OTA
+    // ========================================================
+    //
+    //   {"phase":"transfer","acked":65536,"total":204800,"percent":32,
+    //    "bytes_per_s":58213,"elapsed_ms":1126,"retransmissions":0,"result":""}
+    //
+    // upload/transfer a cada 1% (QoS 0, o próximo substitui); booting/done/failed/
+    // cancelled em QoS 1 com o resultado do motor (ota_result_name).
+
+    static const char* ota_phase_name(OtaPhase phase)
+    {
+        switch(phase)
+        {
+        case OtaPhase::Upload:
+            return "upload";
+        case OtaPhase::Resumable:
+            return "resumable";
+        case OtaPhase::Transfer:
+            return "transfer";
+        case OtaPhase::Booting:
+            return "booting";
+        case OtaPhase::Done:
+            return "done";
+        case OtaPhase::Failed:
+            return "failed";
+        case OtaPhase::Cancelled:
+            return "cancelled";
+        }
+        return "?";
+    }
+
+    void publish_ota(const OtaProgress& progress)
+    {
+        boost::json::object json;
+        json["phase"] = ota_phase_name(progress.phase);
+        json["acked"] = progress.acked;
+        json["total"] = progress.total;
+        json["percent"] = progress.total ? uint64_t(progress.acked) * 100 / progress.total : 0;
+        json["bytes_per_s"] = progress.bytes_per_second;
+        json["elapsed_ms"] = progress.elapsed_ms;
+        json["retransmissions"] = progress.retransmissions;
+        json["result"] = progress.result;
+
+        boost::mqtt5::publish_props props;
+        props[boost::mqtt5::prop::content_type] = std::string(STATUS_CONTENT_TYPE_JSON);
+        props[boost::mqtt5::prop::payload_format_indicator] = uint8_t(1);
+
+        auto on_error = [](boost::system::error_code ec) {
+            if(ec)
+                std::cerr << "[MQTT] Erro publish OTA: " << ec.message() << "\n";
+        };
+
+        if(progress.phase == OtaPhase::Upload || progress.phase == OtaPhase::Transfer)
+        {
+            _client.template async_publish<boost::mqtt5::qos_e::at_most_once>(
+                _topics.ota, boost::json::serialize(json), boost::mqtt5::retain_e::no, props, on_error);
+            return;
+        }
+
+        _client.template async_publish<boost::mqtt5::qos_e::at_least_once>(
+            _topics.ota, boost::json::serialize(json), boost::mqtt5::retain_e::no, props,
+            [on_error](boost::mqtt5::error_code ec, boost::mqtt5::reason_code, boost::mqtt5::puback_props) {
+                on_error(ec);
+            });
+    }
+
+    void publish_status(const std::vector<StatusSample>& batch)
+    {
+        // Broker fora: guarda para o replay em vez de perder no QoS 0
+        if(_spool.is_open() && !_link.online())
+        {
+            for(const auto& sample : batch)
+                _spool.append(sample);
+            return;
+        }
+
+        _client.template async_publish<boost::mqtt5::qos_e::at_most_once>(
+            _topics.status, encode_status_batch(_status_encoding, batch), boost::mqtt5::retain_e::no,
+            status_props(_status_encoding),
+            [this](boost::system::error_code ec) {
+                if(ec)
+                {
+                    std::cerr << "[MQTT] Erro publish: " << ec.message() << "\n";
+                    _link.report_error();
+                }
+            });
+    }
+
+    // Streams derivados são visões ao vivo: durante a queda só o bomba/status
+    // vai para o spool (o replay reconstrói qualquer agregação)
+    void publish_stream(const StatusStream& stream, const std::vector<StatusSample>& batch)
+    {
+        if(_spool.is_open() && !_link.online())
+            return;
+
+        _client.template async_publish<boost::mqtt5::qos_e::at_most_once>(
+            stream.topic(), encode_status_batch(stream.encoding(), batch), boost::mqtt5::retain_e::no,
+            status_props(stream.encoding()), [](boost::system::error_code ec) {
+                if(ec)
+                    std::cerr << "[MQTT] Erro publish: " << ec.message() << "\n";
+            });
+    }
+
+    static boost::mqtt5::publish_props status_props(StatusEncoding encoding)
+    {
+        boost::mqtt5::publish_props props;
+        props[boost::mqtt5::prop::content_type] = std::string(status_content_type(encoding));
+        props[boost::mqtt5::prop::payload_format_indicator] = uint8_t(encoding == StatusEncoding::Json ? 1 : 0);
+        return props;
+    }
+
+    // ========================================================
+    // Link e replay do spool
+    // ========================================================
+
+    void send_link_probe(LinkMonitor::ProbeDone done)
+    {
+        _client.template async_publish<boost::mqtt5::qos_e::at_least_once>(
+            _topics.link, std::string(), boost::mqtt5::retain_e::no, boost::mqtt5::publish_props{},
+            [done = std::move(done)](boost::mqtt5::error_code ec, boost::mqtt5::reason_code rc,
+                                     boost::mqtt5::puback_props) { done(!ec && !rc); });
+    }
+
+    void on_link_change(bool online)
+    {
+        if(!online)
+        {
+            _replay_timer.cancel();
+            return;
+        }
+
+        if(_spool.pending() > 0)
+        {
+            std::cout << "[SPOOL] Reenviando " << _spool.pending() << " amostras (descartadas: " << _spool.dropped()
+                      << ")\n";
+            schedule_replay(std::chrono::milliseconds(0));
+        }
+    }
+
+    void schedule_replay(std::chrono::milliseconds delay)
+    {
+        _replay_timer.expires_after(delay);
+        _replay_timer.async_wait([this](boost::system::error_code ec) {
+            if(!ec)
+                replay_step();
+        });
+    }
+
+    void replay_step()
+    {
+        if(_replay_in_flight || !_link.online() || _spool.pending() == 0)
+            return;
+
+        std::vector<StatusSample> batch;
+        uint64_t first = _spool.peek(batch, REPLAY_BATCH);
+        size_t count = batch.size();
+
+        _replay_in_flight = true;
+
+        // QoS 1: só libera do spool depois do PUBACK
+        _client.template async_publish<boost::mqtt5::qos_e::at_least_once>(
+            _topics.status_replay, encode_status_records(_status_encoding, batch), boost::mqtt5::retain_e::no,
+            status_props(_status_encoding),
+            [this, first, count](boost::mqtt5::error_code ec, boost::mqtt5::reason_code rc,
+                                 boost::mqtt5::puback_props) {
+                _replay_in_flight = false;
+
+                if(ec || rc)
+                {
+                    std::cerr << "[SPOOL] Falha no replay: " << (ec ? ec.message() : rc.message()) << "\n";
+                    _link.report_error();
+                    return;
+                }
+
+                _spool.release(first, count);
+
+                if(_spool.pending() > 0)
+                    schedule_replay(REPLAY_INTERVAL);
+                else
+                    std::cout << "[SPOOL] Replay concluido\n";
+            });
+    }
+
+    static boost::json::object pressure_to_json(const PressureAnalysis& analysis)
+    {
+        boost::json::object json;
+        json["filtered"] = analysis.filtered;
+        json["mean"] = analysis.mean;
+        json["peak_to_peak"] = analysis.peak_to_peak;
+        json["cycle_hz"] = analysis.dominant_hz;
+        json["cycle_power"] = analysis.dominant_power;
+        return json;
+    }
+
+    void publish_pressure(const std::vector<PressureAnalysis>& batch)
+    {
+        std::string payload;
+        if(batch.size() == 1)
+            payload = boost::json::serialize(pressure_to_json(batch.front()));
+        else
+        {
+            boost::json::array json;
+            json.reserve(batch.size());
+            for(const auto& analysis : batch)
+                json.push_back(pressure_to_json(analysis));
+            payload = boost::json::serialize(json);
+        }
+
+        _client.template async_publish<boost::mqtt5::qos_e::at_most_once>(
+            _topics.pressure, payload, boost::mqtt5::retain_e::no, boost::mqtt5::publish_props{},
+            [](boost::system::error_code ec) {
+                if(ec)
+                    std::cerr << "[MQTT] Erro publish: " << ec.message() << "\n";
+            });
     }
 };
 
+using MqttClient = BasicMqttClient<boost::asio::ip::tcp::socket>;
+using LocalMqttClient = BasicMqttClient<LocalBrokerStream>;
+
 #endif
@@ -0,0 +1,127 @@
+#ifndef PUBLISH_BATCHER_HPP
+#define PUBLISH_BATCHER_HPP
+
+#include <boost/asio.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+// ============================================================
+// Agrupamento de amostras por publish
+// ============================================================
+//
+// Fica entre os callbacks do InfusionManager e o async_publish: acumula
+// até N amostras ou T ms numa única mensagem. Amostras "urgentes" (ex.:
+// mudança de estado ou alarme) fecham o lote na hora, já incluídas.
+//
+// Política por tópico, no formato "N" ou "N:T" (ex.: "20:1000").
+// N = 1 mantém o comportamento antigo: um publish por amostra.
+//
+// Todos os métodos devem ser chamados na thread do io_context.
+
+struct BatchPolicy
+{
+    size_t max_samples = 1;
+    std::chrono::milliseconds max_delay{0}; // 0 = só fecha por contagem/urgência
+};
+
+inline BatchPolicy parse_batch_policy(const char* spec, BatchPolicy fallback = BatchPolicy{})
+{
+    if(!spec || !*spec)
+        return fallback;
+
+    char* end = nullptr;
+    unsigned long n = std::strtoul(spec, &end, 10);
+    if(end == spec || n == 0)
+        return fallback;
+
+    BatchPolicy policy;
+    policy.max_samples = n;
+
+    if(*end == ':')
+    {
+        const char* t_str = end + 1;
+        unsigned long t = std::strtoul(t_str, &end, 10);
+        if(end == t_str)
+            return fallback;
+        policy.max_delay = std::chrono::milliseconds(t);
+    }
+
+    return policy;
+}
+
+template <class Sample>
+class PublishBatcher
+{
+public:
+    using FlushFn = std::function<void(const std::vector<Sample>&)>;
+    using UrgentFn = std::function<bool(const Sample& prev, const Sample& cur)>;
+
+    PublishBatcher(boost::asio::io_context& io, BatchPolicy policy, FlushFn flush, UrgentFn urgent = UrgentFn{})
+        : _timer(io), _policy(policy), _flush(std::move(flush)), _urgent(std::move(urgent))
+    {
+        if(_policy.max_samples < 1)
+            _policy.max_samples = 1;
+        _pending.reserve(_policy.max_samples);
+    }
+
+    void push(const Sample& sample)
+    {
+        // Primeira amostra também é urgente: o consumidor recebe o estado atual logo
+        bool urgent = !_has_last || (_urgent && _urgent(_last, sample));
+        _last = sample;
+        _has_last = true;
+
+        _pending.push_back(sample);
+
+        if(urgent || _pending.size() >= _policy.max_samples)
+        {
+            flush();
+            return;
+        }
+
+        if(_pending.size() == 1 && _policy.max_delay.count() > 0)
+            arm_timer();
+    }
+
+    void flush()
+    {
+        _timer.cancel();
+
+        if(_pending.empty())
+            return;
+
+        _flush(_pending);
+        _pending.clear();
+    }
+
+    const BatchPolicy& policy() const
+    {
+        return _policy;
+    }
+
+private:
+    boost::asio::steady_timer _timer;
+    BatchPolicy _policy;
+    FlushFn _flush;
+    UrgentFn _urgent;
+
+    std::vector<Sample> _pending;
+    Sample _last{};
+    bool _has_last = false;
+    unsigned _generation = 0; // descarta timers de lotes já fechados
+
+    void arm_timer()
+    {
+        unsigned gen = ++_generation;
+
+        _timer.expires_after(_policy.max_delay);
+        _timer.async_wait([this, gen](boost::system::error_code ec) {
+            if(!ec && gen == _generation)
+                flush();
+        });
+    }
+};
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef SHM_STATUS_FEED_HPP
+#define SHM_STATUS_FEED_HPP
+
+#include <cstring>
+#include <fcntl.h>
+#include <grp.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "infusion_manager.hpp"
+#include "argus_shm.h"
+
+// ============================================================
+// Escritor do feed de status em /dev/shm
+// ============================================================
+//
+// Layout e funções de leitura em argus_shm.h (header C para consumidores
+// locais). publish() roda direto na thread de monitoramento do canal: é o
+// único escritor daquele bloco, então seqlock e fila SPSC não precisam de
+// lock nem de syscall. Eventos de estado/alarme são derivados das amostras.
+
+class ShmStatusFeed
+{
+public:
+    ShmStatusFeed() = default;
+
+    ~ShmStatusFeed()
+    {
+        close();
+    }
+
+    ShmStatusFeed(const ShmStatusFeed&) = delete;
+    ShmStatusFeed& operator=(const ShmStatusFeed&) = delete;
+
+    // Cria (ou recria) a região. Falha não é fatal: o daemon segue sem o feed.
+    bool open(const std::vector<std::string>& channel_ids)
+    {
+        if(channel_ids.size() > ARGUS_SHM_MAX_CHANNELS)
+        {
+            std::cerr << "[SHM] Canais demais para o feed (" << channel_ids.size() << ")\n";
+            return false;
+        }
+
+        int fd = shm_open(ARGUS_SHM_NAME, O_CREAT | O_RDWR, 0660);
+        if(fd < 0)
+        {
+            std::cerr << "[SHM] shm_open falhou: " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        // Leitores abrem RW para avançar 'tail': grupo com escrita. fchmod
+        // porque shm_open não muda o modo de uma região que já existia e a
+        // umask tira o g+w.
+        if(const struct group* gr = getgrnam(ARGUS_SHM_GROUP))
+        {
+            if(fchown(fd, static_cast<uid_t>(-1), gr->gr_gid) != 0)
+                std::cerr << "[SHM] fchown falhou: " << std::strerror(errno) << "\n";
+        }
+        else
+        {
+            std::cerr << "[SHM] Grupo '" << ARGUS_SHM_GROUP << "' nao existe: feed so para o grupo do daemon\n";
+        }
+
+        if(fchmod(fd, 0660) != 0)
+            std::cerr << "[SHM] fchmod falhou: " << std::strerror(errno) << "\n";
+
+        if(ftruncate(fd, sizeof(argus_shm_region_t)) != 0)
+        {
+            std::cerr << "[SHM] ftruncate falhou: " << std::strerror(errno) << "\n";
+            ::close(fd);
+            return false;
+        }
+
+        void* addr = mmap(nullptr, sizeof(argus_shm_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if(addr == MAP_FAILED)
+        {
+            std::cerr << "[SHM] mmap falhou: " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        _region = static_cast<argus_shm_region_t*>(addr);
+
+        // Leitores só aceitam a região depois que o magic aparece (por último)
+        __atomic_store_n(&_region->header.magic, 0u, __ATOMIC_RELAXED);
+        std::memset(static_cast<void*>(_region), 0, sizeof(argus_shm_region_t));
+
+        _region->header.version = ARGUS_SHM_VERSION;
+        _region->header.size = sizeof(argus_shm_region_t);
+        _region->header.channel_count = static_cast<uint32_t>(channel_ids.size());
+        _region->header.writer_pid = static_cast<uint32_t>(getpid());
+
+        for(size_t i = 0; i < channel_ids.size(); i++)
+        {
+            argus_shm_channel_t& ch = _region->channels[i];
+            std::strncpy(ch.id, channel_ids[i].c_str(), ARGUS_SHM_ID_SIZE - 1);
+            __atomic_store_n(&ch.active, 1u, __ATOMIC_RELEASE);
+        }
+
+        _last.assign(channel_ids.size(), LastState{});
+
+        __atomic_store_n(&_region->header.magic, ARGUS_SHM_MAGIC, __ATOMIC_RELEASE);
+
+        std::cout << "[SHM] Feed em /dev/shm" << ARGUS_SHM_NAME << " (" << sizeof(argus_shm_region_t) << " bytes)\n";
+        return true;
+    }
+
+    void close()
+    {
+        if(!_region)
+            return;
+
+        munmap(_region, sizeof(argus_shm_region_t));
+        shm_unlink(ARGUS_SHM_NAME);
+        _region = nullptr;
+    }
+
+    bool is_open() const
+    {
+        return _region != nullptr;
+    }
+
+    // Chamar somente da thread de monitoramento do canal
+    void publish(unsigned channel, const StatusSample& s)
+    {
+        if(!_region || channel >= _last.size())
+            return;
+
+        argus_shm_channel_t& ch = _region->channels[channel];
+        LastState& last = _last[channel];
+
+        // Seqlock (escritor único): ímpar -> dados -> par
+        uint32_t seq = __atomic_load_n(&ch.seq, __ATOMIC_RELAXED);
+        __atomic_store_n(&ch.seq, seq + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+
+        ch.latest.timestamp_ms = s.timestamp_ms;
+        ch.latest.volume = s.volume;
+        ch.latest.flow_rate = s.flow_rate;
+        ch.latest.pressure = s.pressure;
+        ch.latest.samples++;
+        ch.latest.state = s.state;
+        ch.latest.alarm = s.alarm;
+
+        __atomic_store_n(&ch.seq, seq + 2, __ATOMIC_RELEASE);
+
+        // Eventos: só transições
+        if(last.valid && last.state != s.state)
+            push_event(ch, s.timestamp_ms, ARGUS_SHM_EVENT_STATE, last.state, s.state);
+
+        if(last.valid && last.alarm != s.alarm)
+            push_event(ch, s.timestamp_ms, s.alarm ? ARGUS_SHM_EVENT_ALARM_ON : ARGUS_SHM_EVENT_ALARM_OFF, s.state, 0);
+
+        last.state = s.state;
+        last.alarm = s.alarm;
+        last.valid = true;
+    }
+
+private:
+    struct LastState
+    {
+        bool valid = false;
+        uint8_t state = 0;
+        uint8_t alarm = 0;
+    };
+
+    argus_shm_region_t* _region = nullptr;
+    std::vector<LastState> _last;
+
+    static void push_event(argus_shm_channel_t& ch, uint64_t timestamp_ms, argus_shm_event_type_t type, uint32_t v0,
+                           uint32_t v1)
+    {
+        uint32_t head = __atomic_load_n(&ch.head, __ATOMIC_RELAXED);
+        uint32_t tail = __atomic_load_n(&ch.tail, __ATOMIC_ACQUIRE);
+
+        // Fila cheia: descarta (nunca espera pelo leitor)
+        if(head - tail >= ARGUS_SHM_EVENT_SLOTS)
+        {
+            __atomic_store_n(&ch.dropped, ch.dropped + 1, __ATOMIC_RELAXED);
+            return;
+        }
+
+        argus_shm_event_t& ev = ch.ring[head & (ARGUS_SHM_EVENT_SLOTS - 1)];
+        ev.timestamp_ms = timestamp_ms;
+        ev.type = static_cast<uint16_t>(type);
+        ev.reserved = 0;
+        ev.value[0] = v0;
+        ev.value[1] = v1;
+        ev.value[2] = 0;
+
+        __atomic_store_n(&ch.head, head + 1, __ATOMIC_RELEASE);
+    }
+};
+
+#endif
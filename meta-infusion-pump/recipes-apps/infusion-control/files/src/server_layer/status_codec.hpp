@@ -0,0 +1,225 @@
+#ifndef STATUS_CODEC_HPP
+#define STATUS_CODEC_HPP
+
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "status_sample.hpp"
+
+extern "C"
+{
+#include "utl_io.h"
+}
+
+// ============================================================
+// Codificação do status (bomba/status)
+// ============================================================
+//
+// O formato é escolhido por deployment (ARGUS_STATUS_FORMAT=json|packed)
+// e sinalizado no publish pela propriedade MQTT5 content-type.
+//
+// JSON (compatível com os consumidores existentes):
+//   {"state":"RUNNING","infused_volume_ml":12,"real_rate_ml_h":100}
+//
+// Lotes (ver publish_batcher.hpp), com mais de uma amostra:
+//   JSON:   array de objetos, cada um com "ts" (ms desde epoch)
+//   Packed: registros v1 concatenados (tamanho = n * STATUS_PACKED_SIZE)
+// Lote de uma amostra é codificado exatamente como uma amostra avulsa.
+//
+// Packed v1 (24 bytes, little endian):
+//   [0]  u8  versão do formato (STATUS_PACKED_VERSION)
+//   [1]  u8  estado bruto do firmware
+//   [2]  u8  alarm_active
+//   [3]  u8  reservado (0)
+//   [4]  u32 volume infundido (ml)
+//   [8]  u32 vazão configurada (ml/h)
+//   [12] u32 pressão (bruta)
+//   [16] u64 timestamp (ms desde epoch)
+
+enum class StatusEncoding
+{
+    Json,
+    Packed,
+};
+
+static constexpr uint8_t STATUS_PACKED_VERSION = 1;
+static constexpr size_t STATUS_PACKED_SIZE = 24;
+
+static constexpr const char* STATUS_CONTENT_TYPE_JSON = "application/json";
+static constexpr const char* STATUS_CONTENT_TYPE_PACKED = "application/vnd.argus.status.v1";
+
+inline StatusEncoding parse_status_encoding(const char* name)
+{
+    if(name && std::strcmp(name, "packed") == 0)
+        return StatusEncoding::Packed;
+    return StatusEncoding::Json;
+}
+
+inline const char* status_content_type(StatusEncoding enc)
+{
+    return enc == StatusEncoding::Packed ? STATUS_CONTENT_TYPE_PACKED : STATUS_CONTENT_TYPE_JSON;
+}
+
+// Tabela de estados do firmware (índice = estado bruto). 8..10 são variantes de alarme.
+static constexpr std::string_view STATE_NAMES[] = {
+    "POWER_ON", "IDLE", "RUNNING", "BOLUS", "PURGE", "PAUSED", "KVO", "END", "ALARM", "ALARM", "ALARM", "OFF",
+};
+
+static constexpr size_t STATE_NAMES_COUNT = sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0]);
+
+// Pior caso: {"state":"UNKNOWN(255)","infused_volume_ml":4294967295,"real_rate_ml_h":4294967295,
+//             "ts":18446744073709551615}
+static constexpr size_t STATUS_JSON_MAX = 160;
+
+// ============================================================
+// Writer JSON sem DOM e sem alocação
+// ============================================================
+//
+// Formata direto num buffer fixo com std::to_chars. A saída é idêntica
+// byte a byte à do boost::json::serialize sobre o objeto equivalente
+// (mesma ordem de chaves, sem espaços, inteiros em decimal).
+
+class StatusJsonWriter
+{
+public:
+    // Retorna o JSON como view sobre o buffer interno (válida até a próxima chamada)
+    // with_ts: inclui o timestamp (usado nos lotes)
+    std::string_view write(const StatusSample& s, bool with_ts = false)
+    {
+        _pos = 0;
+        put("{\"state\":\"");
+        put_state(s.state);
+        put("\",\"infused_volume_ml\":");
+        put_uint(s.volume);
+        put(",\"real_rate_ml_h\":");
+        put_uint(s.flow_rate);
+        if(with_ts)
+        {
+            put(",\"ts\":");
+            put_uint(s.timestamp_ms);
+        }
+        put("}");
+        return std::string_view(_buf.data(), _pos);
+    }
+
+private:
+    std::array<char, STATUS_JSON_MAX> _buf;
+    size_t _pos = 0;
+
+    void put(std::string_view text)
+    {
+        std::memcpy(_buf.data() + _pos, text.data(), text.size());
+        _pos += text.size();
+    }
+
+    void put_uint(uint64_t value)
+    {
+        auto res = std::to_chars(_buf.data() + _pos, _buf.data() + _buf.size(), value);
+        _pos = res.ptr - _buf.data();
+    }
+
+    void put_state(uint8_t state)
+    {
+        if(state < STATE_NAMES_COUNT)
+        {
+            put(STATE_NAMES[state]);
+            return;
+        }
+
+        put("UNKNOWN(");
+        put_uint(state);
+        put(")");
+    }
+};
+
+inline std::string encode_status_json(const StatusSample& s)
+{
+    // O async_publish do MQTT exige std::string: única alocação do caminho
+    StatusJsonWriter writer;
+    return std::string(writer.write(s));
+}
+
+inline void encode_status_packed(const StatusSample& s, uint8_t* out)
+{
+    uint8_t* p = out;
+    utl_io_put8_tl_ap(STATUS_PACKED_VERSION, p);
+    utl_io_put8_tl_ap(s.state, p);
+    utl_io_put8_tl_ap(s.alarm, p);
+    utl_io_put8_tl_ap(0, p);
+    utl_io_put32_tl_ap(s.volume, p);
+    utl_io_put32_tl_ap(s.flow_rate, p);
+    utl_io_put32_tl_ap(s.pressure, p);
+    utl_io_put64_tl_ap(s.timestamp_ms, p);
+}
+
+inline StatusSample decode_status_packed(const uint8_t* in)
+{
+    uint8_t* p = const_cast<uint8_t*>(in);
+    StatusSample s;
+
+    utl_io_get8_fl_ap(p); // versão (só existe a v1)
+    s.state = utl_io_get8_fl_ap(p);
+    s.alarm = utl_io_get8_fl_ap(p);
+    utl_io_get8_fl_ap(p); // reservado
+    s.volume = utl_io_get32_fl_ap(p);
+    s.flow_rate = utl_io_get32_fl_ap(p);
+    s.pressure = utl_io_get32_fl_ap(p);
+    s.timestamp_ms = utl_io_get64_fl_ap(p);
+    return s;
+}
+
+inline std::string encode_status(StatusEncoding enc, const StatusSample& s)
+{
+    if(enc == StatusEncoding::Json)
+        return encode_status_json(s);
+
+    std::string out(STATUS_PACKED_SIZE, '\0');
+    encode_status_packed(s, reinterpret_cast<uint8_t*>(&out[0]));
+    return out;
+}
+
+// Lote sempre no formato de lote (array JSON com "ts" / registros packed),
+// mesmo com uma amostra só. Usado no replay do spool.
+inline std::string encode_status_records(StatusEncoding enc, const std::vector<StatusSample>& batch)
+{
+    std::string out;
+
+    if(enc == StatusEncoding::Packed)
+    {
+        out.resize(batch.size() * STATUS_PACKED_SIZE);
+        uint8_t* p = reinterpret_cast<uint8_t*>(&out[0]);
+        for(const auto& s : batch)
+        {
+            encode_status_packed(s, p);
+            p += STATUS_PACKED_SIZE;
+        }
+        return out;
+    }
+
+    StatusJsonWriter writer;
+    out.reserve(batch.size() * (STATUS_JSON_MAX + 1) + 2);
+    out.push_back('[');
+    for(size_t i = 0; i < batch.size(); i++)
+    {
+        if(i > 0)
+            out.push_back(',');
+        out.append(writer.write(batch[i], true));
+    }
+    out.push_back(']');
+    return out;
+}
+
+inline std::string encode_status_batch(StatusEncoding enc, const std::vector<StatusSample>& batch)
+{
+    if(batch.size() == 1)
+        return encode_status(enc, batch.front());
+
+    return encode_status_records(enc, batch);
+}
+
+#endif
@@ -0,0 +1,317 @@
+#ifndef STATUS_STREAMS_HPP
+#define STATUS_STREAMS_HPP
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "infusion_manager.hpp"
+#include "status_codec.hpp"
+#include "publish_batcher.hpp"
+
+// ============================================================
+// Streams de status com taxas diferentes
+// ============================================================
+//
+// Uma única amostragem (o polling do InfusionManager) alimenta vários
+// tópicos, cada um com sua decimação, agregação e formato. Ex.: nuvem a
+// 1 Hz com média, display local a 20 Hz com a última amostra, analytics
+// com as amostras brutas.
+//
+// Configuração (ARGUS_STATUS_STREAMS), streams separados por ';':
+//   <sufixo>:<periodo_ms>:<agregacao>[:<formato>[:<lote>]]
+//   ex.: cloud:1000:avg:packed;ui:50:last:json;raw:0:raw:packed:50:1000
+// Tópico = tópico de status do canal + "/" + sufixo (bomba/status/cloud).
+// agregação: raw | last | avg | minmax. Período 0 = toda amostra (raw).
+// O lote usa o formato de ARGUS_STATUS_BATCH (ver publish_batcher.hpp).
+//
+// O bomba/status legado continua existindo (raw, ARGUS_STATUS_FORMAT).
+//
+// Agregação incremental (O(1) por amostra e por stream, sem guardar a
+// janela); a codificação só acontece quando o lote fecha:
+//   last:   última amostra da janela
+//   avg:    vazão e pressão médias; estado, alarme, volume e ts da última
+//   minmax: as amostras de pressão mínima e máxima da janela, em ordem de
+//           tempo (preserva o envelope para gráficos)
+// A primeira amostra e cada mudança de estado/alarme fecham a janela em
+// curso e saem na hora, sem agregação.
+//
+// Só acessado na thread do io_context.
+
+enum class StreamAggregate
+{
+    Raw,
+    Last,
+    Average,
+    MinMax,
+};
+
+struct StatusStreamSpec
+{
+    std::string suffix;
+    uint32_t period_ms = 0;
+    StreamAggregate aggregate = StreamAggregate::Raw;
+    StatusEncoding encoding = StatusEncoding::Json;
+    BatchPolicy batch;
+};
+
+inline bool parse_stream_aggregate(const std::string& name, StreamAggregate& out)
+{
+    if(name == "raw")
+        out = StreamAggregate::Raw;
+    else if(name == "last")
+        out = StreamAggregate::Last;
+    else if(name == "avg")
+        out = StreamAggregate::Average;
+    else if(name == "minmax")
+        out = StreamAggregate::MinMax;
+    else
+        return false;
+    return true;
+}
+
+// Entradas inválidas são ignoradas (com log); o resto da lista segue valendo
+inline std::vector<StatusStreamSpec> parse_status_streams(const char* spec)
+{
+    std::vector<StatusStreamSpec> streams;
+    if(!spec || !*spec)
+        return streams;
+
+    std::string list(spec);
+    size_t start = 0;
+
+    while(start <= list.size())
+    {
+        size_t end = list.find(';', start);
+        if(end == std::string::npos)
+            end = list.size();
+
+        std::string entry = list.substr(start, end - start);
+        start = end + 1;
+        if(entry.empty())
+            continue;
+
+        std::vector<std::string> fields;
+        size_t pos = 0;
+        for(int i = 0; i < 4; i++)
+        {
+            size_t colon = entry.find(':', pos);
+            if(colon == std::string::npos)
+                break;
+            fields.push_back(entry.substr(pos, colon - pos));
+            pos = colon + 1;
+        }
+        fields.push_back(entry.substr(pos)); // o resto (o lote pode conter ':')
+
+        StatusStreamSpec stream;
+        char* num_end = nullptr;
+
+        bool ok = fields.size() >= 3 && !fields[0].empty() && fields[0].find('/') == std::string::npos;
+        if(ok)
+        {
+            stream.suffix = fields[0];
+            stream.period_ms = static_cast<uint32_t>(std::strtoul(fields[1].c_str(), &num_end, 10));
+            ok = num_end != fields[1].c_str() && *num_end == '\0' &&
+                 parse_stream_aggregate(fields[2], stream.aggregate);
+        }
+
+        if(ok && fields.size() >= 4)
+            stream.encoding = parse_status_encoding(fields[3].c_str());
+
+        if(ok && fields.size() >= 5)
+            stream.batch = parse_batch_policy(fields[4].c_str());
+
+        // raw não agrega; período sem agregação não faz sentido
+        if(ok && stream.aggregate == StreamAggregate::Raw)
+            stream.period_ms = 0;
+        if(ok && stream.period_ms == 0)
+            stream.aggregate = StreamAggregate::Raw;
+
+        if(!ok)
+        {
+            std::cerr << "[STREAM] Entrada invalida em ARGUS_STATUS_STREAMS: '" << entry << "'\n";
+            continue;
+        }
+
+        streams.push_back(stream);
+    }
+
+    return streams;
+}
+
+// ============================================================
+// Agregador de uma janela
+// ============================================================
+
+class StatusAggregator
+{
+public:
+    StatusAggregator(StreamAggregate aggregate, uint32_t period_ms) : _aggregate(aggregate), _period_ms(period_ms)
+    {
+    }
+
+    // Máximo de amostras produzidas por push(): janela fechada (até 2 no
+    // minmax) + a amostra de mudança de estado
+    static constexpr size_t MAX_OUT = 3;
+
+    // Acumula a amostra; escreve em 'out' o que deve ser publicado agora e
+    // retorna quantas
+    size_t push(const StatusSample& s, StatusSample out[MAX_OUT])
+    {
+        if(_aggregate == StreamAggregate::Raw)
+        {
+            out[0] = s;
+            return 1;
+        }
+
+        // Primeira amostra e mudança de estado/alarme saem na hora, fora da
+        // média: o consumidor vê a transição sem esperar o período
+        bool urgent = !_has_last || s.state != _last.state || s.alarm != _last.alarm;
+        _last = s;
+        _has_last = true;
+
+        if(urgent)
+        {
+            size_t n = _count > 0 ? close(out) : 0;
+            out[n++] = s;
+            return n;
+        }
+
+        // A amostra que cai além do período fecha a janela anterior e abre a
+        // próxima (relógio de parede voltando, p.ex. ajuste de NTP, também fecha)
+        size_t n = 0;
+        if(_count > 0 && (s.timestamp_ms < _window_start || s.timestamp_ms - _window_start >= _period_ms))
+            n = close(out);
+
+        if(_count == 0)
+        {
+            _window_start = s.timestamp_ms;
+            _flow_sum = 0;
+            _pressure_sum = 0;
+            _min = s;
+            _max = s;
+            _min_seq = 0;
+            _max_seq = 0;
+        }
+
+        if(s.pressure < _min.pressure)
+        {
+            _min = s;
+            _min_seq = _count;
+        }
+        if(s.pressure > _max.pressure)
+        {
+            _max = s;
+            _max_seq = _count;
+        }
+
+        _count++;
+        _tail = s;
+        _flow_sum += s.flow_rate;
+        _pressure_sum += s.pressure;
+
+        return n;
+    }
+
+private:
+    StreamAggregate _aggregate;
+    uint32_t _period_ms;
+
+    bool _has_last = false;
+    StatusSample _last{};
+
+    // Janela corrente
+    uint32_t _count = 0;
+    uint64_t _window_start = 0;
+    uint64_t _flow_sum = 0;
+    uint64_t _pressure_sum = 0;
+    StatusSample _tail{}; // última amostra da janela
+    StatusSample _min{};
+    StatusSample _max{};
+    uint32_t _min_seq = 0; // posição na janela (ordem de tempo)
+    uint32_t _max_seq = 0;
+
+    size_t close(StatusSample* out)
+    {
+        size_t n = 1;
+
+        switch(_aggregate)
+        {
+            case StreamAggregate::Average:
+                out[0] = _tail;
+                out[0].flow_rate = static_cast<uint32_t>(_flow_sum / _count);
+                out[0].pressure = static_cast<uint32_t>(_pressure_sum / _count);
+                break;
+
+            case StreamAggregate::MinMax:
+                if(_min_seq == _max_seq)
+                    out[0] = _min;
+                else
+                {
+                    out[0] = _min_seq < _max_seq ? _min : _max;
+                    out[1] = _min_seq < _max_seq ? _max : _min;
+                    n = 2;
+                }
+                break;
+
+            default:
+                out[0] = _tail;
+                break;
+        }
+
+        _count = 0;
+        return n;
+    }
+};
+
+// ============================================================
+// Stream = agregador + lote + tópico
+// ============================================================
+
+class StatusStream
+{
+public:
+    using PublishFn = std::function<void(const StatusStream&, const std::vector<StatusSample>&)>;
+
+    StatusStream(boost::asio::io_context& io, const StatusStreamSpec& spec, std::string topic, PublishFn publish)
+        : _spec(spec), _topic(std::move(topic)), _aggregator(spec.aggregate, spec.period_ms),
+          _batcher(io, spec.batch, [this, publish](const std::vector<StatusSample>& batch) { publish(*this, batch); },
+                   [](const StatusSample& prev, const StatusSample& cur) {
+                       return cur.state != prev.state || cur.alarm != prev.alarm;
+                   })
+    {
+    }
+
+    StatusStream(const StatusStream&) = delete;
+    StatusStream& operator=(const StatusStream&) = delete;
+
+    void push(const StatusSample& sample)
+    {
+        StatusSample out[StatusAggregator::MAX_OUT];
+        size_t n = _aggregator.push(sample, out);
+        for(size_t i = 0; i < n; i++)
+            _batcher.push(out[i]);
+    }
+
+    const std::string& topic() const
+    {
+        return _topic;
+    }
+
+    StatusEncoding encoding() const
+    {
+        return _spec.encoding;
+    }
+
+private:
+    StatusStreamSpec _spec;
+    std::string _topic;
+    StatusAggregator _aggregator;
+    PublishBatcher<StatusSample> _batcher;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef TELEMETRY_SPOOL_HPP
+#define TELEMETRY_SPOOL_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "status_codec.hpp"
+
+// ============================================================
+// Spool de telemetria (store-and-forward)
+// ============================================================
+//
+// Enquanto o broker está inacessível, as amostras de status vão para um
+// anel de tamanho fixo num arquivo mapeado em memória na partição de dados
+// (o rootfs é read-only). Cada registro é uma amostra packed v1 (24 bytes,
+// ver status_codec.hpp), então o replay pode reagrupar em lotes grandes.
+//
+// Limitado: com o anel cheio, a amostra mais antiga é sobrescrita (contada
+// em 'dropped'). head/tail são contadores monotônicos gravados depois do
+// registro; após um crash perde-se no máximo o registro em escrita.
+//
+// Só acessado na thread do io_context.
+
+static constexpr uint32_t SPOOL_MAGIC = 0x4c4f5053; // "SPOL"
+static constexpr uint32_t SPOOL_VERSION = 1;
+
+class TelemetrySpool
+{
+public:
+    TelemetrySpool() = default;
+
+    ~TelemetrySpool()
+    {
+        close();
+    }
+
+    TelemetrySpool(const TelemetrySpool&) = delete;
+    TelemetrySpool& operator=(const TelemetrySpool&) = delete;
+
+    // Abre (ou cria) o spool. Conteúdo pendente de uma execução anterior é
+    // preservado se o formato e a capacidade baterem.
+    bool open(const std::string& path, uint32_t capacity)
+    {
+        if(capacity == 0)
+            return false;
+
+        // Diretório na partição de dados (ex.: /data/argus)
+        std::string::size_type slash = path.rfind('/');
+        if(slash != std::string::npos && slash > 0)
+            ::mkdir(path.substr(0, slash).c_str(), 0755);
+
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if(fd < 0)
+        {
+            std::cerr << "[SPOOL] Falha ao abrir " << path << ": " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        const size_t size = sizeof(Header) + size_t(capacity) * STATUS_PACKED_SIZE;
+
+        struct stat st;
+        bool fresh = fstat(fd, &st) != 0 || size_t(st.st_size) != size;
+
+        if(fresh && ftruncate(fd, size) != 0)
+        {
+            std::cerr << "[SPOOL] ftruncate falhou: " << std::strerror(errno) << "\n";
+            ::close(fd);
+            return false;
+        }
+
+        void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+
+        if(addr == MAP_FAILED)
+        {
+            std::cerr << "[SPOOL] mmap falhou: " << std::strerror(errno) << "\n";
+            return false;
+        }
+
+        _map = static_cast<uint8_t*>(addr);
+        _size = size;
+        _header = reinterpret_cast<Header*>(_map);
+        _records = _map + sizeof(Header);
+
+        if(fresh || _header->magic != SPOOL_MAGIC || _header->version != SPOOL_VERSION ||
+           _header->capacity != capacity || _header->head - _header->tail > capacity)
+        {
+            std::memset(_header, 0, sizeof(Header));
+            _header->magic = SPOOL_MAGIC;
+            _header->version = SPOOL_VERSION;
+            _header->capacity = capacity;
+        }
+
+        std::cout << "[SPOOL] " << path << ": " << capacity << " registros, " << pending() << " pendentes\n";
+        return true;
+    }
+
+    void close()
+    {
+        if(!_map)
+            return;
+
+        msync(_map, _size, MS_SYNC);
+        munmap(_map, _size);
+        _map = nullptr;
+        _header = nullptr;
+    }
+
+    bool is_open() const
+    {
+        return _map != nullptr;
+    }
+
+    size_t pending() const
+    {
+        return _header ? size_t(_header->head - _header->tail) : 0;
+    }
+
+    uint64_t dropped() const
+    {
+        return _header ? _header->dropped : 0;
+    }
+
+    void append(const StatusSample& s)
+    {
+        if(!_header)
+            return;
+
+        // Cheio: descarta a mais antiga
+        if(_header->head - _header->tail >= _header->capacity)
+        {
+            _header->tail++;
+            _header->dropped++;
+        }
+
+        encode_status_packed(s, slot(_header->head));
+        _header->head++;
+    }
+
+    // Copia até 'max' amostras, da mais antiga para a mais nova (sem consumir).
+    // Retorna o índice absoluto da primeira, para release().
+    uint64_t peek(std::vector<StatusSample>& out, size_t max) const
+    {
+        out.clear();
+        if(!_header)
+            return 0;
+
+        size_t n = std::min(pending(), max);
+        for(size_t i = 0; i < n; i++)
+            out.push_back(decode_status_packed(slot(_header->tail + i)));
+        return _header->tail;
+    }
+
+    // Confirma o envio de [first, first + n). Se o anel sobrescreveu parte do
+    // lote enquanto ele estava em voo, o tail já passou e nada é perdido a mais.
+    void release(uint64_t first, size_t n)
+    {
+        if(!_header)
+            return;
+
+        uint64_t end = std::min<uint64_t>(first + n, _header->head);
+        if(end > _header->tail)
+            _header->tail = end;
+
+        // Esvaziou: persiste o estado sem esperar o writeback do kernel
+        if(pending() == 0)
+            msync(_map, sizeof(Header), MS_ASYNC);
+    }
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity; // em registros
+        uint32_t reserved;
+        uint64_t head;    // próximo registro a gravar (monotônico)
+        uint64_t tail;    // mais antigo ainda não reenviado (monotônico)
+        uint64_t dropped; // sobrescritos com o anel cheio
+    };
+
+    uint8_t* _map = nullptr;
+    size_t _size = 0;
+    Header* _header = nullptr;
+    uint8_t* _records = nullptr;
+
+    uint8_t* slot(uint64_t index) const
+    {
+        return _records + (index % _header->capacity) * STATUS_PACKED_SIZE;
+    }
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "device_registry.hpp"
+#include "firmware_store.hpp"
+#include "ota_journal.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+static constexpr const char* GPIO_CHIP = "/dev/gpiochip0";
+
+// ============================================================
+// Configuração
+// ============================================================
+
+static bool parse_line(const std::string& text, unsigned int& out)
+{
+    if(text.empty())
+        return false;
+
+    char* end = nullptr;
+    unsigned long value = std::strtoul(text.c_str(), &end, 10);
+    if(*end != '\0')
+        return false;
+
+    out = static_cast<unsigned int>(value);
+    return true;
+}
+
+std::vector<ChannelConfig> parse_channel_configs(const char* spec)
+{
+    std::vector<ChannelConfig> configs;
+
+    if(!spec || !*spec)
+    {
+        configs.emplace_back();
+        return configs;
+    }
+
+    std::stringstream channels(spec);
+    std::string entry;
+
+    while(std::getline(channels, entry, ';'))
+    {
+        if(entry.empty())
+            continue;
+
+        std::stringstream fields(entry);
+        std::string id, node, ready, reset;
+
+        std::getline(fields, id, ':');
+        std::getline(fields, node, ':');
+        std::getline(fields, ready, ':');
+        std::getline(fields, reset, ':');
+
+        ChannelConfig cfg;
+        cfg.id = id;
+        cfg.spi_node = node;
+
+        if(id.empty() || node.empty() || !parse_line(ready, cfg.ready_line) || !parse_line(reset, cfg.reset_line))
+        {
+            std::cerr << "[REGISTRY] Canal invalido: '" << entry << "'" << std::endl;
+            return {};
+        }
+
+        for(const auto& other : configs)
+        {
+            if(other.id == cfg.id || other.spi_node == cfg.spi_node)
+            {
+                std::cerr << "[REGISTRY] Canal duplicado: '" << entry << "'" << std::endl;
+                return {};
+            }
+        }
+
+        configs.push_back(cfg);
+    }
+
+    return configs;
+}
+
+// ============================================================
+// Ciclo de vida
+// ============================================================
+
+DeviceRegistry::DeviceRegistry(boost::asio::io_context& io, const std::vector<ChannelConfig>& configs,
+                               uint32_t spi_speed_hz, uint32_t monitor_period_ms)
+{
+    // Canal único não precisa de arbitragem (comportamento original)
+    SpiBusArbiter* arbiter = configs.size() > 1 ? &_arbiter : nullptr;
+
+    for(const auto& cfg : configs)
+    {
+        auto ch = std::make_unique<PumpChannel>();
+        ch->config = cfg;
+
+        ch->spi = std::make_unique<HalSpi>(cfg.spi_node.c_str(), spi_speed_hz);
+        ch->ready_pin = std::make_unique<HalGpio>(cfg.ready_line, HalGpio::Direction::Input, HalGpio::Edge::Rising,
+                                                  false, GPIO_CHIP);
+        ch->reset_pin = std::make_unique<HalGpio>(cfg.reset_line, HalGpio::Direction::Output, HalGpio::Edge::None,
+                                                  false, GPIO_CHIP);
+        ch->reset_pin->set(true);
+
+        ch->bridge = std::make_unique<Stm32Bridge>(*ch->spi, *ch->ready_pin, arbiter);
+        ch->manager = std::make_unique<InfusionManager>(*ch->bridge, *ch->reset_pin, io, monitor_period_ms);
+
+        // Um diário e um diretório de imagens de OTA por canal (mesmo sufixo do spool)
+        if(!cfg.id.empty())
+        {
+            ch->manager->set_ota_journal(std::string(OTA_JOURNAL_PATH) + "." + cfg.id);
+            ch->manager->set_ota_store(std::string(FIRMWARE_STORE_DIR) + "/" + cfg.id);
+        }
+
+        std::cout << "[REGISTRY] Canal '" << (cfg.id.empty() ? "-" : cfg.id) << "': " << cfg.spi_node << ", READY "
+                  << cfg.ready_line << ", RESET " << cfg.reset_line << std::endl;
+
+        _channels.push_back(std::move(ch));
+    }
+}
+
+DeviceRegistry::~DeviceRegistry()
+{
+    stop_all();
+}
+
+void DeviceRegistry::start_all()
+{
+    for(auto& ch : _channels)
+        ch->manager->start();
+}
+
+void DeviceRegistry::stop_all()
+{
+    for(auto& ch : _channels)
+        ch->manager->stop();
+}
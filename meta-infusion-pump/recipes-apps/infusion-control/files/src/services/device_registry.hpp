@@ -0,0 +1,75 @@
+#ifndef DEVICE_REGISTRY_HPP
+#define DEVICE_REGISTRY_HPP
+
+#include "hal_spi.hpp"
+#include "hal_gpio.hpp"
+#include "stm32_bridge.hpp"
+#include "spi_bus_arbiter.hpp"
+#include "infusion_manager.hpp"
+#include <boost/asio.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================================================
+// Canais de bomba (um STM32 por chip select)
+// ============================================================
+//
+// Um Pi pode dirigir várias bombas no mesmo controlador SPI. Cada canal
+// tem seu spidev (chip select), linha READY e linha de RESET próprios,
+// e vira um par Stm32Bridge/InfusionManager independente. Os bridges
+// compartilham um SpiBusArbiter.
+//
+// Configuração (ARGUS_CHANNELS), canais separados por ';':
+//   <id>:<spidev>:<gpio_ready>:<gpio_reset>
+//   ex.: "1:/dev/spidev0.0:25:4;2:/dev/spidev0.1:24:17"
+// Sem configuração: um canal sem id (tópicos legados bomba/...).
+
+struct ChannelConfig
+{
+    std::string id; // vazio = canal único legado
+    std::string spi_node = "/dev/spidev0.0";
+    unsigned int ready_line = 25;
+    unsigned int reset_line = 4;
+};
+
+// Retorna vazio em erro de sintaxe
+std::vector<ChannelConfig> parse_channel_configs(const char* spec);
+
+struct PumpChannel
+{
+    ChannelConfig config;
+
+    std::unique_ptr<HalSpi> spi;
+    std::unique_ptr<HalGpio> ready_pin;
+    std::unique_ptr<HalGpio> reset_pin;
+    std::unique_ptr<Stm32Bridge> bridge;
+    std::unique_ptr<InfusionManager> manager;
+};
+
+class DeviceRegistry
+{
+public:
+    DeviceRegistry(boost::asio::io_context& io, const std::vector<ChannelConfig>& configs, uint32_t spi_speed_hz,
+                   uint32_t monitor_period_ms);
+    ~DeviceRegistry();
+
+    void start_all();
+    void stop_all();
+
+    std::vector<std::unique_ptr<PumpChannel>>& channels()
+    {
+        return _channels;
+    }
+
+    const SpiBusArbiter& arbiter() const
+    {
+        return _arbiter;
+    }
+
+private:
+    SpiBusArbiter _arbiter;
+    std::vector<std::unique_ptr<PumpChannel>> _channels;
+};
+
+#endif
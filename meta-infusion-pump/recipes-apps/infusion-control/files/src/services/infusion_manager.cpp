@@ -1,51 +1,48 @@
 #include "infusion_manager.hpp"
+#include "bridge_ota_link.hpp"
+#include "ota_job.hpp"
 #include <iostream>
 #include <chrono>
 #include <cstring>
-#include <cstdlib>
-#include <sys/wait.h>
-#include <boost/json.hpp>
 
-// ============================================================
-// Utils
-// ============================================================
-
-static std::string state_to_string(uint8_t state)
+extern "C"
 {
-    switch(state)
-    {
-    case 0:
-        return "POWER_ON";
-    case 1:
-        return "IDLE";
-    case 2:
-        return "RUNNING";
-    case 3:
-        return "BOLUS";
-    case 4:
-        return "PURGE";
-    case 5:
-        return "PAUSED";
-    case 6:
-        return "KVO";
-    case 7:
-        return "END";
-    case 8:
-    case 9:
-    case 10:
-        return "ALARM";
-    case 11:
-        return "OFF";
-    default:
-        return "UNKNOWN(" + std::to_string(state) + ")";
-    }
+#include "utl_crc16.h"
 }
 
 // ============================================================
 // Ciclo de vida
 // ============================================================
 
-InfusionManager::InfusionManager(Stm32Bridge& bridge, HalGpio& reset_pin) : _bridge(bridge), _reset_pin(reset_pin) {}
+static uint32_t clamp_monitor_period(uint32_t period_ms)
+{
+    return period_ms < MONITOR_PERIOD_MIN_MS ? MONITOR_PERIOD_MIN_MS : period_ms;
+}
+
+static PressureAnalyzer::Config pressure_dsp_config(uint32_t period_ms)
+{
+    PressureAnalyzer::Config cfg;
+    cfg.sample_rate_hz = 1000.0f / period_ms;
+    return cfg;
+}
+
+// Pós-OTA o bootloader valida e troca o banco antes de subir (30s ~ 1min30s)
+static constexpr std::chrono::seconds OTA_BOOT_TIMEOUT{90};
+
+// Clock da negociação do OTA (o mesmo do stm32-updater; o bootloader legado não passa disso)
+static constexpr uint32_t OTA_NEGOTIATION_HZ = 100000;
+
+InfusionManager::InfusionManager(Stm32Bridge& bridge, HalGpio& reset_pin, boost::asio::io_context& io,
+                                 uint32_t monitor_period_ms)
+    : _bridge(bridge), _reset_pin(reset_pin), _io(io),
+      _monitor_period(clamp_monitor_period(monitor_period_ms)), _ota_journal(OTA_JOURNAL_PATH),
+      _ota_store(FIRMWARE_STORE_DIR),
+      _recovery(io, reset_pin, bridge.ready_line(), [this](McuRecovery::ProbeReply reply) { request_probe(reply); }),
+      _pressure_dsp(pressure_dsp_config(_monitor_period.count()))
+{
+    std::cout << "[MANAGER] Polling de status a cada " << _monitor_period.count() << " ms\n";
+    std::cout << "[MANAGER] DSP de pressao: kernels " << dsp_kernels().name << "\n";
+}
 
 InfusionManager::~InfusionManager()
 {
@@ -60,11 +57,17 @@ void InfusionManager::start()
     _running = true;
     _monitor_thread = std::thread(&InfusionManager::monitor_loop, this);
     std::cout << "[MANAGER] Monitor iniciado\n";
+
+    announce_pending_ota();
 }
 
 void InfusionManager::stop()
 {
-    _running = false;
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _running = false;
+    }
+    _wake_cv.notify_all();
 
     if(_monitor_thread.joinable())
         _monitor_thread.join();
@@ -76,6 +79,24 @@ void InfusionManager::set_status_callback(StatusCallback cb)
     _status_cb = cb;
 }
 
+void InfusionManager::add_status_listener(StatusCallback cb)
+{
+    std::lock_guard<std::mutex> lock(_spi_mutex);
+    _status_listeners.push_back(std::move(cb));
+}
+
+void InfusionManager::set_pressure_callback(PressureCallback cb)
+{
+    std::lock_guard<std::mutex> lock(_spi_mutex);
+    _pressure_cb = cb;
+}
+
+void InfusionManager::set_ota_progress_callback(OtaProgressCallback cb)
+{
+    std::lock_guard<std::mutex> lock(_spi_mutex);
+    _ota_cb = cb;
+}
+
 // ============================================================
 // Monitoramento STM32
 // ============================================================
@@ -85,47 +106,22 @@ void InfusionManager::monitor_loop()
     while(_running)
     {
         // ============================================
-        // Aguardando STM32 voltar após OTA
+        // Manutenção (reset / OTA): o monitor só executa
+        // os probes pedidos pela McuRecovery
         // ============================================
-        if (_waiting_mcu)
+        if(_maintenance_mode)
         {
-            cmd_cmds_t req{}, res{};
-
-            bool ok = false;
-
+            McuRecovery::ProbeReply reply;
             {
-                std::lock_guard<std::mutex> lock(_spi_mutex);
-                ok = _bridge.send_command(CMD_GET_STATUS_REQ_ID, &req, &res);
-            }
-
-            if (ok)
-            {
-                auto state = res.status_res.status_data.current_state;
-
-                if (state == 0 || state == 1) // POWER_ON ou IDLE
-                {
-                    std::cout << "[OTA] STM32 boot concluído\n";
-
-                    _waiting_mcu = false;
-                    _ota_running = false;
-                    _maintenance_mode = false;
-
-                    std::lock_guard<std::mutex> lock(_spi_mutex);
-                    _bridge.resume_hardware();
-                }
+                std::unique_lock<std::mutex> lock(_wake_mutex);
+                _wake_cv.wait_for(lock, std::chrono::milliseconds(500),
+                                  [this] { return !_running || _probe_reply || !_maintenance_mode; });
+                reply = std::move(_probe_reply);
+                _probe_reply = nullptr;
             }
 
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-            continue;
-        }
-
-
-        // ============================================
-        // Manutenção normal
-        // ============================================
-        if(_maintenance_mode)
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            if(reply)
+                reply(probe_mcu());
             continue;
         }
 
@@ -134,71 +130,126 @@ void InfusionManager::monitor_loop()
         bool ok;
         {
             std::lock_guard<std::mutex> lock(_spi_mutex);
-            ok = _bridge.send_command(CMD_GET_STATUS_REQ_ID, &req, &res);
+            ok = _bridge.send_command(CMD_GET_STATUS_REQ_ID, &req, &res, SpiPriority::Poll);
         }
 
         // ============================================
         // Monitoramento normal
         // ============================================
 
-        if(ok && _status_cb)
+        if(ok && (_status_cb || !_status_listeners.empty()))
         {
             auto& s = res.status_res.status_data;
 
-            boost::json::object json;
-            json["state"] = state_to_string(s.current_state);
-            json["infused_volume_ml"] = s.volume;
-            json["real_rate_ml_h"] = s.flow_rate_set;
+            StatusSample sample;
+            sample.state = s.current_state;
+            sample.alarm = s.alarm_active;
+            sample.volume = s.volume;
+            sample.flow_rate = s.flow_rate_set;
+            sample.pressure = s.pressure;
+            sample.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                      std::chrono::system_clock::now().time_since_epoch())
+                                      .count();
+
+            for(auto& listener : _status_listeners)
+                listener(sample);
+
+            if(_status_cb)
+                _status_cb(sample);
+        }
 
-            _status_cb(boost::json::serialize(json));
+        if(ok)
+        {
+            PressureAnalysis analysis;
+            if(_pressure_dsp.push(res.status_res.status_data.pressure, analysis) && _pressure_cb)
+                _pressure_cb(analysis);
         }
 
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        wait_monitor_period();
     }
 }
 
+void InfusionManager::wake_monitor()
+{
+    // Passa pelo mutex para não perder o aviso entre o teste do predicado e o wait
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+    }
+    _wake_cv.notify_all();
+}
+
+void InfusionManager::wait_monitor_period()
+{
+    // Interrompível: stop() e entrada em manutenção não esperam o próximo tick
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    _wake_cv.wait_for(lock, _monitor_period,
+                      [this] { return !_running || _maintenance_mode; });
+}
+
 // ============================================================
 // Comandos
 // ============================================================
 
+bool InfusionManager::send_timed(cmd_ids_t req_id, cmd_cmds_t* req, cmd_cmds_t* res)
+{
+    auto started = std::chrono::steady_clock::now();
+    bool ok = _bridge.send_command(req_id, req, res);
+    auto elapsed = std::chrono::steady_clock::now() - started;
+
+    _command_rtt_us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    return ok;
+}
+
 CommandStatus InfusionManager::start_infusion()
 {
+    if(_maintenance_mode)
+        return CMD_ERR_INVALID_STATE;
+
     cmd_cmds_t req{}, res{};
 
     std::lock_guard<std::mutex> lock(_spi_mutex);
 
-    if(!_bridge.send_command(CMD_ACTION_RUN_REQ_ID, &req, &res))
-        return res.action_res.status;
+    if(!send_timed(CMD_ACTION_RUN_REQ_ID, &req, &res))
+        return CMD_TRANSPORT_ERROR;
 
     return static_cast<CommandStatus>(res.action_res.status);
 }
 
 CommandStatus InfusionManager::pause_infusion()
 {
+    if(_maintenance_mode)
+        return CMD_ERR_INVALID_STATE;
+
     cmd_cmds_t req{}, res{};
 
     std::lock_guard<std::mutex> lock(_spi_mutex);
 
-    if(!_bridge.send_command(CMD_ACTION_PAUSE_REQ_ID, &req, &res))
-        return res.action_res.status;
+    if(!send_timed(CMD_ACTION_PAUSE_REQ_ID, &req, &res))
+        return CMD_TRANSPORT_ERROR;
 
     return static_cast<CommandStatus>(res.action_res.status);
 }
 
 CommandStatus InfusionManager::stop_infusion()
 {
+    if(_maintenance_mode)
+        return CMD_ERR_INVALID_STATE;
+
     cmd_cmds_t req{}, res{};
 
     std::lock_guard<std::mutex> lock(_spi_mutex);
 
-    if(!_bridge.send_command(CMD_ACTION_ABORT_REQ_ID, &req, &res))
-        return res.action_res.status;
+    if(!send_timed(CMD_ACTION_ABORT_REQ_ID, &req, &res))
+        return CMD_TRANSPORT_ERROR;
 
     return static_cast<CommandStatus>(res.action_res.status);
 }
 
 CommandStatus InfusionManager::set_config(uint32_t volume_ml, uint32_t rate_ml_h)
 {
+    if(_maintenance_mode)
+        return CMD_ERR_INVALID_STATE;
+
     cmd_cmds_t req{}, res{};
 
     req.config_req.config.volume = volume_ml;
@@ -207,21 +258,24 @@ CommandStatus InfusionManager::set_config(uint32_t volume_ml, uint32_t rate_ml_h
 
     std::lock_guard<std::mutex> lock(_spi_mutex);
 
-    if(!_bridge.send_command(CMD_SET_CONFIG_REQ_ID, &req, &res))
-        return res.action_res.status;
+    if(!send_timed(CMD_SET_CONFIG_REQ_ID, &req, &res))
+        return CMD_TRANSPORT_ERROR;
 
     return static_cast<CommandStatus>(res.config_res.status);
 }
 
 CommandStatus InfusionManager::start_bolus(uint32_t volume_ml, uint32_t rate_ml_h)
 {
+    if(_maintenance_mode)
+        return CMD_ERR_INVALID_STATE;
+
     cmd_cmds_t req{}, res{};
     req.bolus_req.payload.bolus_volume = volume_ml;
     req.bolus_req.payload.bolus_rate = rate_ml_h;
 
     std::lock_guard<std::mutex> lock(_spi_mutex);
 
-    if(!_bridge.send_command(CMD_ACTION_BOLUS_REQ_ID, &req, &res))
+    if(!send_timed(CMD_ACTION_BOLUS_REQ_ID, &req, &res))
     {
         return CMD_TRANSPORT_ERROR;
     }
@@ -231,6 +285,11 @@ CommandStatus InfusionManager::start_bolus(uint32_t volume_ml, uint32_t rate_ml_
 
 CommandStatus InfusionManager::start_purge(uint32_t rate_ml_h)
 {
+    (void)rate_ml_h;   // PURGE sem payload: o firmware usa a própria vazão de purga
+
+    if(_maintenance_mode)
+        return CMD_ERR_INVALID_STATE;
+
     cmd_cmds_t req{}, res{};
 
     // req.config_req.config.volume    = 0;
@@ -245,7 +304,7 @@ CommandStatus InfusionManager::start_purge(uint32_t rate_ml_h)
     // if(res.config_res.status != CMD_OK)
     //     return res.config_res.status;
 
-    if(!_bridge.send_command(CMD_ACTION_PURGE_REQ_ID, &req, &res))
+    if(!send_timed(CMD_ACTION_PURGE_REQ_ID, &req, &res))
     {
         return CMD_TRANSPORT_ERROR;
     }
@@ -257,48 +316,203 @@ CommandStatus InfusionManager::start_purge(uint32_t rate_ml_h)
 // OTA
 // ============================================================
 
-void InfusionManager::start_ota_process(const std::string& filepath)
+CommandStatus InfusionManager::start_ota_process(const std::string& filepath, std::vector<uint8_t> image,
+                                                 uint16_t crc)
 {
-    if(_ota_running)
+    if(!enter_maintenance())
     {
-        std::cout << "[OTA] Ignorado — OTA já em andamento\n";
-        return;
+        std::cout << "[OTA] Recusado — manutenção (OTA ou reset) em andamento\n";
+        return CMD_ERR_INVALID_STATE;
     }
 
     _ota_running = true;
-    _maintenance_mode = true;
+    _ota_cancel = false;
 
-    std::thread([this, filepath]() {
+    std::thread([this, filepath, image = std::move(image), crc]() mutable {
+        OtaResult result;
+        OtaStats stats;
         {
+            // O OTA inteiro com o SPI do canal; comandos já recusam (manutenção)
             std::lock_guard<std::mutex> lock(_spi_mutex);
-            _bridge.suspend_hardware();
+
+            // Negociação no clock do stm32-updater; o v2 sobe até o do daemon
+            const uint32_t daemon_hz = _bridge.speed();
+            _bridge.set_speed(OTA_NEGOTIATION_HZ);
+
+            OtaJobConfig config;
+            config.options.max_spi_hz = daemon_hz;
+            config.journal_path = _ota_journal;
+            config.store_dir = _ota_store;
+
+            BridgeOtaLink link(_bridge);
+            OtaJob job(link, config);
+            job.set_cancel(&_ota_cancel);
+            if(!image.empty())
+                job.set_image(std::move(image), crc);
+
+            auto started = std::chrono::steady_clock::now();
+            unsigned last_pct = 101;
+            job.set_progress([&](uint32_t acked, uint32_t total) {
+                unsigned pct = unsigned(uint64_t(acked) * 100 / total);
+                if(pct == last_pct)
+                    return;
+                last_pct = pct;
+
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - started);
+
+                OtaProgress progress;
+                progress.acked = acked;
+                progress.total = total;
+                progress.elapsed_ms = uint32_t(elapsed.count());
+                if(elapsed.count() > 0)
+                    progress.bytes_per_second = uint32_t(uint64_t(acked) * 1000 / elapsed.count());
+                emit_ota(progress);
+            });
+
+            _ota_transfer = true;
+            result = job.run(filepath);
+            _ota_transfer = false;
+            stats = job.stats();
+
+            _bridge.set_speed(daemon_hz);
         }
 
-        std::string cmd = "/usr/bin/stm32-updater " + filepath;
-        int ret = std::system(cmd.c_str());
+        ota_print_summary(result, stats);
 
-        if(WEXITSTATUS(ret) == 0)
-        {
-            std::cout << "[OTA] Sucesso — aguardando swap (30s ~ 1min30s)\n";
-            _waiting_mcu = true;
-            return;
-        }
-        else
-        {
-            std::cerr << "[OTA] Falhou\n";
-            _ota_running = false;
-            _maintenance_mode = false;
-            return;
-        }
+        OtaProgress summary;
+        summary.acked = result == OtaResult::Ok ? stats.bytes : 0;
+        summary.total = stats.bytes;
+        summary.bytes_per_second = uint32_t(stats.bytes_per_second());
+        summary.elapsed_ms = uint32_t(stats.elapsed.count());
+        summary.retransmissions = stats.retransmissions;
+        summary.result = ota_result_name(result);
 
-        {
-            std::lock_guard<std::mutex> lock(_spi_mutex);
-            _bridge.resume_hardware();
-        }
+        boost::asio::post(_io, [this, result, summary]() mutable {
+            if(result != OtaResult::Ok)
+            {
+                std::cerr << "[OTA] Falhou: " << summary.result << "\n";
+                summary.phase = result == OtaResult::Cancelled ? OtaPhase::Cancelled : OtaPhase::Failed;
+                emit_ota(summary);
+                finish_maintenance(false, "OTA");
+                return;
+            }
+
+            std::cout << "[OTA] Sucesso — aguardando swap e boot do STM32\n";
+            summary.phase = OtaPhase::Booting;
+            emit_ota(summary);
 
-        _ota_running = false;
-        _maintenance_mode = false;
+            _recovery.start_boot_wait(OTA_BOOT_TIMEOUT, [this, summary](bool up) mutable {
+                summary.phase = up ? OtaPhase::Done : OtaPhase::Failed;
+                emit_ota(summary);
+                finish_maintenance(up, "OTA");
+            });
+        });
     }).detach();
+
+    return CMD_OK;
+}
+
+bool InfusionManager::cancel_ota()
+{
+    if(!_ota_transfer)
+        return false;
+
+    std::cout << "[OTA] Cancelamento pedido\n";
+    _ota_cancel = true;
+    return true;
+}
+
+void InfusionManager::emit_ota(const OtaProgress& progress)
+{
+    if(_ota_cb)
+        _ota_cb(progress);
+}
+
+// Diário deixado por um OTA que não terminou (queda do daemon, watchdog,
+// falta de energia). Nada é relançado sozinho: a subida pode ser no meio de
+// uma infusão. Só publica "resumable" no tópico ota; quem retoma é o
+// resume_ota (ou um update_firmware da mesma imagem).
+void InfusionManager::announce_pending_ota()
+{
+    OtaJournalEntry entry;
+    if(!load_pending_ota(entry))
+        return;
+
+    std::cout << "[OTA] OTA interrompido encontrado (" << entry.acked << "/" << entry.size << " bytes confirmados): "
+              << entry.image << " — aguardando resume_ota\n";
+
+    OtaProgress progress;
+    progress.phase = OtaPhase::Resumable;
+    progress.acked = entry.acked;
+    progress.total = entry.size;
+    boost::asio::post(_io, [this, progress]() { emit_ota(progress); });
+}
+
+// Diário válido só se a imagem ainda for a mesma (tamanho e CRC do START)
+bool InfusionManager::load_pending_ota(OtaJournalEntry& entry)
+{
+    OtaJournal journal(_ota_journal);
+    if(!journal.load(entry))
+        return false;
+
+    FileOtaSource image;
+    if(!image.open(entry.image))
+    {
+        std::cerr << "[OTA] Diario aponta para imagem ilegivel (" << entry.image << "), descartado\n";
+        journal.clear();
+        return false;
+    }
+
+    uint16_t crc = utl_crc16_data(image.data(0, image.size()), image.size(), 0xFFFF);
+    if(image.size() != entry.size || crc != entry.crc)
+    {
+        std::cerr << "[OTA] Imagem " << entry.image << " mudou desde o OTA interrompido (" << image.size()
+                  << " bytes, CRC " << std::hex << crc << " x " << entry.crc << std::dec << "), diario descartado\n";
+        journal.clear();
+        return false;
+    }
+
+    return true;
+}
+
+// POWER_ON ou IDLE: nada infundindo, pode trocar o banco e reiniciar o STM32
+bool InfusionManager::mcu_idle()
+{
+    cmd_cmds_t req{}, res{};
+
+    std::lock_guard<std::mutex> lock(_spi_mutex);
+
+    if(!send_timed(CMD_GET_STATUS_REQ_ID, &req, &res))
+        return false;
+
+    auto state = res.status_res.status_data.current_state;
+    return state == 0 || state == 1;
+}
+
+CommandStatus InfusionManager::resume_ota()
+{
+    if(_maintenance_mode || _ota_running)
+        return CMD_ERR_INVALID_STATE;
+
+    OtaJournalEntry entry;
+    if(!OtaJournal(_ota_journal).load(entry))
+    {
+        std::cout << "[OTA] Nada a retomar\n";
+        return CMD_ERR_INVALID_STATE;
+    }
+
+    if(!load_pending_ota(entry))
+        return CMD_ERR_CHECKSUM;
+
+    if(!mcu_idle())
+    {
+        std::cerr << "[OTA] Retomada recusada — STM32 nao esta ocioso\n";
+        return CMD_ERR_INVALID_STATE;
+    }
+
+    std::cout << "[OTA] Retomando " << entry.image << " (" << entry.acked << "/" << entry.size << " bytes)\n";
+    return start_ota_process(entry.image);
 }
 
 // ============================================================
@@ -307,21 +521,76 @@ void InfusionManager::start_ota_process(const std::string& filepath)
 
 void InfusionManager::hard_reset_stm32()
 {
+    boost::asio::post(_io, [this]() {
+        if(!enter_maintenance())
+        {
+            std::cout << "[MANAGER] Reset ignorado — manutenção em andamento\n";
+            return;
+        }
+
+        _recovery.start_reset([this](bool up) { finish_maintenance(up, "Reset"); });
+    });
+}
+
+// ============================================================
+// Manutenção
+// ============================================================
+
+void InfusionManager::request_probe(McuRecovery::ProbeReply reply)
+{
+    // Executado pela thread de monitoramento: o SPI pode bloquear lá sem travar o io_context
     {
-        std::lock_guard<std::mutex> lock(_spi_mutex);
-        _bridge.suspend_hardware();
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _probe_reply = std::move(reply);
     }
+    _wake_cv.notify_all();
+}
 
-    _reset_pin.set(false);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    _reset_pin.set(true);
+McuRecovery::ProbeResult InfusionManager::probe_mcu()
+{
+    std::lock_guard<std::mutex> lock(_spi_mutex);
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    // READY baixa: o firmware ainda não armou o SPI, não adianta esperar 5s no _safe_transfer
+    if(!_bridge.ready_line().get())
+        return McuRecovery::ProbeResult::NotReady;
 
+    cmd_cmds_t req{}, res{};
+    if(!_bridge.send_command(CMD_GET_STATUS_REQ_ID, &req, &res, SpiPriority::Poll))
+        return McuRecovery::ProbeResult::NotReady;
+
+    auto state = res.status_res.status_data.current_state;
+    if(state != 0 && state != 1) // POWER_ON ou IDLE
+        return McuRecovery::ProbeResult::NotReady;
+
+    cmd_cmds_t ver_req{}, ver_res{};
+    if(_bridge.send_command(CMD_VERSION_REQ_ID, &ver_req, &ver_res, SpiPriority::Poll))
     {
-        std::lock_guard<std::mutex> lock(_spi_mutex);
-        _bridge.resume_hardware();
+        std::cout << "[MANAGER] STM32 firmware " << int(ver_res.version_res.major) << "."
+                  << int(ver_res.version_res.minor) << "." << int(ver_res.version_res.patch) << "\n";
     }
 
-    std::cout << "[MANAGER] STM32 resetado\n";
+    return McuRecovery::ProbeResult::Up;
+}
+
+// Teste-e-marca único para reset e OTA: só um dono da manutenção por vez, e
+// só ele a encerra (finish_maintenance)
+bool InfusionManager::enter_maintenance()
+{
+    if(_maintenance_mode.exchange(true))
+        return false;
+
+    wake_monitor();
+    return true;
+}
+
+void InfusionManager::finish_maintenance(bool ok, const char* what)
+{
+    _ota_running = false;
+    _maintenance_mode = false;
+    wake_monitor();
+
+    if(ok)
+        std::cout << "[MANAGER] " << what << " concluído — STM32 online\n";
+    else
+        std::cerr << "[MANAGER] " << what << " sem confirmação do STM32 — monitor retomado\n";
 }
@@ -2,12 +2,19 @@
 #define INFUSION_MANAGER_HPP
 
 #include "stm32_bridge.hpp"
+#include "pressure_dsp.hpp"
+#include "mcu_recovery.hpp"
+#include "status_sample.hpp"
 #include "cmd.h"
+#include <boost/asio.hpp>
 #include <mutex>
+#include <condition_variable>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <string>
+#include <vector>
 
 // ============================================================
 // Tipos
@@ -20,8 +27,44 @@ using CommandStatus = uint8_t;
 // Convenção local apenas para erro de transporte
 static constexpr CommandStatus CMD_TRANSPORT_ERROR = 0xFF;
 
-// Callback de status (JSON serializado)
-using StatusCallback = std::function<void(std::string)>;
+// Callback de status (a codificação fica na camada de servidor)
+using StatusCallback = std::function<void(const StatusSample&)>;
+
+// Callback de análise de pressão (uma janela espectral concluída)
+using PressureCallback = std::function<void(const PressureAnalysis&)>;
+
+// Andamento do OTA (motor no próprio daemon, ver start_ota_process)
+enum class OtaPhase : uint8_t
+{
+    Upload,    // imagem chegando pelo MQTT (acked = bytes no staging)
+    Resumable, // diário de um OTA interrompido: espera resume_ota (acked = último ACK do diário)
+    Transfer,  // bytes confirmados pelo bootloader (a cada 1%)
+    Booting,   // imagem aceita; aguardando swap e boot do STM32
+    Done,      // STM32 voltou depois do OTA
+    Failed,
+    Cancelled, // cancel_ota() durante a transferência
+};
+
+struct OtaProgress
+{
+    OtaPhase phase = OtaPhase::Transfer;
+    uint32_t acked = 0;
+    uint32_t total = 0;
+    uint32_t bytes_per_second = 0;
+    uint32_t elapsed_ms = 0;
+    uint32_t retransmissions = 0;
+    const char* result = ""; // ota_result_name() a partir de Booting
+};
+
+using OtaProgressCallback = std::function<void(const OtaProgress&)>;
+
+struct OtaJournalEntry;
+
+// Período padrão de amostragem do monitor (também define a taxa do DSP de pressão)
+static constexpr uint32_t MONITOR_PERIOD_MS = 1000;
+
+// Limite inferior do período configurável (cada poll é uma transação SPI)
+static constexpr uint32_t MONITOR_PERIOD_MIN_MS = 20;
 
 // ============================================================
 // Classe
@@ -30,7 +73,10 @@ using StatusCallback = std::function<void(std::string)>;
 class InfusionManager
 {
 public:
-    InfusionManager(Stm32Bridge& bridge, HalGpio& reset_pin);
+    // io: onde rodam as máquinas de estado de manutenção (reset / pós-OTA)
+    // monitor_period_ms: período do polling de status (>= MONITOR_PERIOD_MIN_MS)
+    InfusionManager(Stm32Bridge& bridge, HalGpio& reset_pin, boost::asio::io_context& io,
+                    uint32_t monitor_period_ms = MONITOR_PERIOD_MS);
     ~InfusionManager();
 
     // Thread de monitoramento
@@ -40,6 +86,29 @@ public:
     // Status periódico do STM32
     void set_status_callback(StatusCallback cb);
 
+    // Consumidores adicionais do status (ex.: feed em /dev/shm), chamados na
+    // thread de monitoramento antes do callback principal. Registrar antes de start().
+    void add_status_listener(StatusCallback cb);
+
+    // Análise de forma de onda da pressão (frequência do ciclo da bomba)
+    void set_pressure_callback(PressureCallback cb);
+
+    // Andamento do OTA: Transfer na thread do OTA, o resto no io_context
+    void set_ota_progress_callback(OtaProgressCallback cb);
+
+    // Diário do OTA deste canal (padrão OTA_JOURNAL_PATH). Antes de start().
+    void set_ota_journal(std::string path)
+    {
+        _ota_journal = std::move(path);
+    }
+
+    // Imagens instaladas deste canal, base do delta (padrão FIRMWARE_STORE_DIR).
+    // Canais não podem dividir o diretório: o pending.bin de um viraria base do outro.
+    void set_ota_store(std::string dir)
+    {
+        _ota_store = std::move(dir);
+    }
+
     // --------------------------------------------------------
     // Comandos (retornam exatamente o status do firmware)
     // --------------------------------------------------------
@@ -58,30 +127,98 @@ public:
     // Manutenção
     // --------------------------------------------------------
 
-    void start_ota_process(const std::string& filepath);
+    // Ambos retornam imediatamente; a recuperação termina no io_context
+    // assim que o STM32 responde (borda READY + GET_STATUS/VERSION).
+    // O OTA roda numa thread própria com o motor do update_dir sobre o
+    // _bridge (sem processo externo e sem fechar SPI/READY).
+    // image/crc: conteúdo de filepath já em memória (upload pelo MQTT), sem releitura.
+    // CMD_ERR_INVALID_STATE = manutenção (OTA ou reset) em andamento, nada iniciado.
+    CommandStatus start_ota_process(const std::string& filepath, std::vector<uint8_t> image = {},
+                                    uint16_t crc = 0);
     void hard_reset_stm32();
 
+    // Interrompe a transferência em andamento (false = nenhuma). O banco
+    // ativo não é tocado; o STM32 segue na aplicação atual.
+    bool cancel_ota();
+
+    // Retoma o OTA do diário (nunca automático: o STM32 pode estar infundindo).
+    // CMD_ERR_INVALID_STATE = sem diário, manutenção em andamento ou bomba fora de
+    // POWER_ON/IDLE; CMD_ERR_CHECKSUM = imagem mudou desde o OTA interrompido.
+    CommandStatus resume_ota();
+
+    bool in_maintenance() const
+    {
+        return _maintenance_mode;
+    }
+
+    // Round trip SPI (comando + resposta, incluindo a espera da READY) do
+    // último comando executado. Zera ao ler: comandos sem SPI reportam 0.
+    std::chrono::microseconds take_command_rtt()
+    {
+        return std::chrono::microseconds(_command_rtt_us.exchange(0));
+    }
+
 private:
     // Hardware
     Stm32Bridge& _bridge;
     HalGpio& _reset_pin;
+    boost::asio::io_context& _io;
+
+    const std::chrono::milliseconds _monitor_period;
 
     // Proteção SPI
     std::mutex _spi_mutex;
 
+    // Medição do último comando (escrito com _spi_mutex, lido pelo executor)
+    std::atomic<int64_t> _command_rtt_us{0};
+
     // Controle thread
     std::atomic<bool> _running{false};
     std::atomic<bool> _maintenance_mode{false};
     std::atomic<bool> _ota_running{false};
-    std::atomic<bool> _waiting_mcu{false};
+    std::atomic<bool> _ota_transfer{false}; // motor rodando (cancelável)
+    std::atomic<bool> _ota_cancel{false};
+    std::string _ota_journal;
+    std::string _ota_store;
 
     std::thread _monitor_thread;
 
+    // Acorda o monitor (stop, fim de manutenção, pedido de probe)
+    std::mutex _wake_mutex;
+    std::condition_variable _wake_cv;
+    McuRecovery::ProbeReply _probe_reply; // probe pendente (protegido por _wake_mutex)
+
+    // Manutenção assíncrona (só acessada no io_context)
+    McuRecovery _recovery;
+
     // Callback status
     StatusCallback _status_cb;
+    std::vector<StatusCallback> _status_listeners;
+    PressureCallback _pressure_cb;
+    OtaProgressCallback _ota_cb;
+
+    // DSP da pressão (só acessado pela thread de monitoramento)
+    PressureAnalyzer _pressure_dsp;
 
     // Loop principal
     void monitor_loop();
+    void wait_monitor_period();
+    void wake_monitor();
+
+    // Envio de comando com medição do round trip (chamar com _spi_mutex)
+    bool send_timed(cmd_ids_t req_id, cmd_cmds_t* req, cmd_cmds_t* res);
+
+    // Manutenção
+    void request_probe(McuRecovery::ProbeReply reply);
+    McuRecovery::ProbeResult probe_mcu();
+    bool enter_maintenance();
+    void finish_maintenance(bool ok, const char* what);
+
+    // OTA interrompido (ota_journal.hpp): anunciado no start(), retomado por resume_ota()
+    void announce_pending_ota();
+    bool load_pending_ota(OtaJournalEntry& entry);
+    bool mcu_idle();
+    void emit_ota(const OtaProgress& progress);
 };
 
 #endif
@@ -0,0 +1,212 @@
+#include "mcu_recovery.hpp"
+#include <iostream>
+
+// ============================================================
+// Tempos
+// ============================================================
+
+static constexpr std::chrono::milliseconds RESET_PULSE{100};
+static constexpr std::chrono::milliseconds RESET_BOOT_TIMEOUT{3000};
+
+// Após uma borda sem resposta válida: o firmware ainda está subindo
+static constexpr std::chrono::milliseconds EDGE_REPROBE{20};
+
+// Rede de segurança caso a borda se perca (pino liberado, fila cheia, etc.)
+static constexpr std::chrono::milliseconds FALLBACK_PROBE{5000};
+
+// ============================================================
+// Ciclo de vida
+// ============================================================
+
+McuRecovery::McuRecovery(boost::asio::io_context& io, HalGpio& reset_pin, HalGpio& ready_pin, ProbeFn probe)
+    : _io(io), _reset_pin(reset_pin), _ready_pin(ready_pin), _probe(std::move(probe)), _deadline(io), _step_timer(io),
+      _ready_events(io)
+{
+}
+
+McuRecovery::~McuRecovery()
+{
+    // O FD é da libgpiod: nunca deixar o asio fechá-lo
+    disarm_edge_wait();
+}
+
+void McuRecovery::begin(DoneFn done, std::chrono::milliseconds timeout)
+{
+    _generation++;
+    _done = std::move(done);
+    _edge_seen = false;
+    _started = std::chrono::steady_clock::now();
+
+    unsigned gen = _generation;
+    _deadline.expires_after(timeout);
+    _deadline.async_wait([this, gen](boost::system::error_code ec) {
+        if(ec || gen != _generation)
+            return;
+
+        std::cerr << "[RECOVERY] Timeout — STM32 nao respondeu (borda READY "
+                  << (_edge_seen ? "vista" : "nao vista") << ")\n";
+        finish(false);
+    });
+}
+
+// ============================================================
+// Entradas
+// ============================================================
+
+void McuRecovery::start_reset(DoneFn done)
+{
+    begin(std::move(done), RESET_PULSE + RESET_BOOT_TIMEOUT);
+
+    drain_edges();
+    _reset_pin.set(false);
+    _state = State::ResetAsserted;
+
+    unsigned gen = _generation;
+    _step_timer.expires_after(RESET_PULSE);
+    _step_timer.async_wait([this, gen](boost::system::error_code ec) {
+        if(ec || gen != _generation)
+            return;
+
+        _reset_pin.set(true);
+        enter_wait_boot();
+    });
+}
+
+void McuRecovery::start_boot_wait(std::chrono::milliseconds timeout, DoneFn done)
+{
+    begin(std::move(done), timeout);
+
+    drain_edges();
+    enter_wait_boot();
+}
+
+// ============================================================
+// Estados
+// ============================================================
+
+void McuRecovery::enter_wait_boot()
+{
+    _state = State::WaitingBoot;
+    arm_edge_wait();
+    schedule_probe(_edge_seen ? EDGE_REPROBE : FALLBACK_PROBE);
+}
+
+void McuRecovery::arm_edge_wait()
+{
+    int fd = _ready_pin.event_fd();
+    if(fd < 0)
+    {
+        std::cerr << "[RECOVERY] READY sem eventos de borda — apenas fallback\n";
+        return;
+    }
+
+    if(_edge_armed)
+        return;
+
+    if(!_ready_events.is_open())
+        _ready_events.assign(fd);
+
+    _edge_armed = true;
+
+    unsigned gen = _generation;
+    _ready_events.async_wait(boost::asio::posix::stream_descriptor::wait_read,
+                             [this, gen](boost::system::error_code ec) {
+                                 if(ec || gen != _generation)
+                                     return;
+
+                                 _edge_armed = false;
+                                 if(_state != State::WaitingBoot)
+                                     return;
+
+                                 drain_edges();
+
+                                 if(!_edge_seen)
+                                 {
+                                     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - _started);
+                                     std::cout << "[RECOVERY] Borda READY apos " << ms.count() << " ms\n";
+                                 }
+
+                                 _edge_seen = true;
+                                 probe_now();
+                             });
+}
+
+void McuRecovery::disarm_edge_wait()
+{
+    _edge_armed = false;
+    if(!_ready_events.is_open())
+        return;
+
+    boost::system::error_code ec;
+    _ready_events.cancel(ec);
+    _ready_events.release();
+}
+
+void McuRecovery::drain_edges()
+{
+    // wait_for_edge(0) não bloqueia; limite evita laço infinito com linha ruidosa
+    for(int i = 0; i < 256; i++)
+    {
+        if(_ready_pin.wait_for_edge(0) == HalGpio::Edge::None)
+            break;
+    }
+}
+
+void McuRecovery::schedule_probe(std::chrono::milliseconds delay)
+{
+    unsigned gen = _generation;
+    _step_timer.expires_after(delay);
+    _step_timer.async_wait([this, gen](boost::system::error_code ec) {
+        if(ec || gen != _generation || _state != State::WaitingBoot)
+            return;
+
+        probe_now();
+    });
+}
+
+void McuRecovery::probe_now()
+{
+    _step_timer.cancel();
+    _state = State::Probing;
+
+    unsigned gen = _generation;
+    _probe([this, gen](ProbeResult result) {
+        boost::asio::post(_io, [this, gen, result]() { on_probe(gen, result); });
+    });
+}
+
+void McuRecovery::on_probe(unsigned gen, ProbeResult result)
+{
+    if(gen != _generation || _state != State::Probing)
+        return;
+
+    if(result == ProbeResult::Up)
+    {
+        finish(true);
+        return;
+    }
+
+    enter_wait_boot();
+}
+
+void McuRecovery::finish(bool ok)
+{
+    _generation++;
+    _deadline.cancel();
+    _step_timer.cancel();
+    disarm_edge_wait();
+
+    // Garante que o STM32 não fica preso em reset se o timeout caiu no pulso
+    _reset_pin.set(true);
+    _state = State::Idle;
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _started);
+    if(ok)
+        std::cout << "[RECOVERY] STM32 online em " << ms.count() << " ms\n";
+
+    DoneFn done = std::move(_done);
+    _done = nullptr;
+    if(done)
+        done(ok);
+}
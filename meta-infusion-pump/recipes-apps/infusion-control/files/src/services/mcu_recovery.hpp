@@ -0,0 +1,90 @@
+#ifndef MCU_RECOVERY_HPP
+#define MCU_RECOVERY_HPP
+
+#include "hal_gpio.hpp"
+#include <boost/asio.hpp>
+#include <chrono>
+#include <functional>
+
+// ============================================================
+// Máquina de estados de manutenção do STM32
+// ============================================================
+//
+// Substitui os sleeps do reset físico e o polling de 1s pós-OTA.
+// Tudo roda no io_context (timers + espera assíncrona no FD de bordas
+// da linha READY). O boot é detectado pela primeira borda de subida da
+// READY, confirmada por um probe GET_STATUS/VERSION.
+//
+// Todos os métodos públicos devem ser chamados na thread do io_context.
+
+class McuRecovery
+{
+public:
+    enum class State
+    {
+        Idle,
+        ResetAsserted, // pino de reset em nível baixo
+        WaitingBoot,   // aguardando borda da READY (ou fallback)
+        Probing,       // probe em andamento
+    };
+
+    enum class ProbeResult
+    {
+        Up,
+        NotReady,
+    };
+
+    // O probe é assíncrono: quem implementa executa o GET_STATUS fora do
+    // io_context e chama a resposta de qualquer thread (ela faz o post()).
+    using ProbeReply = std::function<void(ProbeResult)>;
+    using ProbeFn = std::function<void(ProbeReply)>;
+    using DoneFn = std::function<void(bool ok)>;
+
+    McuRecovery(boost::asio::io_context& io, HalGpio& reset_pin, HalGpio& ready_pin, ProbeFn probe);
+    ~McuRecovery();
+
+    // Pulso de reset seguido da espera de boot
+    void start_reset(DoneFn done);
+
+    // Apenas espera o boot (pós-OTA: o STM32 reinicia sozinho após o swap)
+    void start_boot_wait(std::chrono::milliseconds timeout, DoneFn done);
+
+    bool busy() const
+    {
+        return _state != State::Idle;
+    }
+
+    State state() const
+    {
+        return _state;
+    }
+
+private:
+    boost::asio::io_context& _io;
+    HalGpio& _reset_pin;
+    HalGpio& _ready_pin;
+    ProbeFn _probe;
+
+    boost::asio::steady_timer _deadline;
+    boost::asio::steady_timer _step_timer; // pulso de reset / re-probe / fallback
+    boost::asio::posix::stream_descriptor _ready_events;
+
+    State _state = State::Idle;
+    DoneFn _done;
+    unsigned _generation = 0; // invalida handlers de ciclos anteriores
+    bool _edge_seen = false;
+    bool _edge_armed = false;
+    std::chrono::steady_clock::time_point _started;
+
+    void begin(DoneFn done, std::chrono::milliseconds timeout);
+    void enter_wait_boot();
+    void arm_edge_wait();
+    void disarm_edge_wait();
+    void drain_edges();
+    void schedule_probe(std::chrono::milliseconds delay);
+    void probe_now();
+    void on_probe(unsigned gen, ProbeResult result);
+    void finish(bool ok);
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef STATUS_SAMPLE_HPP
+#define STATUS_SAMPLE_HPP
+
+#include <cstdint>
+
+// ============================================================
+// Amostra de status do STM32
+// ============================================================
+//
+// Sem dependência de HAL: usada pelo InfusionManager (produtor) e pelos
+// codecs/filas da camada de servidor, que compilam também no host.
+
+struct StatusSample
+{
+    uint8_t state;
+    uint8_t alarm;
+    uint32_t volume;
+    uint32_t flow_rate;
+    uint32_t pressure;
+    uint64_t timestamp_ms; // relógio de parede (ms desde epoch)
+};
+
+#endif
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <csignal>
+#include <cstdlib>
 #include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
 #include <boost/asio.hpp>
 #include <systemd/sd-daemon.h>
 
@@ -8,18 +12,20 @@
 #include "hal_gpio.hpp"
 #include "stm32_bridge.hpp"
 #include "infusion_manager.hpp"
+#include "device_registry.hpp"
 #include "mqtt_client.hpp"
+#include "shm_status_feed.hpp"
 
 // Globais para Signal Handler
 boost::asio::io_context* g_io = nullptr;
-InfusionManager* g_manager = nullptr;
+DeviceRegistry* g_registry = nullptr;
 
 void signal_handler(int signal)
 {
     std::cout << "\n[SYSTEM] Sinal " << signal << " recebido. Parando..." << std::endl;
     // Para o polling do hardware primeiro
-    if(g_manager)
-        g_manager->stop();
+    if(g_registry)
+        g_registry->stop_all();
     // Para o loop de eventos (desconecta MQTT e cancela timers)
     if(g_io)
         g_io->stop();
@@ -48,6 +54,27 @@ void watchdog_pulse(const boost::system::error_code& error, boost::asio::steady_
     t->async_wait([t](const boost::system::error_code& ec) { watchdog_pulse(ec, t); });
 }
 
+// Um cliente MQTT (conexão + executor) por canal
+template <class Client>
+static std::vector<std::unique_ptr<Client>> make_mqtt_clients(boost::asio::io_context& io, DeviceRegistry& registry,
+                                                              MqttClientConfig config)
+{
+    std::vector<std::unique_ptr<Client>> clients;
+    for(auto& ch : registry.channels())
+    {
+        config.channel = ch->config.id;
+        clients.push_back(std::make_unique<Client>(io, *ch->manager, config));
+    }
+    return clients;
+}
+
+template <class Client>
+static void start_mqtt_clients(std::vector<std::unique_ptr<Client>>& clients)
+{
+    for(auto& client : clients)
+        client->start();
+}
+
 int main()
 {
     // Permite logs imediatos no journalctl
@@ -56,25 +83,87 @@ int main()
 
     try
     {
-        const char* node = "/dev/spidev0.0";
         const uint32_t spi_speed_hz = 1000000;
-        // 1. Hardware Initialization
-        HalSpi spi(node, spi_speed_hz);
-        HalGpio ready_pin(25, HalGpio::Direction::Input, HalGpio::Edge::Rising, false, "/dev/gpiochip0");
-        HalGpio stm32_reset_pin(4, HalGpio::Direction::Output, HalGpio::Edge::None, false, "/dev/gpiochip0");
-        stm32_reset_pin.set(true);
-
-        // 2. Driver Layer
-        Stm32Bridge bridge(spi, ready_pin);
 
-        // 3. Service Layer (Manager)
-        InfusionManager manager(bridge, stm32_reset_pin);
-        g_manager = &manager;
-
-        // 4. Server Layer (MQTT + IO Context)
+        // IO Context: rede, watchdog e máquinas de estado de manutenção
         boost::asio::io_context io;
         g_io = &io;
-        MqttClient mqtt(io, manager);
+
+        // Período do polling de status (ARGUS_POLL_MS, padrão 1000 ms)
+        const char* poll_env = std::getenv("ARGUS_POLL_MS");
+        uint32_t poll_ms = poll_env ? static_cast<uint32_t>(std::strtoul(poll_env, nullptr, 10)) : MONITOR_PERIOD_MS;
+        if(poll_ms == 0)
+            poll_ms = MONITOR_PERIOD_MS;
+
+        // 1-3. Hardware, Driver e Service Layer: um par bridge/manager por canal
+        // (ARGUS_CHANNELS; sem configuração = canal único em /dev/spidev0.0)
+        std::vector<ChannelConfig> channels = parse_channel_configs(std::getenv("ARGUS_CHANNELS"));
+        if(channels.empty())
+        {
+            std::cerr << "[FATAL] ARGUS_CHANNELS invalido" << std::endl;
+            return 1;
+        }
+
+        // Declarado antes do registry: as threads de monitoramento escrevem nele
+        ShmStatusFeed shm_feed;
+
+        DeviceRegistry registry(io, channels, spi_speed_hz, poll_ms);
+        g_registry = &registry;
+
+        // Feed local em /dev/shm para consumidores no próprio dispositivo (ARGUS_SHM_FEED=1)
+        const char* shm_env = std::getenv("ARGUS_SHM_FEED");
+        if(shm_env && std::strcmp(shm_env, "1") == 0)
+        {
+            std::vector<std::string> ids;
+            for(auto& ch : registry.channels())
+                ids.push_back(ch->config.id);
+
+            if(shm_feed.open(ids))
+            {
+                for(unsigned i = 0; i < registry.channels().size(); i++)
+                {
+                    registry.channels()[i]->manager->add_status_listener(
+                        [&shm_feed, i](const StatusSample& sample) { shm_feed.publish(i, sample); });
+                }
+            }
+        }
+
+        // 4. Server Layer (MQTT)
+        MqttClientConfig mqtt_config;
+        // Formato do bomba/status por deployment (Environment= no infusion-pump.service)
+        mqtt_config.status_encoding = parse_status_encoding(std::getenv("ARGUS_STATUS_FORMAT"));
+        // Agrupamento por tópico: "N" ou "N:T" (N amostras ou T ms por mensagem)
+        mqtt_config.status_batch = parse_batch_policy(std::getenv("ARGUS_STATUS_BATCH"));
+        mqtt_config.pressure_batch = parse_batch_policy(std::getenv("ARGUS_PRESSURE_BATCH"));
+        // Streams de status com taxa/agregação próprias (bomba/status/<sufixo>)
+        mqtt_config.status_streams = parse_status_streams(std::getenv("ARGUS_STATUS_STREAMS"));
+        // Store-and-forward durante quedas do broker (partição de dados gravável)
+        if(const char* spool_path = std::getenv("ARGUS_SPOOL_PATH"))
+            mqtt_config.spool_path = spool_path;
+        if(const char* spool_records = std::getenv("ARGUS_SPOOL_RECORDS"))
+            mqtt_config.spool_records = static_cast<uint32_t>(std::strtoul(spool_records, nullptr, 10));
+
+        // Idade máxima de comandos com "ts" (ms, 0 = desativado)
+        if(const char* max_age = std::getenv("ARGUS_CMD_MAX_AGE_MS"))
+            mqtt_config.command_max_age = std::chrono::milliseconds(std::strtoul(max_age, nullptr, 10));
+
+        // Transporte até o broker local: tcp (padrão) ou unix (listener do mosquitto)
+        const char* transport = std::getenv("ARGUS_MQTT_TRANSPORT");
+        bool use_unix = transport && std::strcmp(transport, "unix") == 0;
+
+        std::vector<std::unique_ptr<MqttClient>> mqtt_tcp;
+        std::vector<std::unique_ptr<LocalMqttClient>> mqtt_unix;
+
+        if(use_unix)
+        {
+            if(const char* socket_path = std::getenv("ARGUS_MQTT_SOCKET"))
+                LocalBrokerStream::set_path(socket_path);
+
+            std::cout << "[SYSTEM] MQTT via unix socket " << LocalBrokerStream::path() << std::endl;
+            mqtt_unix = make_mqtt_clients<LocalMqttClient>(io, registry, mqtt_config);
+        }
+        else
+            mqtt_tcp = make_mqtt_clients<MqttClient>(io, registry, mqtt_config);
 
         // --- CONFIGURAÇÃO DO WATCHDOG ---
         // Cria um timer que dispara a cada 2 segundos.
@@ -90,8 +179,11 @@ int main()
         std::signal(SIGTERM, signal_handler);
 
         // Start
-        manager.start(); // Inicia thread de polling do hardware (1Hz)
-        mqtt.start();    // Conecta no Broker e inicia subs
+        registry.start_all(); // Inicia as threads de polling do hardware (ARGUS_POLL_MS)
+
+        // Conecta no Broker e inicia subs
+        start_mqtt_clients(mqtt_unix);
+        start_mqtt_clients(mqtt_tcp);
 
         // Notifica Systemd que inicialização acabou
         sd_notify(0, "READY=1");
@@ -100,6 +192,7 @@ int main()
         // Bloqueia aqui - O io.run() vai gerenciar:
         // 1. Mensagens MQTT (Rede)
         // 2. O Timer do Watchdog
+        // 3. Reset do STM32 e detecção de boot pós-OTA
         io.run();
     }
     catch(const std::exception& e)
@@ -0,0 +1,263 @@
+// ============================================================
+// Equivalência numérica dos kernels de DSP
+// ============================================================
+//
+// 1. Kernels: cada caminho compilado para a máquina (escalar, SSE2, NEON)
+//    contra uma referência em double, em tamanhos que exercitam a cauda
+//    escalar (0..70) e um bloco grande.
+// 2. Blocos: FIR, biquad, decimador e FFT, no caminho escolhido pelo
+//    dispatch, contra convolução/recursão/DFT em double. O "make test" roda
+//    o binário com ARGUS_DSP_KERNELS=scalar, sse2 e neon: os três caminhos
+//    precisam ficar dentro da mesma tolerância da mesma referência.
+//
+// Caminho pedido e indisponível na máquina (NEON no x86, SSE2 no ARM) é
+// pulado, não reprovado. Roda em qualquer Linux, sem hardware.
+//
+// Uso: dsp-kernels-test   (código de saída != 0 = divergência)
+
+#include "dsp_kernels.hpp"
+#include "pressure_dsp.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static unsigned g_failures = 0;
+
+static void check(bool ok, const char* what, const char* path, size_t n, double err, double tol)
+{
+    if(ok)
+        return;
+    g_failures++;
+    std::printf("FALHA %-10s %-7s n=%-5zu erro %.3g (tolerancia %.3g)\n", what, path, n, err, tol);
+}
+
+static std::vector<float> random_signal(std::mt19937& rng, size_t n)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> v(n);
+    for(auto& x : v)
+        x = dist(rng);
+    return v;
+}
+
+// ============================================================
+// Kernels
+// ============================================================
+
+static void test_kernels(const DspKernels& k, std::mt19937& rng)
+{
+    std::vector<size_t> sizes;
+    for(size_t n = 0; n <= 70; n++)
+        sizes.push_back(n);
+    sizes.push_back(1024);
+
+    for(size_t n : sizes)
+    {
+        auto a = random_signal(rng, n);
+        auto b = random_signal(rng, n);
+
+        // dot: erro de arredondamento cresce com n e com sum|a*b|
+        double ref = 0.0;
+        double mag = 0.0;
+        for(size_t i = 0; i < n; i++)
+        {
+            ref += double(a[i]) * b[i];
+            mag += std::fabs(double(a[i]) * b[i]);
+        }
+        double err = std::fabs(k.dot(a.data(), b.data(), n) - ref);
+        double tol = 1e-6 * (mag + 1.0);
+        check(err <= tol, "dot", k.name, n, err, tol);
+
+        // multiply: um produto por elemento, arredondado igual em todo caminho
+        std::vector<float> out(n);
+        k.multiply(a.data(), b.data(), out.data(), n);
+        err = 0.0;
+        for(size_t i = 0; i < n; i++)
+            err = std::max(err, std::fabs(out[i] - double(a[i]) * b[i]));
+        check(err <= 1e-6, "multiply", k.name, n, err, 1e-6);
+
+        // power
+        k.power(a.data(), b.data(), out.data(), n);
+        err = 0.0;
+        for(size_t i = 0; i < n; i++)
+            err = std::max(err, std::fabs(out[i] - (double(a[i]) * a[i] + double(b[i]) * b[i])));
+        check(err <= 1e-6, "power", k.name, n, err, 1e-6);
+
+        // butterfly (in-place nos quatro vetores)
+        auto a_re = random_signal(rng, n);
+        auto a_im = random_signal(rng, n);
+        auto b_re = random_signal(rng, n);
+        auto b_im = random_signal(rng, n);
+        auto w_re = random_signal(rng, n);
+        auto w_im = random_signal(rng, n);
+        auto ra_re = a_re, ra_im = a_im, rb_re = b_re, rb_im = b_im;
+
+        k.butterfly(a_re.data(), a_im.data(), b_re.data(), b_im.data(), w_re.data(), w_im.data(), n);
+
+        err = 0.0;
+        for(size_t i = 0; i < n; i++)
+        {
+            double t_re = double(w_re[i]) * rb_re[i] - double(w_im[i]) * rb_im[i];
+            double t_im = double(w_re[i]) * rb_im[i] + double(w_im[i]) * rb_re[i];
+            err = std::max({err, std::fabs(a_re[i] - (ra_re[i] + t_re)), std::fabs(a_im[i] - (ra_im[i] + t_im)),
+                            std::fabs(b_re[i] - (ra_re[i] - t_re)), std::fabs(b_im[i] - (ra_im[i] - t_im))});
+        }
+        check(err <= 1e-5, "butterfly", k.name, n, err, 1e-5);
+    }
+}
+
+// ============================================================
+// Blocos (caminho do dispatch)
+// ============================================================
+
+static double fir_reference(const std::vector<float>& taps, const std::vector<float>& x, size_t n)
+{
+    double y = 0.0;
+    for(size_t k = 0; k < taps.size() && k <= n; k++)
+        y += double(taps[k]) * x[n - k];
+    return y;
+}
+
+static void test_fir(std::mt19937& rng, const char* path)
+{
+    for(size_t num_taps : {1u, 7u, 33u, 65u})
+    {
+        auto taps = FirFilter::design_lowpass(num_taps, 0.1f);
+        auto x = random_signal(rng, 1000);
+
+        FirFilter fir(taps);
+        double err = 0.0;
+        for(size_t n = 0; n < x.size(); n++)
+            err = std::max(err, std::fabs(fir.process(x[n]) - fir_reference(taps, x, n)));
+        check(err <= 1e-5, "fir", path, num_taps, err, 1e-5);
+    }
+}
+
+static void test_decimator(std::mt19937& rng, const char* path)
+{
+    for(unsigned factor : {2u, 4u, 8u})
+    {
+        const size_t num_taps = 8 * factor + 1;
+        auto taps = FirFilter::design_lowpass(num_taps, 0.4f / factor);
+        auto x = random_signal(rng, 2000);
+
+        Decimator dec(factor, num_taps);
+        double err = 0.0;
+        size_t outputs = 0;
+        for(size_t n = 0; n < x.size(); n++)
+        {
+            float y;
+            if(!dec.push(x[n], y))
+                continue;
+
+            // Sai uma amostra a cada 'factor' entradas, a primeira na entrada factor - 1
+            if(n % factor != factor - 1)
+            {
+                check(false, "decim fase", path, n, double(n % factor), 0.0);
+                break;
+            }
+            err = std::max(err, std::fabs(y - fir_reference(taps, x, n)));
+            outputs++;
+        }
+        check(outputs == x.size() / factor, "decim n", path, factor, double(outputs), double(x.size() / factor));
+        check(err <= 1e-5, "decimator", path, factor, err, 1e-5);
+    }
+}
+
+static void test_biquad(std::mt19937& rng, const char* path)
+{
+    auto c = BiquadFilter::design_lowpass(100.0f, 5.0f);
+    BiquadFilter iir(c);
+    auto x = random_signal(rng, 2000);
+
+    double z1 = 0.0, z2 = 0.0, err = 0.0;
+    for(float xn : x)
+    {
+        double y = c.b0 * double(xn) + z1;
+        z1 = c.b1 * double(xn) - c.a1 * y + z2;
+        z2 = c.b2 * double(xn) - c.a2 * y;
+        err = std::max(err, std::fabs(iir.process(xn) - y));
+    }
+    check(err <= 1e-4, "biquad", path, x.size(), err, 1e-4);
+}
+
+static void test_fft(std::mt19937& rng, const char* path)
+{
+    for(size_t size : {8u, 64u, 256u, 1024u})
+    {
+        // Senoide num bin conhecido + ruído + offset (a média é removida)
+        const size_t tone = size / 8 + 1;
+        auto x = random_signal(rng, size);
+        for(size_t i = 0; i < size; i++)
+            x[i] = 0.2f * x[i] + std::sin(2.0 * M_PI * tone * i / size) + 3.0f;
+
+        SpectrumAnalyzer spectrum(size);
+        size_t dominant = spectrum.analyze(x.data());
+
+        double mean = 0.0;
+        for(float v : x)
+            mean += v;
+        mean /= size;
+
+        std::vector<double> w(size);
+        for(size_t i = 0; i < size; i++)
+            w[i] = (x[i] - mean) * (0.5 - 0.5 * std::cos(2.0 * M_PI * i / (size - 1)));
+
+        const auto& power = spectrum.power();
+        double peak = 0.0, err = 0.0;
+        std::vector<double> ref(power.size());
+        for(size_t bin = 0; bin < ref.size(); bin++)
+        {
+            double re = 0.0, im = 0.0;
+            for(size_t i = 0; i < size; i++)
+            {
+                double angle = -2.0 * M_PI * double(bin) * double(i) / double(size);
+                re += w[i] * std::cos(angle);
+                im += w[i] * std::sin(angle);
+            }
+            ref[bin] = re * re + im * im;
+            peak = std::max(peak, ref[bin]);
+        }
+        for(size_t bin = 0; bin < ref.size(); bin++)
+            err = std::max(err, std::fabs(power[bin] - ref[bin]));
+
+        // Relativo ao pico: a FFT em float acumula log2(N) estágios de arredondamento
+        double tol = 1e-5 * peak;
+        check(err <= tol, "fft", path, size, err, tol);
+        check(dominant == tone, "fft pico", path, size, double(dominant), double(tone));
+    }
+}
+
+int main()
+{
+    const char* forced = std::getenv("ARGUS_DSP_KERNELS");
+    const DspKernels& active = dsp_kernels();
+
+    if(forced && std::strcmp(forced, active.name) != 0)
+    {
+        std::printf("dsp-kernels-test: caminho %s indisponivel nesta maquina — pulado\n", forced);
+        return 0;
+    }
+
+    std::mt19937 rng(26);
+
+    // Kernels: todos os caminhos desta máquina, a cada execução
+    const DspKernels* paths[] = {&dsp_kernels_scalar(), dsp_kernels_sse2(), dsp_kernels_neon()};
+    for(const DspKernels* k : paths)
+    {
+        if(k)
+            test_kernels(*k, rng);
+    }
+
+    test_fir(rng, active.name);
+    test_decimator(rng, active.name);
+    test_biquad(rng, active.name);
+    test_fft(rng, active.name);
+
+    std::printf("dsp-kernels-test (%s): %s\n", active.name, g_failures ? "FALHOU" : "ok");
+    return g_failures ? 1 : 0;
+}
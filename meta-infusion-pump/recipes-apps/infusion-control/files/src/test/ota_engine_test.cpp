@@ -0,0 +1,280 @@
+// ============================================================
+// OtaEngine contra o bootloader simulado, um modo por caso
+// ============================================================
+//
+// Cada caso roda o motor de verdade sobre o SimBootloader (bench/ota_sim.hpp)
+// e confere o resultado, o modo que o motor escolheu (OtaStats) e o banco
+// inativo do simulador byte a byte contra a imagem:
+//
+//   legado, queda para o legado (CAPS sem v2), v2 imagem inteira (com e sem
+//   erros de bit), LZSS, delta, delta com base recusada, páginas e retomada
+//   (raw, LZSS e delta): o primeiro envio é cancelado no meio, a sessão fica
+//   aberta no simulador e um segundo motor continua de onde ela parou. Mais
+//   a retomada recusada (outra imagem): recomeça do zero.
+//
+// Roda em qualquer Linux, sem hardware (alguns segundos: o simulador tem
+// relógio real).
+//
+// Uso: ota-engine-test   (código de saída != 0 = falha)
+
+#include "../bench/ota_sim.hpp"
+#include "ota_engine.hpp"
+#include <atomic>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static constexpr uint32_t SIM_HZ = 4000000;
+static constexpr uint32_t PAGE_SIZE = 1024;
+
+static unsigned g_failures = 0;
+
+static void check(bool ok, const char* name, const char* what)
+{
+    if(ok)
+        return;
+    g_failures++;
+    std::printf("FALHA %-18s %s\n", name, what);
+}
+
+// Imagem "tipo firmware" (como a do stm32-ota-bench): comprime e tem padding
+static std::vector<uint8_t> firmware_image(uint32_t size, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<uint32_t> vocab(300);
+    for(auto& word : vocab)
+        word = rng();
+
+    std::vector<uint8_t> image;
+    image.reserve(size);
+    while(image.size() < size)
+    {
+        uint32_t word = (rng() % 4 == 0) ? rng() : vocab[rng() % vocab.size()];
+        for(int k = 0; k < 4 && image.size() < size; k++)
+            image.push_back(uint8_t(word >> (8 * k)));
+    }
+
+    std::fill(image.begin() + size * 7 / 8, image.end(), 0xFF);
+    return image;
+}
+
+static SimBootloaderConfig sim_config(uint8_t features, bool lz = false)
+{
+    SimBootloaderConfig cfg;
+    cfg.flash_us = 50;
+    cfg.erase_ms = 5;
+    cfg.ack_us = 20;
+    cfg.max_spi_hz = SIM_HZ;
+    cfg.lz_window_bits = lz ? OTA_LZ_MAX_WINDOW_BITS : 0;
+    cfg.features = features;
+    cfg.page_size = PAGE_SIZE;
+    return cfg;
+}
+
+// Cada caso liga só o que testa
+static OtaOptions engine_options(bool v2)
+{
+    OtaOptions options;
+    options.allow_v2 = v2;
+    options.max_spi_hz = SIM_HZ;
+    options.compress = false;
+    options.resume = false;
+    options.skip_pages = false;
+    return options;
+}
+
+struct Run
+{
+    OtaResult result;
+    OtaStats stats;
+    bool verified;
+};
+
+// interrupt: cancela quando o bootloader tiver confirmado um terço do stream
+static Run run_engine(SimBootloader& bootloader, const std::vector<uint8_t>& image, const OtaOptions& options,
+                      const std::vector<uint8_t>* base = nullptr, bool interrupt = false)
+{
+    MemorySource source(image);
+    const std::vector<uint8_t> no_base;
+    MemorySource base_source(base ? *base : no_base);
+
+    OtaEngine engine(bootloader, source, options);
+    if(base)
+        engine.set_delta_base(&base_source);
+
+    std::atomic<bool> cancel{false};
+    if(interrupt)
+    {
+        engine.set_cancel(&cancel);
+        engine.set_progress([&](uint32_t acked, uint32_t total) {
+            if(acked >= total / 3)
+                cancel = true;
+        });
+    }
+
+    Run run;
+    run.result = engine.run();
+    run.stats = engine.stats();
+    run.verified = run.result == OtaResult::Ok && bootloader.flash() == image;
+    return run;
+}
+
+static void check_ok(const Run& run, const char* name)
+{
+    check(run.result == OtaResult::Ok, name, ota_result_name(run.result));
+    check(run.verified, name, "banco inativo diferente da imagem");
+}
+
+// ============================================================
+// Casos
+// ============================================================
+
+static void test_legacy(const std::vector<uint8_t>& image)
+{
+    SimBootloader bootloader(sim_config(0), false, 1);
+    Run run = run_engine(bootloader, image, engine_options(false));
+    check_ok(run, "legado");
+    check(!run.stats.windowed && !run.stats.legacy_fallback, "legado", "modo errado");
+}
+
+static void test_legacy_fallback(const std::vector<uint8_t>& image)
+{
+    SimBootloader bootloader(sim_config(0), false, 2);
+    Run run = run_engine(bootloader, image, engine_options(true));
+    check_ok(run, "queda-legado");
+    check(!run.stats.windowed && run.stats.legacy_fallback, "queda-legado", "queda nao reportada");
+}
+
+static void test_v2(const std::vector<uint8_t>& image, double ber, const char* name)
+{
+    SimBootloaderConfig cfg = sim_config(0);
+    cfg.ber = ber;
+    SimBootloader bootloader(cfg, true, 3);
+    Run run = run_engine(bootloader, image, engine_options(true));
+    check_ok(run, name);
+    check(run.stats.windowed && !run.stats.compressed && !run.stats.delta, name, "modo errado");
+}
+
+static void test_lz(const std::vector<uint8_t>& image)
+{
+    SimBootloader bootloader(sim_config(0, true), true, 4);
+    OtaOptions options = engine_options(true);
+    options.compress = true;
+    Run run = run_engine(bootloader, image, options);
+    check_ok(run, "lzss");
+    check(run.stats.compressed && run.stats.stream_bytes < image.size(), "lzss", "imagem nao foi comprimida");
+}
+
+static void test_delta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& image)
+{
+    SimBootloader bootloader(sim_config(CMD_OTA_FEAT_DELTA), true, 5);
+    bootloader.set_active(base);
+    Run run = run_engine(bootloader, image, engine_options(true), &base);
+    check_ok(run, "delta");
+    check(run.stats.delta && run.stats.stream_bytes < image.size() / 2, "delta", "delta nao usado");
+}
+
+// Banco ativo não é a base que o hub acha: START recusado, imagem inteira
+static void test_delta_rejected(const std::vector<uint8_t>& base, const std::vector<uint8_t>& image)
+{
+    SimBootloader bootloader(sim_config(CMD_OTA_FEAT_DELTA), true, 6);
+    bootloader.set_active(firmware_image(uint32_t(base.size()), 99));
+    Run run = run_engine(bootloader, image, engine_options(true), &base);
+    check_ok(run, "delta-recusado");
+    check(run.stats.base_rejected && !run.stats.delta, "delta-recusado", "base recusada nao reportada");
+}
+
+// Banco inativo com a imagem e duas páginas diferentes: só elas vão
+static void test_pages(const std::vector<uint8_t>& image)
+{
+    std::vector<uint8_t> inactive = image;
+    inactive[3 * PAGE_SIZE + 10] ^= 0x5A;
+    inactive[17 * PAGE_SIZE] ^= 0x01;
+
+    SimBootloader bootloader(sim_config(CMD_OTA_FEAT_PAGES), true, 7);
+    bootloader.set_inactive(inactive);
+
+    OtaOptions options = engine_options(true);
+    options.skip_pages = true;
+    Run run = run_engine(bootloader, image, options);
+    check_ok(run, "paginas");
+    check(run.stats.pages_total == (image.size() + PAGE_SIZE - 1) / PAGE_SIZE && run.stats.pages_sent == 2,
+          "paginas", "contagem de paginas errada");
+}
+
+// Primeiro envio cancelado no meio; o segundo motor retoma a sessão aberta
+static void test_resume(const std::vector<uint8_t>& image, const char* name, bool lz,
+                        const std::vector<uint8_t>* base = nullptr)
+{
+    uint8_t features = CMD_OTA_FEAT_RESUME | (base ? CMD_OTA_FEAT_DELTA : 0);
+    SimBootloader bootloader(sim_config(features, lz), true, 8);
+    if(base)
+        bootloader.set_active(*base);
+
+    // Frames pequenos e janela curta: o stream do delta também fica no meio
+    OtaOptions options = engine_options(true);
+    options.compress = lz;
+    options.resume = true;
+    options.max_chunk = 64;
+    options.window = 4;
+
+    Run first = run_engine(bootloader, image, options, base, true);
+    check(first.result == OtaResult::Cancelled, name, "primeiro envio nao foi cancelado");
+    check(bootloader.session_open(), name, "sessao fechada depois do cancelamento");
+
+    Run second = run_engine(bootloader, image, options, base);
+    check_ok(second, name);
+    check(second.stats.resumed_from > 0, name, "nao retomou");
+    check(second.stats.compressed == lz && second.stats.delta == (base != nullptr), name, "modo da sessao trocado");
+
+    // Só o que faltava foi reenviado
+    const uint32_t chunk = second.stats.chunk;
+    check(chunk > 0 && second.stats.frames < (second.stats.stream_bytes + chunk - 1) / chunk, name,
+          "stream reenviado inteiro");
+}
+
+// Sessão aberta de outra imagem: a retomada não confere e o motor recomeça
+static void test_resume_other_image(const std::vector<uint8_t>& old_image, const std::vector<uint8_t>& image)
+{
+    SimBootloader bootloader(sim_config(CMD_OTA_FEAT_RESUME), true, 9);
+
+    OtaOptions options = engine_options(true);
+    options.resume = true;
+
+    Run first = run_engine(bootloader, old_image, options, nullptr, true);
+    check(first.result == OtaResult::Cancelled, "retomada-outra", "primeiro envio nao foi cancelado");
+
+    Run second = run_engine(bootloader, image, options);
+    check_ok(second, "retomada-outra");
+    check(second.stats.resumed_from == 0, "retomada-outra", "retomou a sessao de outra imagem");
+}
+
+int main()
+{
+    const std::vector<uint8_t> small = firmware_image(4 * 1024, 7);
+    const std::vector<uint8_t> base = firmware_image(24 * 1024, 7);
+
+    // Versão nova: um trecho inserido (desloca o resto) e algumas palavras trocadas
+    std::vector<uint8_t> image = base;
+    const std::vector<uint8_t> patch = firmware_image(300, 11);
+    image.insert(image.begin() + 5000, patch.begin(), patch.end());
+    image.resize(base.size());
+    for(uint32_t offset : {1200u, 9000u, 15000u})
+        image[offset] ^= 0xA5;
+
+    test_legacy(small);
+    test_legacy_fallback(small);
+    test_v2(image, 0.0, "v2");
+    test_v2(image, 1e-5, "v2-ber");
+    test_lz(image);
+    test_delta(base, image);
+    test_delta_rejected(base, image);
+    test_pages(image);
+    test_resume(image, "retomada", false);
+    test_resume(image, "retomada-lzss", true);
+    test_resume(image, "retomada-delta", false, &base);
+    test_resume_other_image(base, image);
+
+    std::printf("ota-engine-test: %s\n", g_failures ? "FALHOU" : "ok");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+// ============================================================
+// StatusJsonWriter: bytes e alocações
+// ============================================================
+//
+// 1. Identidade: a saída do writer tem que ser a mesma, byte a byte, do
+//    boost::json::serialize sobre o objeto que o daemon montava antes
+//    (DOM com state/infused_volume_ml/real_rate_ml_h e, nos lotes, ts).
+//    Estados conhecidos, variantes de alarme, UNKNOWN(n) e os extremos
+//    de cada campo.
+//    Os nomes dos estados da referência são os do código antigo, escritos
+//    aqui à mão (não a STATE_NAMES do writer).
+// 2. Alocação: operator new global contado; N codificações seguidas com o
+//    mesmo writer não podem alocar nada.
+// 3. Tempo: ns por codificação do writer e da referência (DOM + serialize),
+//    só informativo.
+//
+// Só depende do codec e do StatusSample (sem HAL): compila e roda no host.
+//
+// Uso: status-codec-test [n=100000]   (código de saída != 0 = falha)
+
+#include "status_codec.hpp"
+#include <algorithm>
+#include <atomic>
+#include <boost/json.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// ============================================================
+// Contagem de alocações
+// ============================================================
+
+static std::atomic<size_t> g_allocs{0};
+
+// O GCC vê malloc/free dentro de new/delete inlinados e acusa par trocado
+// (-Wmismatched-new-delete); aqui o par é o próprio substituto
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if(void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// ============================================================
+// Referência (codificação com DOM, como antes do writer)
+// ============================================================
+
+// Nomes como o daemon publicava antes do writer
+static std::string reference_state(uint8_t state)
+{
+    switch(state)
+    {
+    case 0:
+        return "POWER_ON";
+    case 1:
+        return "IDLE";
+    case 2:
+        return "RUNNING";
+    case 3:
+        return "BOLUS";
+    case 4:
+        return "PURGE";
+    case 5:
+        return "PAUSED";
+    case 6:
+        return "KVO";
+    case 7:
+        return "END";
+    case 8:
+    case 9:
+    case 10:
+        return "ALARM";
+    case 11:
+        return "OFF";
+    }
+    return "UNKNOWN(" + std::to_string(state) + ")";
+}
+
+static std::string reference_json(const StatusSample& s, bool with_ts)
+{
+    boost::json::object json;
+    json["state"] = reference_state(s.state);
+    json["infused_volume_ml"] = s.volume;
+    json["real_rate_ml_h"] = s.flow_rate;
+    if(with_ts)
+        json["ts"] = s.timestamp_ms;
+
+    return boost::json::serialize(json);
+}
+
+static unsigned g_failures = 0;
+
+static void check_identity(StatusJsonWriter& writer, const StatusSample& s, bool with_ts)
+{
+    std::string_view out = writer.write(s, with_ts);
+    std::string ref = reference_json(s, with_ts);
+    if(out == ref)
+        return;
+
+    g_failures++;
+    std::printf("FALHA identidade\n  writer: %.*s\n  boost:  %s\n", int(out.size()), out.data(), ref.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    const size_t n = argc > 1 ? size_t(std::max(1, std::atoi(argv[1]))) : 100000;
+
+    StatusJsonWriter writer;
+
+    // 1. Identidade
+    const uint32_t u32_max = std::numeric_limits<uint32_t>::max();
+    const uint64_t u64_max = std::numeric_limits<uint64_t>::max();
+
+    for(unsigned state = 0; state <= 255; state++)
+    {
+        for(bool with_ts : {false, true})
+        {
+            check_identity(writer, StatusSample{uint8_t(state), 0, 0, 0, 0, 0}, with_ts);
+            check_identity(writer, StatusSample{uint8_t(state), 1, u32_max, u32_max, u32_max, u64_max}, with_ts);
+        }
+    }
+
+    std::mt19937_64 rng(30);
+    std::vector<StatusSample> samples(1024);
+    for(auto& s : samples)
+    {
+        uint64_t r = rng();
+        s.state = uint8_t(r % 16);
+        s.alarm = uint8_t((r >> 8) & 1);
+        s.volume = uint32_t(rng() >> (r % 32));
+        s.flow_rate = uint32_t(rng() >> ((r >> 16) % 32));
+        s.pressure = uint32_t(rng());
+        s.timestamp_ms = rng() >> ((r >> 24) % 64);
+
+        check_identity(writer, s, false);
+        check_identity(writer, s, true);
+    }
+
+    // 2. Alocações (amostras já prontas, writer já construído), com o tempo do writer
+    using Clock = std::chrono::steady_clock;
+
+    size_t bytes = 0;
+    size_t before = g_allocs.load();
+    auto started = Clock::now();
+    for(size_t i = 0; i < n; i++)
+    {
+        std::string_view out = writer.write(samples[i % samples.size()], (i & 1) != 0);
+        bytes += out.size();
+    }
+    auto writer_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count();
+    size_t allocs = g_allocs.load() - before;
+
+    if(allocs != 0)
+    {
+        g_failures++;
+        std::printf("FALHA alocacao: %zu alocacoes em %zu codificacoes\n", allocs, n);
+    }
+
+    // 3. Referência (DOM) nas mesmas amostras; o tamanho evita que o laço suma
+    size_t ref_bytes = 0;
+    started = Clock::now();
+    for(size_t i = 0; i < n; i++)
+        ref_bytes += reference_json(samples[i % samples.size()], (i & 1) != 0).size();
+    auto reference_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count();
+
+    if(ref_bytes != bytes)
+    {
+        g_failures++;
+        std::printf("FALHA tamanho: writer %zu bytes, referencia %zu bytes\n", bytes, ref_bytes);
+    }
+
+    std::printf("status-codec-test: writer %.1f ns/op, referencia (DOM) %.1f ns/op\n", double(writer_ns) / n,
+                double(reference_ns) / n);
+    std::printf("status-codec-test: %zu codificacoes (%zu bytes), %zu alocacoes: %s\n", n, bytes, allocs,
+                g_failures ? "FALHOU" : "ok");
+    return g_failures ? 1 : 0;
+}
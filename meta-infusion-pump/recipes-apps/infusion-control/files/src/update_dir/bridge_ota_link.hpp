@@ -0,0 +1,44 @@
+#ifndef BRIDGE_OTA_LINK_HPP
+#define BRIDGE_OTA_LINK_HPP
+
+#include "ota_link.hpp"
+#include "stm32_bridge.hpp"
+
+// ============================================================
+// Enlace do OTA dentro do daemon
+// ============================================================
+//
+// Transações pelo Stm32Bridge do canal: mesmo fd do spidev, mesma READY e,
+// com barramento compartilhado, o mesmo SpiBusArbiter (os outros canais
+// continuam sendo atendidos entre os frames do OTA). Quem usa deve segurar
+// o mutex SPI do canal durante o OTA inteiro.
+//
+// Frames do OTA entram no arbitrador como Poll: milhares de WCHUNK seguidos
+// não passam na frente dos comandos dos outros canais nem os empurram para
+// o limite de envelhecimento dos polls deles.
+
+class BridgeOtaLink : public OtaLink
+{
+public:
+    explicit BridgeOtaLink(Stm32Bridge& bridge) : _bridge(bridge) {}
+
+    bool exchange(const uint8_t* tx, uint8_t* rx, size_t len) override
+    {
+        return _bridge.exchange(tx, rx, len, SpiPriority::Poll);
+    }
+
+    uint32_t speed() const override
+    {
+        return _bridge.speed();
+    }
+
+    bool set_speed(uint32_t hz) override
+    {
+        return _bridge.set_speed(hz);
+    }
+
+private:
+    Stm32Bridge& _bridge;
+};
+
+#endif
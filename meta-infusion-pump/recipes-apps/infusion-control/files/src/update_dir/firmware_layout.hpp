@@ -0,0 +1,47 @@
+#ifndef FIRMWARE_LAYOUT_HPP
+#define FIRMWARE_LAYOUT_HPP
+
+#include <cstdint>
+#include <cstring>
+
+// ============================================================
+// Imagem da aplicação do STM32
+// ============================================================
+//
+// Conferências baratas feitas no hub antes de qualquer byte ir para o
+// bootloader: uma imagem truncada, de outro alvo ou um arquivo qualquer é
+// recusada aqui, e não depois de apagar o banco inativo. Usadas no upload
+// (FirmwareStaging, primeiro chunk) e no OtaJob antes do START.
+
+// Banco de aplicação (metade da flash com dual bank)
+static constexpr uint32_t FIRMWARE_MIN_SIZE = 1024;
+static constexpr uint32_t FIRMWARE_MAX_SIZE = 512 * 1024;
+
+static constexpr uint32_t STM32_FLASH_BASE = 0x08000000;
+static constexpr uint32_t STM32_FLASH_SIZE = 2 * FIRMWARE_MAX_SIZE;
+static constexpr uint32_t STM32_SRAM_BASE = 0x20000000;
+static constexpr uint32_t STM32_SRAM_SIZE = 512 * 1024;
+
+// Início da tabela de vetores: stack inicial + Reset_Handler
+static constexpr uint32_t FIRMWARE_VECTOR_BYTES = 8;
+
+// Stack inicial alinhada dentro da SRAM (o topo pode ser o fim dela) e
+// Reset_Handler na flash com o bit Thumb ligado
+inline bool firmware_vector_table_ok(const uint8_t* vectors)
+{
+    uint32_t sp;
+    uint32_t reset;
+    memcpy(&sp, vectors, sizeof(sp));
+    memcpy(&reset, vectors + 4, sizeof(reset));
+
+    bool sp_ok = sp > STM32_SRAM_BASE && sp <= STM32_SRAM_BASE + STM32_SRAM_SIZE && (sp & 0x3) == 0;
+    bool reset_ok = reset >= STM32_FLASH_BASE && reset < STM32_FLASH_BASE + STM32_FLASH_SIZE && (reset & 0x1);
+    return sp_ok && reset_ok;
+}
+
+inline bool firmware_size_ok(uint32_t size)
+{
+    return size >= FIRMWARE_MIN_SIZE && size <= FIRMWARE_MAX_SIZE;
+}
+
+#endif
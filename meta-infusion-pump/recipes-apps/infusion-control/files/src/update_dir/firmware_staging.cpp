@@ -0,0 +1,267 @@
+#include "firmware_staging.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <unistd.h>
+
+extern "C"
+{
+#include "utl_crc16.h"
+}
+
+bool sha256_from_hex(std::string_view hex, Sha256Digest& out)
+{
+    if(hex.size() != out.size() * 2)
+        return false;
+
+    auto nibble = [](char c) -> int {
+        if(c >= '0' && c <= '9')
+            return c - '0';
+        if(c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+        if(c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+        return -1;
+    };
+
+    for(size_t i = 0; i < out.size(); i++)
+    {
+        int hi = nibble(hex[2 * i]);
+        int lo = nibble(hex[2 * i + 1]);
+        if(hi < 0 || lo < 0)
+            return false;
+        out[i] = uint8_t((hi << 4) | lo);
+    }
+    return true;
+}
+
+FirmwareStaging::FirmwareStaging(std::string path) : _path(std::move(path)), _sha(EVP_MD_CTX_new()) {}
+
+FirmwareStaging::~FirmwareStaging()
+{
+    abort();
+    EVP_MD_CTX_free(_sha);
+}
+
+uint8_t FirmwareStaging::begin(uint32_t size, const Sha256Digest& sha256, int32_t crc)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if(_active)
+        printf("[OTA] Upload anterior descartado (%u de %u bytes)\n", _received, _size);
+    close_part();
+    _active = false;
+    _error = "";
+
+    if(!firmware_size_ok(size))
+    {
+        _error = "tamanho fora da faixa";
+        printf("[OTA] Upload recusado: %u bytes (%u..%u)\n", size, FIRMWARE_MIN_SIZE, FIRMWARE_MAX_SIZE);
+        return CMD_ERR_PARAM_RANGE;
+    }
+
+    _size = size;
+    _received = 0;
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(_path).parent_path(), ec);
+
+    _fd = ::open(part_path().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(_fd < 0)
+    {
+        _error = "staging nao criado";
+        printf("[OTA] Upload: %s: %s\n", part_path().c_str(), strerror(errno));
+        return CMD_ERR_INVALID_STATE;
+    }
+
+    // Partição cheia aparece agora, não no meio do upload
+    int err = posix_fallocate(_fd, 0, size);
+    if(err != 0)
+    {
+        fail("sem espaco na particao de dados");
+        printf("[OTA] Upload: fallocate de %u bytes: %s\n", size, strerror(err));
+        return CMD_ERR_INVALID_STATE;
+    }
+
+    if(!_sha || EVP_DigestInit_ex(_sha, EVP_sha256(), nullptr) != 1)
+    {
+        fail("SHA-256 indisponivel");
+        return CMD_ERR_INVALID_STATE;
+    }
+
+    _image.clear();
+    _image.reserve(size);
+    _crc = 0xFFFF;
+    _expected_crc = crc;
+    _expected_sha = sha256;
+    _vectors_checked = false;
+    _active = true;
+
+    printf("[OTA] Upload iniciado: %u bytes -> %s\n", size, _path.c_str());
+    return CMD_OK;
+}
+
+StagingChunk FirmwareStaging::write(uint32_t offset, const uint8_t* data, size_t len)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if(!_active)
+        return StagingChunk::Rejected;
+
+    if(offset > _received)
+    {
+        printf("[OTA] Upload: chunk em %u, esperado %u\n", offset, _received);
+        fail("chunk fora de ordem");
+        return StagingChunk::Rejected;
+    }
+
+    // Reentrega (QoS 1 após reconexão): só o que ainda não foi gravado
+    size_t skip = _received - offset;
+    if(skip >= len)
+        return StagingChunk::Duplicate;
+    data += skip;
+    len -= skip;
+
+    if(len > _size - _received)
+    {
+        fail("imagem maior que o tamanho anunciado");
+        return StagingChunk::Rejected;
+    }
+
+    _image.insert(_image.end(), data, data + len);
+
+    if(!_vectors_checked && _image.size() >= FIRMWARE_VECTOR_BYTES)
+    {
+        if(!firmware_vector_table_ok(_image.data()))
+        {
+            fail("tabela de vetores invalida");
+            return StagingChunk::Rejected;
+        }
+        _vectors_checked = true;
+    }
+
+    const uint8_t* p = data;
+    size_t left = len;
+    while(left > 0)
+    {
+        ssize_t n = ::write(_fd, p, left);
+        if(n < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            printf("[OTA] Upload: escrita em %s: %s\n", part_path().c_str(), strerror(errno));
+            fail("erro de escrita no staging");
+            return StagingChunk::Rejected;
+        }
+        p += n;
+        left -= size_t(n);
+    }
+
+    _crc = utl_crc16_data(data, len, _crc);
+    EVP_DigestUpdate(_sha, data, len);
+    _received += uint32_t(len);
+    return StagingChunk::Stored;
+}
+
+uint8_t FirmwareStaging::commit(StagedFirmware& out)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if(!_active)
+        return CMD_ERR_INVALID_STATE;
+
+    if(_received != _size)
+    {
+        printf("[OTA] Upload incompleto: %u de %u bytes\n", _received, _size);
+        return CMD_ERR_INVALID_STATE;
+    }
+
+    Sha256Digest digest{};
+    unsigned int digest_len = 0;
+    if(EVP_DigestFinal_ex(_sha, digest.data(), &digest_len) != 1 || digest_len != digest.size() ||
+       digest != _expected_sha)
+    {
+        fail("SHA-256 diferente do anunciado");
+        return CMD_ERR_CHECKSUM;
+    }
+
+    if(_expected_crc >= 0 && uint16_t(_expected_crc) != _crc)
+    {
+        printf("[OTA] Upload: CRC %04X, anunciado %04X\n", _crc, unsigned(_expected_crc));
+        fail("CRC diferente do anunciado");
+        return CMD_ERR_CHECKSUM;
+    }
+
+    // Mesmo padrão do diário: quem vê o staging.bin vê a imagem inteira
+    if(fsync(_fd) != 0 || ::close(_fd) != 0 || ::rename(part_path().c_str(), _path.c_str()) != 0)
+    {
+        _fd = -1;
+        printf("[OTA] Upload: staging nao gravado: %s\n", strerror(errno));
+        fail("staging nao gravado");
+        return CMD_ERR_INVALID_STATE;
+    }
+    _fd = -1;
+    _active = false;
+
+    out.path = _path;
+    out.image = std::move(_image);
+    out.crc = _crc;
+    _image = {};
+
+    printf("[OTA] Upload concluido: %u bytes, CRC %04X\n", _size, _crc);
+    return CMD_OK;
+}
+
+void FirmwareStaging::abort()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    close_part();
+    _active = false;
+}
+
+bool FirmwareStaging::active() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _active;
+}
+
+uint32_t FirmwareStaging::received() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _received;
+}
+
+uint32_t FirmwareStaging::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _size;
+}
+
+const char* FirmwareStaging::error() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _error;
+}
+
+// Com _mutex
+void FirmwareStaging::fail(const char* reason)
+{
+    printf("[OTA] Upload abortado: %s (%u de %u bytes)\n", reason, _received, _size);
+    _error = reason;
+    _active = false;
+    close_part();
+}
+
+void FirmwareStaging::close_part()
+{
+    if(_fd >= 0)
+    {
+        ::close(_fd);
+        _fd = -1;
+        ::unlink(part_path().c_str());
+    }
+    _image = {};
+}
@@ -0,0 +1,104 @@
+#ifndef FIRMWARE_STAGING_HPP
+#define FIRMWARE_STAGING_HPP
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "firmware_layout.hpp"
+#include "firmware_store.hpp"
+
+typedef struct evp_md_ctx_st EVP_MD_CTX; // OpenSSL (SHA-256)
+
+// ============================================================
+// Upload da imagem para a partição de dados
+// ============================================================
+//
+// Chunks chegam em ordem (QoS 1 num tópico só) e vão direto para
+// <path>.part; CRC16 e SHA-256 são acumulados na chegada e a imagem fica
+// também em memória. No commit só se comparam os hashes, fsync + rename e a
+// imagem segue para o OtaJob sem reler o arquivo.
+//
+// Tamanho conferido no begin (espaço reservado com fallocate) e tabela de
+// vetores no primeiro chunk: imagem errada é recusada no começo do upload,
+// não depois de centenas de KB.
+
+static constexpr const char* FIRMWARE_STAGING_PATH = "/data/argus/firmware/staging.bin";
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+// 64 dígitos hexa (maiúsculos ou minúsculos)
+bool sha256_from_hex(std::string_view hex, Sha256Digest& out);
+
+// Imagem completa e conferida, pronta para o OTA
+struct StagedFirmware
+{
+    std::string path;
+    std::vector<uint8_t> image;
+    uint16_t crc = 0; // CRC16 (semente 0xFFFF), o mesmo do START/diário
+};
+
+enum class StagingChunk
+{
+    Stored,
+    Duplicate, // reentrega de um trecho já gravado
+    Rejected,  // sem upload ativo, fora de ordem, além do tamanho ou vetores inválidos
+};
+
+class FirmwareStaging
+{
+public:
+    explicit FirmwareStaging(std::string path = FIRMWARE_STAGING_PATH);
+    ~FirmwareStaging();
+
+    FirmwareStaging(const FirmwareStaging&) = delete;
+    FirmwareStaging& operator=(const FirmwareStaging&) = delete;
+
+    // Descarta qualquer upload anterior. crc = -1 quando não informado.
+    // CMD_ERR_PARAM_RANGE = tamanho fora da faixa; CMD_ERR_INVALID_STATE = sem espaço/arquivo.
+    uint8_t begin(uint32_t size, const Sha256Digest& sha256, int32_t crc = -1);
+
+    // Qualquer recusa aborta o upload (o publisher recomeça com begin)
+    StagingChunk write(uint32_t offset, const uint8_t* data, size_t len);
+
+    // CMD_ERR_INVALID_STATE = sem upload/incompleto; CMD_ERR_CHECKSUM = hash diferente
+    uint8_t commit(StagedFirmware& out);
+
+    void abort();
+
+    bool active() const;
+    uint32_t received() const;
+    uint32_t size() const;
+
+    // Motivo da última recusa ("" = nenhuma)
+    const char* error() const;
+
+private:
+    const std::string _path;
+    mutable std::mutex _mutex;
+
+    int _fd = -1;
+    bool _active = false;
+    bool _vectors_checked = false;
+    uint32_t _size = 0;
+    uint32_t _received = 0;
+    uint16_t _crc = 0xFFFF;
+    int32_t _expected_crc = -1;
+    Sha256Digest _expected_sha{};
+    EVP_MD_CTX* _sha = nullptr;
+    std::vector<uint8_t> _image;
+    const char* _error = "";
+
+    std::string part_path() const
+    {
+        return _path + ".part";
+    }
+
+    void fail(const char* reason);
+    void close_part();
+};
+
+#endif
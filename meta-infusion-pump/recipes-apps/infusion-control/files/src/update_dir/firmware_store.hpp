@@ -0,0 +1,87 @@
+#ifndef FIRMWARE_STORE_HPP
+#define FIRMWARE_STORE_HPP
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+extern "C"
+{
+#include "cmd.h"
+}
+
+// ============================================================
+// Imagens já instaladas (bases do delta)
+// ============================================================
+//
+// <dir>/stm32-<major>.<minor>.<patch>.bin = imagem daquela versão.
+//
+// Depois de um OTA bem-sucedido o updater ainda não sabe a versão nova (só
+// a aplicação, depois do boot, responde CMD_VERSION_REQ): a imagem fica como
+// pending.bin e é adotada com a versão que o STM32 reportar no próximo OTA.
+// Se o bootloader tiver feito rollback, o CRC da base no START não bate, o
+// updater esquece o arquivo e manda a imagem inteira — uma base errada nunca
+// chega a ser aplicada.
+
+// Partição de dados: sobrevive a updates do rootfs
+static constexpr const char* FIRMWARE_STORE_DIR = "/data/argus/firmware";
+
+class FirmwareStore
+{
+public:
+    explicit FirmwareStore(std::string dir) : _dir(std::move(dir)) {}
+
+    std::string path(const cmd_version_res_t& v) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "stm32-%u.%u.%u.bin", v.major, v.minor, v.patch);
+        return _dir + "/" + name;
+    }
+
+    // Caminho da base da versão instalada ("" = desconhecida)
+    std::string base_for(const cmd_version_res_t& v) const
+    {
+        std::error_code ec;
+        std::string base = path(v);
+
+        if(!std::filesystem::exists(base, ec) && std::filesystem::exists(pending(), ec))
+        {
+            std::filesystem::rename(pending(), base, ec);
+            if(!ec)
+                printf("[OTA] Imagem anterior adotada como base da versao %u.%u.%u\n", v.major, v.minor, v.patch);
+        }
+
+        return std::filesystem::exists(base, ec) ? base : std::string();
+    }
+
+    void forget(const cmd_version_res_t& v) const
+    {
+        std::error_code ec;
+        std::filesystem::remove(path(v), ec);
+    }
+
+    // Cópia da imagem recém-enviada (escrita em .tmp + rename)
+    bool save_pending(const std::string& image) const
+    {
+        std::error_code ec;
+        std::filesystem::create_directories(_dir, ec);
+
+        std::string tmp = pending() + ".tmp";
+        std::filesystem::copy_file(image, tmp, std::filesystem::copy_options::overwrite_existing, ec);
+        if(!ec)
+            std::filesystem::rename(tmp, pending(), ec);
+
+        return !ec;
+    }
+
+private:
+    std::string _dir;
+
+    std::string pending() const
+    {
+        return _dir + "/pending.bin";
+    }
+};
+
+#endif
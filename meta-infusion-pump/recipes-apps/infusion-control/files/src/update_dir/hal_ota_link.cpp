@@ -0,0 +1,28 @@
+#include "hal_ota_link.hpp"
+#include <cstdio>
+#include <thread>
+
+// Espera da READY: polling curto em vez dos 10 ms do updater antigo
+static constexpr std::chrono::microseconds READY_POLL{50};
+static constexpr std::chrono::milliseconds READY_TIMEOUT{5000};
+
+// Estabilização do DMA após a READY (mesmo valor do Stm32Bridge)
+static constexpr std::chrono::microseconds DMA_SETTLE{100};
+
+bool HalOtaLink::exchange(const uint8_t* tx, uint8_t* rx, size_t len)
+{
+    auto deadline = std::chrono::steady_clock::now() + READY_TIMEOUT;
+
+    while(!_ready.get())
+    {
+        if(std::chrono::steady_clock::now() > deadline)
+        {
+            printf("\n[FATAL] Timeout Hardware: STM32 não levantou pino Ready!\n");
+            return false;
+        }
+        std::this_thread::sleep_for(READY_POLL);
+    }
+
+    std::this_thread::sleep_for(DMA_SETTLE);
+    return _spi.transfer(tx, rx, len);
+}
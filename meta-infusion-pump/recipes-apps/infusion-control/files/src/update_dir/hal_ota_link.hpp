@@ -0,0 +1,31 @@
+#ifndef HAL_OTA_LINK_HPP
+#define HAL_OTA_LINK_HPP
+
+#include "ota_link.hpp"
+#include "hal_spi.hpp"
+#include "hal_gpio.hpp"
+
+// SPI + READY do próprio processo (stm32-updater)
+class HalOtaLink : public OtaLink
+{
+public:
+    HalOtaLink(HalSpi& spi, HalGpio& ready) : _spi(spi), _ready(ready) {}
+
+    bool exchange(const uint8_t* tx, uint8_t* rx, size_t len) override;
+
+    uint32_t speed() const override
+    {
+        return _spi.speed();
+    }
+
+    bool set_speed(uint32_t hz) override
+    {
+        return _spi.set_speed(hz);
+    }
+
+private:
+    HalSpi& _spi;
+    HalGpio& _ready;
+};
+
+#endif
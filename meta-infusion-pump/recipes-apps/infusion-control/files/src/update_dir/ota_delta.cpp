@@ -0,0 +1,212 @@
+#include "ota_delta.hpp"
+#include <algorithm>
+#include <cstring>
+
+extern "C"
+{
+#include "cmd.h"
+#include "utl_io.h"
+}
+
+// Chave do índice: 8 bytes da base em qualquer posição (Thumb desloca de 2 em 2)
+static constexpr size_t KEY_LEN = 8;
+static constexpr unsigned HASH_BITS = 16;
+
+// Candidatos examinados por posição (a cadeia de um hash comum, ex. 0xFF..., é longa)
+static constexpr unsigned MAX_CHAIN = 64;
+
+// COPY custa 7 bytes e RUN 4: abaixo disso sai mais barato como ADD
+static constexpr size_t MIN_COPY = 12;
+static constexpr size_t MIN_RUN = 8;
+
+static constexpr size_t MAX_OP_LEN = 0xFFFF;
+
+static uint32_t key_hash(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return uint32_t((v * 0x9E3779B97F4A7C15ull) >> (64 - HASH_BITS));
+}
+
+// ============================================================
+// Encoder
+// ============================================================
+
+static void emit_add(std::vector<uint8_t>& out, const uint8_t* data, size_t len)
+{
+    while(len > 0)
+    {
+        size_t n = std::min(len, MAX_OP_LEN);
+        uint8_t op[3];
+        uint8_t* p = op;
+        utl_io_put8_tl_ap(CMD_OTA_DELTA_ADD, p);
+        utl_io_put16_tl_ap(uint16_t(n), p);
+        out.insert(out.end(), op, p);
+        out.insert(out.end(), data, data + n);
+        data += n;
+        len -= n;
+    }
+}
+
+static void emit_copy(std::vector<uint8_t>& out, uint32_t src, size_t len)
+{
+    uint8_t op[7];
+    uint8_t* p = op;
+    utl_io_put8_tl_ap(CMD_OTA_DELTA_COPY, p);
+    utl_io_put32_tl_ap(src, p);
+    utl_io_put16_tl_ap(uint16_t(len), p);
+    out.insert(out.end(), op, p);
+}
+
+static void emit_run(std::vector<uint8_t>& out, uint8_t value, size_t len)
+{
+    uint8_t op[4];
+    uint8_t* p = op;
+    utl_io_put8_tl_ap(CMD_OTA_DELTA_RUN, p);
+    utl_io_put16_tl_ap(uint16_t(len), p);
+    utl_io_put8_tl_ap(value, p);
+    out.insert(out.end(), op, p);
+}
+
+std::vector<uint8_t> ota_delta_encode(const uint8_t* base, size_t base_len, const uint8_t* image, size_t image_len)
+{
+    std::vector<uint8_t> out;
+
+    // Índice da base: cadeias por hash (como o zlib), posição mais recente primeiro
+    std::vector<int32_t> head(size_t(1) << HASH_BITS, -1);
+    std::vector<int32_t> prev(base_len, -1);
+
+    for(size_t i = 0; i + KEY_LEN <= base_len; i++)
+    {
+        uint32_t h = key_hash(base + i);
+        prev[i] = head[h];
+        head[h] = int32_t(i);
+    }
+
+    auto match_len = [&](size_t src, size_t dst) {
+        size_t max = std::min({base_len - src, image_len - dst, MAX_OP_LEN});
+        size_t n = 0;
+        while(n < max && base[src + n] == image[dst + n])
+            n++;
+        return n;
+    };
+
+    size_t literal = 0; // ADD pendente: [literal, i)
+    size_t i = 0;
+    int64_t shift = 0;  // src - dst do último COPY
+
+    while(i < image_len)
+    {
+        size_t run = 1;
+        while(i + run < image_len && run < MAX_OP_LEN && image[i + run] == image[i])
+            run++;
+
+        // Continuação do último COPY: depois de um trecho alterado o resto
+        // costuma seguir com o mesmo deslocamento
+        size_t best_len = 0;
+        size_t best_src = 0;
+        int64_t cont = int64_t(i) + shift;
+        if(cont >= 0 && size_t(cont) < base_len)
+        {
+            best_len = match_len(size_t(cont), i);
+            best_src = size_t(cont);
+        }
+
+        if(best_len < MAX_OP_LEN && i + KEY_LEN <= image_len)
+        {
+            int32_t cand = head[key_hash(image + i)];
+            for(unsigned c = 0; cand >= 0 && c < MAX_CHAIN; c++, cand = prev[cand])
+            {
+                size_t n = match_len(size_t(cand), i);
+                if(n > best_len)
+                {
+                    best_len = n;
+                    best_src = size_t(cand);
+                    if(n == MAX_OP_LEN)
+                        break;
+                }
+            }
+        }
+
+        if(run >= MIN_RUN && run >= best_len)
+        {
+            emit_add(out, image + literal, i - literal);
+            emit_run(out, image[i], run);
+            i += run;
+            literal = i;
+        }
+        else if(best_len >= MIN_COPY)
+        {
+            emit_add(out, image + literal, i - literal);
+            emit_copy(out, uint32_t(best_src), best_len);
+            shift = int64_t(best_src) - int64_t(i);
+            i += best_len;
+            literal = i;
+        }
+        else
+            i++;
+    }
+
+    emit_add(out, image + literal, image_len - literal);
+    return out;
+}
+
+// ============================================================
+// Decoder (referência do bootloader)
+// ============================================================
+
+bool ota_delta_apply(const uint8_t* base, size_t base_len, const uint8_t* delta, size_t delta_len,
+                     std::vector<uint8_t>& out, size_t image_len)
+{
+    out.clear();
+    out.reserve(image_len);
+
+    uint8_t* p = const_cast<uint8_t*>(delta);
+    const uint8_t* end = delta + delta_len;
+
+    while(p < end)
+    {
+        uint8_t op = utl_io_get8_fl_ap(p);
+
+        switch(op)
+        {
+        case CMD_OTA_DELTA_ADD:
+        {
+            if(end - p < 2)
+                return false;
+            size_t len = utl_io_get16_fl_ap(p);
+            if(size_t(end - p) < len || out.size() + len > image_len)
+                return false;
+            out.insert(out.end(), p, p + len);
+            p += len;
+            break;
+        }
+        case CMD_OTA_DELTA_COPY:
+        {
+            if(end - p < 6)
+                return false;
+            size_t src = utl_io_get32_fl_ap(p);
+            size_t len = utl_io_get16_fl_ap(p);
+            if(src + len > base_len || out.size() + len > image_len)
+                return false;
+            out.insert(out.end(), base + src, base + src + len);
+            break;
+        }
+        case CMD_OTA_DELTA_RUN:
+        {
+            if(end - p < 3)
+                return false;
+            size_t len = utl_io_get16_fl_ap(p);
+            uint8_t value = utl_io_get8_fl_ap(p);
+            if(out.size() + len > image_len)
+                return false;
+            out.insert(out.end(), len, value);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    return out.size() == image_len;
+}
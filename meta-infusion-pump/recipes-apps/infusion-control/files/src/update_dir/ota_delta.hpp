@@ -0,0 +1,26 @@
+#ifndef OTA_DELTA_HPP
+#define OTA_DELTA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================
+// Delta de firmware (formato em cmd.h, CMD_OTA_DELTA_*)
+// ============================================================
+//
+// O hub calcula o delta entre a imagem instalada (base) e a nova; o
+// bootloader reconstrói a nova no banco inativo copiando trechos do banco
+// ativo. Mudanças típicas (poucas funções) deslocam o resto do código, então
+// o encoder procura cada trecho em qualquer posição da base, não só no
+// mesmo offset.
+
+// Delta que reconstrói 'image' a partir de 'base'
+std::vector<uint8_t> ota_delta_encode(const uint8_t* base, size_t base_len, const uint8_t* image, size_t image_len);
+
+// Aplica o delta como o bootloader faria (mesmos limites). Usado pelo hub
+// para conferir o encoder antes de enviar. false = delta malformado.
+bool ota_delta_apply(const uint8_t* base, size_t base_len, const uint8_t* delta, size_t delta_len,
+                     std::vector<uint8_t>& out, size_t image_len);
+
+#endif
@@ -0,0 +1,977 @@
+#include "ota_engine.hpp"
+#include "ota_delta.hpp"
+#include "ota_lz.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include "utl_crc16.h"
+#include "utl_io.h"
+}
+
+// Protocolo legado (valores do stm32-updater original)
+static constexpr size_t LEGACY_CHUNK = 48;
+static constexpr unsigned LEGACY_RETRIES = 3;
+static constexpr std::chrono::microseconds LEGACY_GAP{2000};
+static constexpr std::chrono::milliseconds LEGACY_START_SETTLE{500};
+static constexpr std::chrono::milliseconds LEGACY_RETRY_DELAY{100};
+
+// Polls aguardando um CMD_OTA_RES
+static constexpr unsigned RESULT_POLLS = 50;
+static constexpr std::chrono::milliseconds RESULT_INTERVAL{10};
+
+// START apaga o banco inativo; END confere o CRC da imagem inteira
+static constexpr unsigned ERASE_POLLS = 500; // ~5 s
+static constexpr unsigned VERIFY_POLLS = 500;
+
+// v2: START/END sem resultado por este número de polls são reenviados
+static constexpr unsigned RESEND_POLLS = 20;
+
+// Negociação: bootloader legado não responde CAPS (ou responde NACK).
+// Sem resposta, o CAPS_REQ é reenviado até CAPS_SENDS vezes.
+static constexpr unsigned CAPS_POLLS = 5;
+static constexpr unsigned CAPS_SENDS = 3;
+
+// Delta acima disto (% da imagem) não compensa a reconstrução no bootloader
+static constexpr uint32_t DELTA_MAX_PERCENT = 90;
+
+// Páginas: acima disto (% das páginas) delta/LZSS saem mais baratos
+static constexpr uint32_t PAGES_MAX_PERCENT = 25;
+
+// LZSS: amostra do início da imagem decide se vale comprimir (imagem já
+// comprimida/cifrada cresceria 1/8 com as flags)
+static constexpr size_t LZ_SAMPLE = 16 * 1024;
+static constexpr uint32_t LZ_MAX_PERCENT = 90;
+
+// v2: o ACK de um frame chega no mínimo uma transação depois dele
+static constexpr uint32_t ACK_LAG = 2;
+// Sem avanço do ACK cumulativo por este tempo: aborta
+static constexpr std::chrono::milliseconds STALL_TIMEOUT{5000};
+
+const char* ota_result_name(OtaResult result)
+{
+    switch(result)
+    {
+    case OtaResult::Ok:
+        return "ok";
+    case OtaResult::SourceError:
+        return "imagem invalida";
+    case OtaResult::LinkError:
+        return "falha de enlace";
+    case OtaResult::Rejected:
+        return "rejeitado pelo bootloader";
+    case OtaResult::BaseMismatch:
+        return "base do delta divergente";
+    case OtaResult::Timeout:
+        return "timeout";
+    case OtaResult::Cancelled:
+        return "cancelado";
+    }
+    return "?";
+}
+
+OtaEngine::OtaEngine(OtaLink& link, OtaSource& source, OtaOptions options)
+    : _link(link), _source(source), _options(options)
+{
+}
+
+// ============================================================
+// Transações
+// ============================================================
+
+// _tx já contém o frame; o resto da transação vai zerado.
+// Cancelamento aparece para os modos como falha de enlace (run() corrige).
+bool OtaEngine::transact(size_t frame_len)
+{
+    if(_cancel && _cancel->load())
+    {
+        _cancelled = true;
+        return false;
+    }
+
+    size_t len = std::max(frame_len, _xfer);
+    std::memset(_tx + frame_len, 0, len - frame_len);
+
+    if(_gap.count() > 0)
+        std::this_thread::sleep_for(_gap);
+
+    return _link.exchange(_tx, _rx, len);
+}
+
+// Transação só com zeros: o bootloader ignora e devolve o que tiver armado
+bool OtaEngine::poll()
+{
+    _stats.polls++;
+    return transact(0);
+}
+
+OtaResult OtaEngine::wait_result(uint8_t req_id, unsigned max_polls, std::chrono::milliseconds interval,
+                                 size_t resend_len)
+{
+    if(resend_len)
+        std::memcpy(_request, _tx, resend_len);
+
+    for(unsigned i = 0; i < max_polls; i++)
+    {
+        bool ok;
+        if(resend_len && i > 0 && i % RESEND_POLLS == 0)
+        {
+            _stats.retransmissions++;
+            std::memcpy(_tx, _request, resend_len);
+            ok = transact(resend_len);
+        }
+        else
+            ok = poll();
+
+        if(!ok)
+            return OtaResult::LinkError;
+
+        int status = -1;
+        ota_scan_frames(_rx, _xfer, [&](const OtaFrameView& f) {
+            // [0] ReqID [1] Status
+            if(f.id == CMD_OTA_RES_ID && f.len >= 2 && f.payload[0] == req_id)
+                status = f.payload[1];
+        });
+
+        if(status == CMD_OK)
+            return OtaResult::Ok;
+
+        if(status > 0)
+        {
+            _nack_status = status;
+            printf("-> NACK (Req: %02X Status: %d)\n", req_id, status);
+            return OtaResult::Rejected;
+        }
+
+        std::this_thread::sleep_for(interval);
+    }
+
+    printf("\n   [TIMEOUT] ACK nao recebido (Req: %02X).\n", req_id);
+    return OtaResult::Timeout;
+}
+
+bool OtaEngine::query_caps(cmd_ota_caps_t& caps)
+{
+    // CAPS_REQ ou CAPS_RES corrompidos no enlace: reenvia antes de concluir
+    // que o bootloader é legado. NACK é resposta definitiva.
+    for(unsigned send = 0; send < CAPS_SENDS; send++)
+    {
+        if(send > 0)
+            _stats.retransmissions++;
+
+        if(!transact(ota_build_frame(_tx, CMD_OTA_CAPS_REQ_ID, nullptr, 0)))
+            return false;
+
+        for(unsigned i = 0; i < CAPS_POLLS; i++)
+        {
+            bool found = false;
+            bool nack = false;
+            ota_scan_frames(_rx, OTA_XFER_SIZE, [&](const OtaFrameView& f) {
+                if(f.id == CMD_OTA_CAPS_RES_ID && f.len >= sizeof(cmd_ota_caps_t))
+                {
+                    std::memcpy(&caps, f.payload, sizeof(caps));
+                    found = true;
+                }
+                else if(f.id == CMD_OTA_RES_ID && f.len >= 2 && f.payload[0] == CMD_OTA_CAPS_REQ_ID &&
+                        f.payload[1] != CMD_OK)
+                    nack = true;
+            });
+
+            if(found)
+                return caps.proto >= CMD_OTA_PROTO_V2 && caps.max_window > 0 && caps.max_chunk > 0;
+            if(nack)
+                return false;
+
+            if(!poll())
+                return false;
+            std::this_thread::sleep_for(RESULT_INTERVAL);
+        }
+    }
+
+    printf("[OTA] CAPS sem resposta apos %u envios\n", CAPS_SENDS);
+    return false;
+}
+
+bool OtaEngine::query_status(cmd_ota_status_t& status)
+{
+    if(!transact(ota_build_frame(_tx, CMD_OTA_STATUS_REQ_ID, nullptr, 0)))
+        return false;
+
+    for(unsigned i = 0; i < CAPS_POLLS; i++)
+    {
+        if(!poll())
+            return false;
+
+        bool found = false;
+        ota_scan_frames(_rx, _xfer, [&](const OtaFrameView& f) {
+            if(f.id == CMD_OTA_STATUS_RES_ID && f.len >= sizeof(cmd_ota_status_t))
+            {
+                std::memcpy(&status, f.payload, sizeof(status));
+                found = true;
+            }
+        });
+
+        if(found)
+            return true;
+        std::this_thread::sleep_for(RESULT_INTERVAL);
+    }
+
+    return false;
+}
+
+bool OtaEngine::query_pages(uint32_t page_size, std::vector<uint16_t>& crcs)
+{
+    const uint32_t total = _stats.bytes;
+    const uint32_t count = (total + page_size - 1) / page_size;
+    crcs.assign(count, 0);
+
+    for(uint32_t first = 0; first < count; first += CMD_OTA_PAGES_MAX)
+    {
+        const uint8_t n = uint8_t(std::min<uint32_t>(CMD_OTA_PAGES_MAX, count - first));
+
+        uint8_t req[sizeof(cmd_ota_pages_req_t)];
+        uint8_t* p = req;
+        utl_io_put32_tl_ap(total, p);
+        utl_io_put16_tl_ap(uint16_t(first), p);
+        utl_io_put8_tl_ap(n, p);
+
+        if(!transact(ota_build_frame(_tx, CMD_OTA_PAGES_REQ_ID, req, sizeof(req))))
+            return false;
+
+        bool found = false;
+        for(unsigned i = 0; i < CAPS_POLLS && !found; i++)
+        {
+            if(!poll())
+                return false;
+
+            // [0..1] first [2] count [3..] CRCs
+            ota_scan_frames(_rx, _xfer, [&](const OtaFrameView& f) {
+                if(f.id != CMD_OTA_PAGES_RES_ID || f.len < 3 + 2 * n)
+                    return;
+
+                uint8_t* r = const_cast<uint8_t*>(f.payload);
+                if(utl_io_get16_fl_ap(r) != first || utl_io_get8_fl_ap(r) != n)
+                    return;
+
+                for(uint32_t k = 0; k < n; k++)
+                    crcs[first + k] = utl_io_get16_fl_ap(r);
+                found = true;
+            });
+
+            if(!found)
+                std::this_thread::sleep_for(RESULT_INTERVAL);
+        }
+
+        if(!found)
+            return false;
+    }
+
+    return true;
+}
+
+void OtaEngine::find_session(const cmd_ota_caps_t& caps)
+{
+    cmd_ota_status_t status{};
+    if(!query_status(status) || !status.open || status.committed == 0)
+        return;
+
+    // Sessão de páginas se retoma sozinha: a nova consulta pula o que já foi gravado
+    if(status.flags & CMD_OTA_START_PAGES)
+        return;
+
+    const uint8_t* image = _source.data(0, _stats.bytes);
+    if(!image || status.image_crc != image_crc(image))
+    {
+        printf("[OTA] Sessao aberta no bootloader e de outra imagem: recomecando do zero\n");
+        return;
+    }
+
+    // O stream só se reproduz no mesmo modo (base e compressão disponíveis)
+    if(((status.flags & CMD_OTA_START_DELTA) && (!_base || !(caps.features & CMD_OTA_FEAT_DELTA))) ||
+       ((status.flags & CMD_OTA_START_LZ) && (!_options.compress || caps.lz_window_bits < OTA_LZ_MIN_WINDOW_BITS)))
+    {
+        printf("[OTA] Sessao aberta num modo indisponivel agora: recomecando do zero\n");
+        return;
+    }
+
+    printf("[OTA] Sessao interrompida: %u bytes ja gravados no bootloader\n", status.committed);
+    _resume = status;
+}
+
+bool OtaEngine::query_version(cmd_version_res_t& version)
+{
+    // Quem responde é a aplicação: mesmo espaçamento da negociação
+    _gap = LEGACY_GAP;
+
+    if(!transact(ota_build_frame(_tx, CMD_VERSION_REQ_ID, nullptr, 0)))
+        return false;
+
+    for(unsigned i = 0; i < CAPS_POLLS; i++)
+    {
+        if(!poll())
+            return false;
+
+        bool found = false;
+        ota_scan_frames(_rx, _xfer, [&](const OtaFrameView& f) {
+            if(f.id == CMD_VERSION_RES_ID && f.len >= sizeof(cmd_version_res_t))
+            {
+                std::memcpy(&version, f.payload, sizeof(version));
+                found = true;
+            }
+        });
+
+        if(found)
+            return true;
+        std::this_thread::sleep_for(RESULT_INTERVAL);
+    }
+
+    return false;
+}
+
+// ============================================================
+// Execução
+// ============================================================
+
+uint16_t OtaEngine::image_crc(const uint8_t* image)
+{
+    if(!_image_crc)
+        _image_crc = utl_crc16_data(image, _stats.bytes, 0xFFFF);
+    return *_image_crc;
+}
+
+OtaResult OtaEngine::run()
+{
+    _stats = OtaStats{};
+    _stats.bytes = _source.size();
+    _stats.spi_hz = _link.speed();
+    _xfer = OTA_XFER_SIZE;
+    _cancelled = false;
+
+    if(_stats.bytes == 0)
+        return OtaResult::SourceError;
+
+    auto started = std::chrono::steady_clock::now();
+
+    // Negociação com o espaçamento legado: ainda não sabemos quem responde
+    _gap = LEGACY_GAP;
+
+    cmd_ota_caps_t caps{};
+    OtaResult result;
+
+    if(_options.allow_v2 && query_caps(caps))
+    {
+        const uint32_t initial_hz = _link.speed();
+
+        _gap = std::chrono::microseconds(0);
+
+        _resume.reset();
+        if(_options.resume && (caps.features & CMD_OTA_FEAT_RESUME))
+            find_session(caps);
+
+        // Retomada: o modo é o da sessão aberta
+        auto mode_allowed = [&](uint8_t mode) {
+            return !_resume || (_resume->flags & (CMD_OTA_START_DELTA | CMD_OTA_START_LZ)) == mode;
+        };
+
+        // Preferência: páginas alteradas, delta, imagem comprimida, imagem inteira
+        std::optional<OtaResult> sent;
+        if(!_resume && _options.skip_pages && (caps.features & CMD_OTA_FEAT_PAGES))
+            sent = run_pages(caps);
+
+        if(!sent && _base && (caps.features & CMD_OTA_FEAT_DELTA) && mode_allowed(CMD_OTA_START_DELTA))
+            sent = run_delta(caps);
+
+        if(sent == OtaResult::BaseMismatch)
+            sent.reset();
+
+        if(!sent && _options.compress && caps.lz_window_bits >= OTA_LZ_MIN_WINDOW_BITS &&
+           mode_allowed(CMD_OTA_START_LZ))
+            sent = run_compressed(caps);
+
+        if(sent)
+            result = *sent;
+        else
+        {
+            const uint8_t* image = _source.data(0, _stats.bytes);
+            _stats.delta = false;
+            if(image)
+            {
+                OtaStream stream(image, _stats.bytes);
+                result = run_windowed(caps, WindowedTransfer{stream, _stats.bytes, image_crc(image)});
+            }
+            else
+                result = OtaResult::SourceError;
+        }
+
+        // Próximo uso do enlace (daemon) volta ao clock e DMA de sempre
+        if(initial_hz != 0 && _link.speed() != initial_hz)
+            _link.set_speed(initial_hz);
+        _xfer = OTA_XFER_SIZE;
+    }
+    else
+    {
+        if(_options.allow_v2)
+        {
+            _stats.legacy_fallback = true;
+            printf("[OTA] Bootloader sem v2: caindo para o protocolo legado\n");
+        }
+        result = run_legacy();
+    }
+
+    _stats.elapsed =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    return _cancelled ? OtaResult::Cancelled : result;
+}
+
+OtaResult OtaEngine::run_legacy()
+{
+    printf("[OTA] Protocolo legado (chunk %zu, sem janela)\n", LEGACY_CHUNK);
+
+    const uint32_t total = _source.size();
+    _stats.chunk = LEGACY_CHUNK;
+    _stats.stream_bytes = total;
+
+    // 1. START
+    uint8_t start[sizeof(cmd_ota_start_t)];
+    utl_io_put32_tl(total, start);
+
+    if(!transact(ota_build_frame(_tx, CMD_OTA_START_REQ_ID, start, sizeof(start))))
+        return OtaResult::LinkError;
+
+    std::this_thread::sleep_for(LEGACY_START_SETTLE);
+
+    OtaResult res = wait_result(CMD_OTA_START_REQ_ID, RESULT_POLLS, RESULT_INTERVAL);
+    if(res != OtaResult::Ok)
+        return res;
+
+    // 2. CHUNKS
+    for(uint32_t offset = 0; offset < total;)
+    {
+        size_t len = std::min<size_t>(LEGACY_CHUNK, total - offset);
+        const uint8_t* data = _source.data(offset, len);
+        if(!data)
+            return OtaResult::SourceError;
+
+        // Os polls do wait_result usam o _tx: o frame é remontado a cada tentativa
+        auto build_chunk = [&]() {
+            uint8_t* p = _tx + CMD_HDR_SIZE;
+            utl_io_put32_tl_ap(offset, p);
+            utl_io_put8_tl_ap(uint8_t(len), p);
+            std::memcpy(p, data, len);
+            p += len;
+            return ota_finish_frame(_tx, CMD_OTA_CHUNK_REQ_ID, uint16_t(p - (_tx + CMD_HDR_SIZE)));
+        };
+
+        res = OtaResult::Timeout;
+        for(unsigned r = 0; r < LEGACY_RETRIES && res != OtaResult::Ok; r++)
+        {
+            if(r > 0)
+            {
+                _stats.retransmissions++;
+                std::this_thread::sleep_for(LEGACY_RETRY_DELAY);
+            }
+
+            _stats.frames++;
+            if(!transact(build_chunk()))
+                return OtaResult::LinkError;
+
+            res = wait_result(CMD_OTA_CHUNK_REQ_ID, RESULT_POLLS, RESULT_INTERVAL);
+            if(res == OtaResult::LinkError)
+                return res;
+        }
+
+        if(res != OtaResult::Ok)
+        {
+            printf("\n[ERRO] Offset %u\n", offset);
+            return res;
+        }
+
+        offset += len;
+        if(_progress)
+            _progress(offset, total);
+    }
+
+    // 3. END
+    if(!transact(ota_build_frame(_tx, CMD_OTA_END_REQ_ID, nullptr, 0)))
+        return OtaResult::LinkError;
+
+    return wait_result(CMD_OTA_END_REQ_ID, RESULT_POLLS, RESULT_INTERVAL);
+}
+
+std::optional<OtaResult> OtaEngine::run_pages(const cmd_ota_caps_t& caps)
+{
+    const uint32_t total = _source.size();
+    const uint32_t page_size = caps.page_size;
+    const uint8_t* image = _source.data(0, total);
+    if(!image || page_size == 0)
+        return std::nullopt;
+
+    std::vector<uint16_t> remote;
+    if(!query_pages(page_size, remote))
+    {
+        printf("[OTA] Bootloader nao respondeu os CRCs das paginas\n");
+        return std::nullopt;
+    }
+
+    std::vector<uint32_t> changed;
+    for(uint32_t page = 0; page < remote.size(); page++)
+    {
+        uint32_t offset = page * page_size;
+        uint32_t len = std::min(page_size, total - offset);
+        if(utl_crc16_data(image + offset, len, 0xFFFF) != remote[page])
+            changed.push_back(page);
+    }
+
+    const uint32_t pages = uint32_t(remote.size());
+    uint32_t percent = uint32_t(changed.size() * 100 / pages);
+    if(percent > PAGES_MAX_PERCENT)
+    {
+        printf("[OTA] %zu de %u paginas diferentes: sem atalho de paginas\n", changed.size(), pages);
+        return std::nullopt;
+    }
+
+    printf("[OTA] %zu de %u paginas diferentes (pagina de %u bytes)\n", changed.size(), pages, page_size);
+
+    _stats.pages_total = pages;
+    _stats.pages_sent = uint32_t(changed.size());
+
+    OtaStream stream(image, total);
+    WindowedTransfer transfer{stream, total, image_crc(image)};
+    transfer.pages = &changed;
+    transfer.page_size = page_size;
+    return run_windowed(caps, transfer);
+}
+
+std::optional<OtaResult> OtaEngine::run_delta(const cmd_ota_caps_t& caps)
+{
+    const uint32_t total = _source.size();
+    const uint32_t base_size = _base->size();
+    const uint8_t* image = _source.data(0, total);
+    const uint8_t* base = _base->data(0, base_size);
+    if(!image || !base)
+        return std::nullopt;
+
+    std::vector<uint8_t> delta = ota_delta_encode(base, base_size, image, total);
+    uint32_t percent = uint32_t(uint64_t(delta.size()) * 100 / total);
+
+    if(percent > DELTA_MAX_PERCENT)
+    {
+        printf("[OTA] Delta de %zu bytes (%u%% da imagem): enviando a imagem inteira\n", delta.size(), percent);
+        return std::nullopt;
+    }
+
+    // O encoder é conferido aqui: um delta errado só apareceria no CRC do END,
+    // depois de apagar o banco inativo
+    std::vector<uint8_t> check;
+    if(!ota_delta_apply(base, base_size, delta.data(), delta.size(), check, total) ||
+       std::memcmp(check.data(), image, total) != 0)
+    {
+        printf("[OTA] Delta nao reconstroi a imagem: enviando a imagem inteira\n");
+        return std::nullopt;
+    }
+
+    printf("[OTA] Delta: %zu bytes (%u%% da imagem)\n", delta.size(), percent);
+
+    cmd_ota_delta_info_t info{};
+    info.image_size = total;
+    info.base_size = base_size;
+    info.base_crc = utl_crc16_data(base, base_size, 0xFFFF);
+
+    _stats.delta = true;
+    OtaStream stream(delta.data(), uint32_t(delta.size()));
+    OtaResult res = run_windowed(caps, WindowedTransfer{stream, total, image_crc(image), &info});
+
+    if(res == OtaResult::BaseMismatch)
+    {
+        _stats.base_rejected = true;
+        printf("[OTA] Bootloader recusou a base (CRC do banco ativo): enviando a imagem inteira\n");
+    }
+    return res;
+}
+
+std::optional<OtaResult> OtaEngine::run_compressed(const cmd_ota_caps_t& caps)
+{
+    const uint32_t total = _source.size();
+    const uint8_t* image = _source.data(0, total);
+    if(!image)
+        return std::nullopt;
+
+    const unsigned bits = std::min<unsigned>(caps.lz_window_bits, OTA_LZ_MAX_WINDOW_BITS);
+
+    size_t sample = std::min<size_t>(total, LZ_SAMPLE);
+    size_t sample_out = 0;
+    ota_lz_compress(image, sample, bits, [&](const uint8_t*, size_t len) {
+        sample_out += len;
+        return true;
+    });
+
+    // Sessão LZSS a retomar: comprime de qualquer jeito (mesmo stream)
+    uint32_t percent = uint32_t(sample_out * 100 / sample);
+    if(percent > LZ_MAX_PERCENT && !_resume)
+    {
+        printf("[OTA] Imagem nao comprime (%u%% na amostra): enviando sem LZSS\n", percent);
+        return std::nullopt;
+    }
+
+    printf("[OTA] LZSS (janela %u bytes, ~%u%% na amostra)\n", 1u << bits, percent);
+
+    // Produtor: comprime e confere (decoder de referência) antes de liberar
+    // o fim do stream; o END só sai depois da conferência
+    OtaStream stream(ota_lz_bound(total));
+    std::thread producer([&]() {
+        bool ok = ota_lz_compress(image, total, bits,
+                                  [&](const uint8_t* data, size_t len) { return stream.append(data, len); });
+
+        std::vector<uint8_t> check;
+        if(ok && (!ota_lz_decompress(stream.data(), stream.size(), bits, check, total) || check.size() != total ||
+                  std::memcmp(check.data(), image, total) != 0))
+        {
+            printf("\n[OTA] Stream LZSS nao reconstroi a imagem\n");
+            ok = false;
+        }
+
+        stream.finish(ok);
+    });
+
+    _stats.compressed = true;
+    OtaResult res = run_windowed(caps, WindowedTransfer{stream, total, image_crc(image), nullptr, uint8_t(bits)});
+
+    // O produtor nunca bloqueia (buffer com a capacidade máxima): termina sozinho
+    producer.join();
+    return res;
+}
+
+OtaResult OtaEngine::run_windowed(const cmd_ota_caps_t& caps, const WindowedTransfer& transfer)
+{
+    const OtaStream& stream = transfer.stream;
+    const uint8_t* data = stream.data();
+    const cmd_ota_delta_info_t* delta = transfer.delta;
+
+    // Janela além do SACK não teria como reportar buracos
+    const uint32_t window = std::min<uint32_t>({_options.window, caps.max_window, CMD_OTA_SACK_BITS});
+    uint32_t chunk = std::min<uint32_t>({caps.max_chunk, _options.max_chunk, CMD_OTA_V2_CHUNK_MAX});
+
+    uint8_t flags = 0;
+    if(delta)
+        flags |= CMD_OTA_START_DELTA;
+    if(transfer.lz_window_bits)
+        flags |= CMD_OTA_START_LZ;
+    if(transfer.pages)
+        flags |= CMD_OTA_START_PAGES;
+
+    // Delta: o tamanho do stream; imagem (crua ou comprimida): o tamanho gravado
+    const uint32_t start_size = delta ? stream.size() : transfer.image_size;
+
+    // Retomada: só se a sessão aberta no bootloader for deste mesmo stream
+    uint32_t resume_from = 0;
+    if(_resume)
+    {
+        const cmd_ota_status_t session = *_resume;
+        _resume.reset(); // uma tentativa só
+
+        bool same = session.flags == flags && session.total_size == start_size &&
+                    session.image_crc == transfer.image_crc && session.chunk > 0 && session.chunk <= chunk &&
+                    session.committed % session.chunk == 0 && stream.wait(session.committed) >= session.committed &&
+                    utl_crc16_data(data, session.committed, 0xFFFF) == session.stream_crc;
+
+        if(same)
+        {
+            chunk = session.chunk;
+            resume_from = session.committed;
+        }
+        else
+            printf("[OTA] Sessao do bootloader nao confere com este stream: recomecando do zero\n");
+    }
+
+    // Modo páginas: só as páginas alteradas; páginas vizinhas viram um trecho
+    // só, cortado em frames de até um chunk
+    struct Extent
+    {
+        uint32_t offset;
+        uint32_t len;
+    };
+
+    std::vector<Extent> extents;
+    uint32_t pages_bytes = 0;
+
+    if(transfer.pages)
+    {
+        const std::vector<uint32_t>& pages = *transfer.pages;
+        for(size_t i = 0; i < pages.size();)
+        {
+            size_t j = i + 1;
+            while(j < pages.size() && pages[j] == pages[j - 1] + 1)
+                j++;
+
+            uint32_t begin = pages[i] * transfer.page_size;
+            uint32_t end = std::min((pages[j - 1] + 1) * transfer.page_size, transfer.image_size);
+            for(uint32_t off = begin; off < end; off += chunk)
+                extents.push_back(Extent{off, std::min(chunk, end - off)});
+
+            pages_bytes += end - begin;
+            i = j;
+        }
+    }
+
+    auto frame_extent = [&](uint32_t seq) {
+        if(transfer.pages)
+            return extents[seq];
+        uint32_t offset = seq * chunk;
+        return Extent{offset, std::min(chunk, stream.size() - offset)};
+    };
+
+    // Conhecido quando o produtor termina (stream pronto: desde já)
+    uint32_t frame_count = UINT32_MAX;
+    auto update_frame_count = [&]() {
+        if(transfer.pages)
+            frame_count = uint32_t(extents.size());
+        else if(stream.complete())
+            frame_count = (stream.size() + chunk - 1) / chunk;
+    };
+    update_frame_count();
+
+    // Retransmissão por tempo: a janela inteira + folga, em transações
+    const uint32_t rto = window + 2 * ACK_LAG;
+
+    // Clock: o menor entre o do bootloader e o validado no hub; sem nenhum
+    // dos dois (ou enlace sem troca de clock) fica o atual
+    uint32_t spi_hz = _link.speed();
+    if(_options.max_spi_hz != 0 && caps.max_spi_hz != 0 && spi_hz != 0)
+        spi_hz = std::min(_options.max_spi_hz, caps.max_spi_hz);
+
+    _stats.windowed = true;
+    _stats.window = uint8_t(window);
+    _stats.chunk = uint8_t(chunk);
+
+    printf("[OTA] Protocolo v2: janela %u, chunk %u, SPI %u Hz\n", window, chunk, spi_hz);
+
+    // 1. START (o bootloader confere image_crc no END e, no delta, a base antes de apagar)
+    uint8_t start[sizeof(cmd_ota_start_v2_t) + sizeof(cmd_ota_delta_info_t) + sizeof(cmd_ota_lz_info_t)];
+    uint8_t* p;
+    OtaResult res;
+
+    for(;;)
+    {
+        p = start;
+        utl_io_put32_tl_ap(start_size, p);
+        utl_io_put8_tl_ap(CMD_OTA_PROTO_V2, p);
+        utl_io_put8_tl_ap(uint8_t(window), p);
+        utl_io_put8_tl_ap(uint8_t(chunk), p);
+        utl_io_put8_tl_ap(resume_from ? flags | CMD_OTA_START_RESUME : flags, p);
+        utl_io_put16_tl_ap(transfer.image_crc, p);
+        utl_io_put32_tl_ap(spi_hz, p);
+
+        if(delta)
+        {
+            utl_io_put32_tl_ap(delta->image_size, p);
+            utl_io_put32_tl_ap(delta->base_size, p);
+            utl_io_put16_tl_ap(delta->base_crc, p);
+        }
+
+        if(transfer.lz_window_bits)
+            utl_io_put8_tl_ap(transfer.lz_window_bits, p);
+
+        size_t frame_len = ota_build_frame(_tx, CMD_OTA_START_REQ_ID, start, uint16_t(p - start));
+        if(!transact(frame_len))
+            return OtaResult::LinkError;
+
+        _nack_status = CMD_OK;
+        res = wait_result(CMD_OTA_START_REQ_ID, ERASE_POLLS, RESULT_INTERVAL, frame_len);
+
+        if(res == OtaResult::Rejected && resume_from && _nack_status == CMD_ERR_INVALID_STATE)
+        {
+            printf("[OTA] Bootloader recusou a retomada: recomecando do zero\n");
+            resume_from = 0;
+            continue;
+        }
+        break;
+    }
+
+    if(res == OtaResult::Rejected && delta && _nack_status == CMD_ERR_CHECKSUM)
+        return OtaResult::BaseMismatch;
+    if(res != OtaResult::Ok)
+        return res;
+
+    if(resume_from)
+    {
+        _stats.resumed_from = resume_from;
+        printf("[OTA] Retomando em %u de %u bytes\n", resume_from, start_size);
+    }
+
+    // Daqui até o END: frames do tamanho do chunk, no clock negociado
+    _xfer = CMD_OTA_V2_XFER_SIZE(chunk);
+    if(spi_hz != _link.speed() && !_link.set_speed(spi_hz))
+        return OtaResult::LinkError;
+    _stats.spi_hz = _link.speed();
+
+    // 2. Janela
+    struct Slot
+    {
+        uint32_t sent_at = 0; // índice da transação do último envio
+        unsigned retries = 0;
+        bool sacked = false;
+    };
+
+    std::vector<Slot> slots(window);
+    uint32_t base = resume_from / chunk; // seq mais antigo sem ACK cumulativo
+    uint32_t next = base;                // próximo seq novo
+    uint32_t xfer = 0;    // transações feitas
+    int64_t highest_sacked = -1;
+    int ack_error = CMD_OK;
+
+    auto last_progress = std::chrono::steady_clock::now();
+
+    auto apply_ack = [&](const OtaFrameView& f) {
+        if(f.id == CMD_OTA_RES_ID && f.len >= 2 && f.payload[1] != CMD_OK)
+        {
+            ack_error = f.payload[1];
+            return;
+        }
+
+        if(f.id != CMD_OTA_ACK_ID || f.len < sizeof(cmd_ota_ack_t))
+            return;
+
+        uint8_t* a = const_cast<uint8_t*>(f.payload);
+        uint16_t next16 = utl_io_get16_fl_ap(a);
+        uint32_t sack = utl_io_get32_fl_ap(a);
+        uint8_t status = utl_io_get8_fl_ap(a);
+
+        if(status != CMD_OK)
+        {
+            ack_error = status;
+            return;
+        }
+
+        // Desenrola o seq de 16 bits em torno da base; ACK velho cai fora da janela
+        uint32_t cum = base + uint16_t(next16 - uint16_t(base));
+        if(cum > next)
+            return;
+
+        base = cum;
+
+        for(uint32_t i = 0; i < CMD_OTA_SACK_BITS; i++)
+        {
+            uint32_t s = cum + 1 + i;
+            if(s >= next)
+                break;
+            if(sack & (1u << i))
+            {
+                slots[s % window].sacked = true;
+                highest_sacked = std::max<int64_t>(highest_sacked, s);
+            }
+        }
+    };
+
+    while(base < frame_count)
+    {
+        // Retransmissão: primeiro buraco apontado pelo SACK ou vencido pelo RTO
+        int64_t pick = -1;
+        for(uint32_t s = base; s < next; s++)
+        {
+            const Slot& slot = slots[s % window];
+            if(slot.sacked)
+                continue;
+
+            uint32_t age = xfer - slot.sent_at;
+            if((age > ACK_LAG && highest_sacked > int64_t(s)) || age > rto)
+            {
+                pick = s;
+                break;
+            }
+        }
+
+        if(pick >= 0)
+        {
+            Slot& slot = slots[pick % window];
+            if(++slot.retries > _options.max_retries)
+            {
+                printf("\n[ERRO] Offset %u sem ACK apos %u retransmissoes\n", frame_extent(uint32_t(pick)).offset,
+                       _options.max_retries);
+                return OtaResult::Timeout;
+            }
+            _stats.retransmissions++;
+        }
+        else if(next < frame_count && next < base + window)
+        {
+            // Stream ainda em produção: espera o chunk inteiro (ou o fim)
+            stream.wait((next + 1) * chunk);
+            update_frame_count();
+            if(stream.failed())
+                return OtaResult::SourceError;
+
+            if(next < frame_count)
+            {
+                pick = next++;
+                slots[pick % window] = Slot{};
+            }
+        }
+
+        size_t frame_len = 0;
+        if(pick >= 0)
+        {
+            const Extent extent = frame_extent(uint32_t(pick));
+            const uint32_t offset = extent.offset;
+            const size_t len = extent.len;
+
+            // Da imagem (mapeada) direto para o _tx: uma cópia e o CRC do
+            // frame sobre bytes que acabaram de passar pelo cache
+            uint8_t* const payload = _tx + CMD_HDR_SIZE;
+            p = payload;
+            utl_io_put16_tl_ap(uint16_t(pick), p);
+            utl_io_put32_tl_ap(offset, p);
+            utl_io_put8_tl_ap(uint8_t(len), p);
+            std::memcpy(p, data + offset, len);
+            p += len;
+
+            frame_len = ota_finish_frame(_tx, CMD_OTA_WCHUNK_REQ_ID, uint16_t(p - payload));
+            slots[pick % window].sent_at = xfer;
+            _stats.frames++;
+        }
+        else
+            _stats.polls++; // janela cheia: só busca o ACK
+
+        if(!transact(frame_len))
+            return OtaResult::LinkError;
+        xfer++;
+
+        uint32_t before = base;
+        ota_scan_frames(_rx, _xfer, apply_ack);
+
+        if(ack_error != CMD_OK)
+        {
+            printf("\n-> NACK (WCHUNK Status: %d)\n", ack_error);
+            return OtaResult::Rejected;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if(base != before)
+        {
+            last_progress = now;
+            // Comprimido: até o produtor terminar só se conhece o tamanho da imagem
+            uint32_t sent = transfer.pages ? pages_bytes : stream.size();
+            if(_progress)
+                _progress(std::min(base * chunk, sent), stream.complete() ? sent : transfer.image_size);
+        }
+        else if(now - last_progress > STALL_TIMEOUT)
+        {
+            printf("\n[ERRO] Bootloader parou de confirmar (base seq %u)\n", base);
+            return OtaResult::Timeout;
+        }
+    }
+
+    if(stream.failed())
+        return OtaResult::SourceError;
+    _stats.stream_bytes = transfer.pages ? pages_bytes : stream.size();
+
+    // 3. END (conferência do CRC no bootloader)
+    size_t end_len = ota_build_frame(_tx, CMD_OTA_END_REQ_ID, nullptr, 0);
+    if(!transact(end_len))
+        return OtaResult::LinkError;
+
+    return wait_result(CMD_OTA_END_REQ_ID, VERIFY_POLLS, RESULT_INTERVAL, end_len);
+}
@@ -0,0 +1,208 @@
+#ifndef OTA_ENGINE_HPP
+#define OTA_ENGINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "ota_link.hpp"
+#include "ota_source.hpp"
+#include "ota_stream.hpp"
+
+extern "C"
+{
+#include "cmd.h"
+}
+
+// ============================================================
+// Motor do OTA
+// ============================================================
+//
+// Negocia o protocolo com o bootloader (CMD_OTA_CAPS_REQ, ver cmd.h):
+//
+//   legado: START, um CHUNK de 48 bytes por vez, cada um esperando o
+//           CMD_OTA_RES com polls de 10 ms (comportamento original).
+//   v2:     janela deslizante com frames grandes. Chunk (até o máximo do
+//           frame) e clock do SPI são negociados no START, limitados pelo
+//           caps do bootloader e por max_spi_hz (taxa validada do hub).
+//           Até 'window' frames WCHUNK sem confirmação;
+//           o ACK (cumulativo + SACK de 32 bits) chega de carona na
+//           transação seguinte. Um seq é retransmitido quando o SACK mostra
+//           que um posterior chegou (buraco) ou quando passa do RTO medido
+//           em transações; seqs já confirmados nunca são reenviados.
+//   delta:  com uma base (imagem instalada, ver set_delta_base) e
+//           CMD_OTA_FEAT_DELTA no caps, o v2 transporta o delta
+//           (ota_delta.hpp) em vez da imagem. Delta grande demais ou base
+//           recusada pelo bootloader (CRC do banco ativo) = imagem inteira.
+//   LZSS:   sem delta, e com caps.lz_window_bits, a imagem vai comprimida
+//           (ota_lz.hpp). A compressão roda numa thread produtora enquanto
+//           os primeiros frames já estão saindo.
+//   páginas: com CMD_OTA_FEAT_PAGES, compara o CRC de cada página do banco
+//           inativo com a imagem nova e manda só as diferentes (reinstalar
+//           a mesma imagem ou quase a mesma termina em segundos). Vem antes
+//           do delta; muitas páginas diferentes = segue para os outros modos.
+//   retomada: com CMD_OTA_FEAT_RESUME, uma sessão aberta no bootloader
+//           para esta mesma imagem continua do offset que ele já gravou
+//           (o hub confere o CRC do prefixo do stream antes).
+//
+// Síncrono: roda na thread de quem chama. Cancelável entre transações
+// (set_cancel): a sessão fica aberta no bootloader e o banco ativo intacto.
+
+struct OtaOptions
+{
+    uint8_t window = 16;       // pedido; limitado pelo caps e pelo SACK
+    uint32_t max_spi_hz = 0;   // clock do v2 (0 = mantém o atual)
+    uint8_t max_chunk = CMD_OTA_V2_CHUNK_MAX; // limite do hub para o chunk do v2
+    bool allow_v2 = true;      // false = força o protocolo legado
+    bool compress = true;      // LZSS quando o bootloader suporta
+    bool resume = true;        // retoma sessão interrompida da mesma imagem
+    bool skip_pages = true;    // pula páginas iguais às do banco inativo
+    unsigned max_retries = 8;  // retransmissões de um mesmo frame antes de abortar
+};
+
+struct OtaStats
+{
+    bool windowed = false;
+    bool legacy_fallback = false; // v2 permitido, mas a negociação (CAPS) falhou
+    uint8_t window = 1;
+    uint8_t chunk = 0;
+    uint32_t spi_hz = 0;
+    bool delta = false;
+    bool base_rejected = false;   // bootloader recusou a base do delta
+    bool compressed = false;
+    uint32_t resumed_from = 0;    // bytes do stream que já estavam no bootloader
+    uint32_t pages_total = 0;     // modo páginas: páginas da imagem
+    uint32_t pages_sent = 0;      // ... e quantas foram enviadas
+    uint32_t bytes = 0;           // tamanho da imagem
+    uint32_t stream_bytes = 0;    // bytes efetivamente enviados (delta ou imagem)
+    uint32_t frames = 0;          // frames de dados (inclui retransmissões)
+    uint32_t retransmissions = 0;
+    uint32_t polls = 0;           // transações só para buscar ACK/resultado
+    std::chrono::milliseconds elapsed{0};
+
+    double bytes_per_second() const
+    {
+        return elapsed.count() > 0 ? bytes * 1000.0 / elapsed.count() : 0.0;
+    }
+};
+
+enum class OtaResult
+{
+    Ok,
+    SourceError, // imagem vazia/ilegível/fora do layout (firmware_layout.hpp)
+    LinkError,   // SPI/READY
+    Rejected,    // NACK do bootloader
+    BaseMismatch, // delta: bootloader não reconheceu a base
+    Timeout,
+    Cancelled,   // set_cancel
+};
+
+const char* ota_result_name(OtaResult result);
+
+class OtaEngine
+{
+public:
+    // acked = bytes confirmados pelo bootloader
+    using ProgressFn = std::function<void(uint32_t acked, uint32_t total)>;
+
+    OtaEngine(OtaLink& link, OtaSource& source, OtaOptions options = OtaOptions{});
+
+    void set_progress(ProgressFn fn)
+    {
+        _progress = std::move(fn);
+    }
+
+    // Lido antes de cada transação; true = aborta com OtaResult::Cancelled
+    void set_cancel(const std::atomic<bool>* flag)
+    {
+        _cancel = flag;
+    }
+
+    // Imagem instalada no STM32 (nullptr = sempre a imagem inteira)
+    void set_delta_base(OtaSource* base)
+    {
+        _base = base;
+    }
+
+    // CRC16 da imagem já conhecido (staging do upload, diário): evita
+    // percorrer a imagem de novo
+    void set_image_crc(uint16_t crc)
+    {
+        _image_crc = crc;
+    }
+
+    // CMD_VERSION_REQ pelo mesmo enlace (identifica a base no hub)
+    bool query_version(cmd_version_res_t& version);
+
+    OtaResult run();
+
+    const OtaStats& stats() const
+    {
+        return _stats;
+    }
+
+private:
+    OtaLink& _link;
+    OtaSource& _source;
+    OtaSource* _base = nullptr;
+    OtaOptions _options;
+    ProgressFn _progress;
+    OtaStats _stats;
+
+    const std::atomic<bool>* _cancel = nullptr;
+    bool _cancelled = false;
+
+    // Espaço entre transações (o bootloader legado precisa de 2 ms)
+    std::chrono::microseconds _gap{0};
+
+    // Tamanho de cada transação (negociado no v2)
+    size_t _xfer = OTA_XFER_SIZE;
+
+    // Status do último NACK recebido em wait_result
+    int _nack_status = CMD_OK;
+
+    // CRC16 da imagem inteira (calculado uma vez, ver image_crc)
+    std::optional<uint16_t> _image_crc;
+
+    // Sessão aberta no bootloader que pode ser retomada
+    std::optional<cmd_ota_status_t> _resume;
+
+    uint8_t _tx[300];
+    uint8_t _rx[300];
+    uint8_t _request[300]; // cópia do último START/END para reenvio
+
+    bool transact(size_t frame_len);
+    uint16_t image_crc(const uint8_t* image);
+    bool poll();
+    bool query_caps(cmd_ota_caps_t& caps);
+    bool query_status(cmd_ota_status_t& status);
+    bool query_pages(uint32_t page_size, std::vector<uint16_t>& crcs);
+    void find_session(const cmd_ota_caps_t& caps);
+    // resend_len != 0: o frame em _tx é reenviado se o resultado demorar (v2)
+    OtaResult wait_result(uint8_t req_id, unsigned max_polls, std::chrono::milliseconds interval,
+                          size_t resend_len = 0);
+
+    OtaResult run_legacy();
+    // O que o START v2 anuncia e de onde saem os WCHUNK
+    struct WindowedTransfer
+    {
+        const OtaStream& stream;
+        uint32_t image_size; // total_size do START (tamanho gravado)
+        uint16_t image_crc;
+        const cmd_ota_delta_info_t* delta = nullptr;
+        uint8_t lz_window_bits = 0; // 0 = sem compressão
+        const std::vector<uint32_t>* pages = nullptr; // modo páginas: índices a enviar
+        uint32_t page_size = 0;
+    };
+
+    // nullopt = não compensa; manda a imagem inteira
+    std::optional<OtaResult> run_pages(const cmd_ota_caps_t& caps);
+    std::optional<OtaResult> run_delta(const cmd_ota_caps_t& caps);
+    std::optional<OtaResult> run_compressed(const cmd_ota_caps_t& caps);
+    OtaResult run_windowed(const cmd_ota_caps_t& caps, const WindowedTransfer& transfer);
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "ota_job.hpp"
+#include "firmware_layout.hpp"
+#include <cstdio>
+
+extern "C"
+{
+#include "utl_crc16.h"
+}
+
+// Diário regravado a cada tanto de progresso (não a cada ACK)
+static constexpr uint32_t JOURNAL_STEP = 16 * 1024;
+
+OtaResult OtaJob::run(const std::string& path)
+{
+    _stats = OtaStats{};
+
+    FileOtaSource image;
+    const bool preloaded = !_image.empty();
+    if(preloaded)
+        image.assign(std::move(_image));
+    else if(!image.open(path))
+    {
+        printf("[OTA] Imagem %s ilegivel\n", path.c_str());
+        return OtaResult::SourceError;
+    }
+
+    // Tudo conferido antes do primeiro frame: imagem fora do layout da
+    // aplicação não chega a apagar o banco inativo
+    const uint8_t* vectors = image.data(0, FIRMWARE_VECTOR_BYTES);
+    if(!firmware_size_ok(image.size()) || !vectors || !firmware_vector_table_ok(vectors))
+    {
+        printf("[OTA] Imagem %s recusada: %u bytes, tabela de vetores %s\n", path.c_str(), image.size(),
+               vectors && firmware_vector_table_ok(vectors) ? "ok" : "invalida");
+        return OtaResult::SourceError;
+    }
+
+    const uint16_t image_crc =
+        preloaded ? _image_crc : utl_crc16_data(image.data(0, image.size()), image.size(), 0xFFFF);
+
+    OtaEngine engine(_link, image, _config.options);
+    engine.set_cancel(_cancel);
+    engine.set_image_crc(image_crc);
+
+    // Base do delta: imagem da versão que o STM32 diz estar rodando
+    FirmwareStore store(_config.store_dir);
+    FileOtaSource base_image;
+    cmd_version_res_t installed{};
+    bool known_version = _config.use_delta && _config.options.allow_v2 && engine.query_version(installed);
+
+    if(known_version)
+    {
+        std::string base = store.base_for(installed);
+        printf("[OTA] Instalado: %u.%u.%u (%s)\n", installed.major, installed.minor, installed.patch,
+               base.empty() ? "sem base para delta" : base.c_str());
+        if(!base.empty() && base_image.open(base))
+            engine.set_delta_base(&base_image);
+    }
+
+    // Diário: se o processo cair, a próxima subida do daemon oferece a
+    // retomada desta imagem e o bootloader diz de onde continuar
+    OtaJournal journal(_config.journal_path);
+    OtaJournalEntry entry;
+    entry.image = path;
+    entry.size = image.size();
+    entry.crc = image_crc;
+
+    OtaJournalEntry previous;
+    if(journal.load(previous) && previous.size == entry.size && previous.crc == entry.crc)
+        printf("[OTA] OTA anterior desta imagem interrompido (%u bytes confirmados)\n", previous.acked);
+
+    if(!journal.save(entry))
+        printf("[OTA] Aviso: diario %s nao gravado\n", _config.journal_path.c_str());
+
+    engine.set_progress([&](uint32_t acked, uint32_t total) {
+        if(acked >= entry.acked + JOURNAL_STEP)
+        {
+            entry.acked = acked;
+            journal.save(entry);
+        }
+
+        if(_progress)
+            _progress(acked, total);
+    });
+
+    OtaResult result = engine.run();
+    _stats = engine.stats();
+
+    if(known_version && _stats.base_rejected)
+        store.forget(installed);
+
+    // Falha de enlace/timeout: a sessão continua aberta no bootloader.
+    // Cancelamento é do operador: não oferecer retomada na próxima subida.
+    if(result != OtaResult::LinkError && result != OtaResult::Timeout)
+        journal.clear();
+
+    if(result == OtaResult::Ok && _config.use_delta && !store.save_pending(path))
+        printf("[OTA] Aviso: imagem nao guardada em %s (proximo update sera completo)\n", _config.store_dir.c_str());
+
+    return result;
+}
+
+void ota_print_summary(OtaResult result, const OtaStats& st)
+{
+    printf("[OTA] %s em %.2f s: %.0f bytes/s (%s, janela %u, chunk %u, SPI %u Hz)\n", ota_result_name(result),
+           st.elapsed.count() / 1000.0, st.bytes_per_second(), st.windowed ? "v2" : "legado", st.window, st.chunk,
+           st.spi_hz);
+    printf("[OTA] frames %u, retransmissoes %u, polls %u, enviados %u bytes%s\n", st.frames, st.retransmissions,
+           st.polls, st.stream_bytes, st.delta ? " (delta)" : st.compressed ? " (LZSS)" : "");
+
+    if(st.legacy_fallback)
+        printf("[OTA] Negociacao v2 falhou: transferido pelo protocolo legado\n");
+
+    if(st.pages_total)
+        printf("[OTA] Paginas: %u de %u enviadas\n", st.pages_sent, st.pages_total);
+
+    if(st.resumed_from)
+        printf("[OTA] Retomado: %u bytes ja estavam no bootloader\n", st.resumed_from);
+
+    if(result == OtaResult::LinkError || result == OtaResult::Timeout)
+        printf("[OTA] Diario mantido: o proximo OTA retoma de onde parou\n");
+}
@@ -0,0 +1,72 @@
+#ifndef OTA_JOB_HPP
+#define OTA_JOB_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "firmware_store.hpp"
+#include "ota_engine.hpp"
+#include "ota_journal.hpp"
+
+// ============================================================
+// OTA completo de um arquivo
+// ============================================================
+//
+// Em volta do motor: base do delta (versão instalada + FirmwareStore),
+// diário da transferência e guarda da imagem enviada como próxima base.
+// Mesmo fluxo no stm32-updater (HalOtaLink) e no daemon (BridgeOtaLink).
+
+struct OtaJobConfig
+{
+    OtaOptions options;
+    std::string store_dir = FIRMWARE_STORE_DIR;
+    std::string journal_path = OTA_JOURNAL_PATH;
+    bool use_delta = true;
+};
+
+class OtaJob
+{
+public:
+    OtaJob(OtaLink& link, OtaJobConfig config) : _link(link), _config(std::move(config)) {}
+
+    void set_progress(OtaEngine::ProgressFn fn)
+    {
+        _progress = std::move(fn);
+    }
+
+    void set_cancel(const std::atomic<bool>* flag)
+    {
+        _cancel = flag;
+    }
+
+    // Conteúdo de 'path' já em memória, com o CRC16 calculado na chegada
+    // (FirmwareStaging): run() não relê o arquivo nem percorre a imagem
+    void set_image(std::vector<uint8_t> image, uint16_t crc)
+    {
+        _image = std::move(image);
+        _image_crc = crc;
+    }
+
+    // Síncrono. Diário mantido só em falha de enlace/timeout (retomável).
+    OtaResult run(const std::string& path);
+
+    const OtaStats& stats() const
+    {
+        return _stats;
+    }
+
+private:
+    OtaLink& _link;
+    OtaJobConfig _config;
+    OtaEngine::ProgressFn _progress;
+    const std::atomic<bool>* _cancel = nullptr;
+    OtaStats _stats;
+    std::vector<uint8_t> _image;
+    uint16_t _image_crc = 0;
+};
+
+// Resumo da transferência (taxa, modo, retransmissões) no log
+void ota_print_summary(OtaResult result, const OtaStats& stats);
+
+#endif
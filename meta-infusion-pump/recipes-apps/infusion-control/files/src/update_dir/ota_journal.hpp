@@ -0,0 +1,95 @@
+#ifndef OTA_JOURNAL_HPP
+#define OTA_JOURNAL_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+// ============================================================
+// Diário do OTA no hub
+// ============================================================
+//
+// Escrito pelo stm32-updater durante a transferência e apagado no fim
+// (sucesso ou recusa definitiva do bootloader). Se o updater ou o daemon
+// caírem no meio, o InfusionManager encontra o diário na subida, confere o
+// CRC da imagem e anuncia a retomada no tópico ota; o OTA só é relançado
+// por comando (resume_ota) e com o STM32 ocioso. O ponto de retomada vem do
+// bootloader (committed, ver CMD_OTA_STATUS_REQ): o diário só diz o que
+// estava sendo enviado.
+//
+// Formato texto, uma chave por linha (image=, size=, crc=, acked=).
+
+static constexpr const char* OTA_JOURNAL_PATH = "/data/argus/ota.journal";
+
+struct OtaJournalEntry
+{
+    std::string image;
+    uint32_t size = 0;
+    uint16_t crc = 0;
+    uint32_t acked = 0; // último ACK cumulativo visto (informativo)
+};
+
+class OtaJournal
+{
+public:
+    explicit OtaJournal(std::string path = OTA_JOURNAL_PATH) : _path(std::move(path)) {}
+
+    bool load(OtaJournalEntry& entry) const
+    {
+        std::ifstream file(_path);
+        if(!file.is_open())
+            return false;
+
+        std::string line;
+        while(std::getline(file, line))
+        {
+            auto eq = line.find('=');
+            if(eq == std::string::npos)
+                continue;
+
+            std::string key = line.substr(0, eq);
+            std::string value = line.substr(eq + 1);
+
+            if(key == "image")
+                entry.image = value;
+            else if(key == "size")
+                entry.size = uint32_t(std::strtoul(value.c_str(), nullptr, 10));
+            else if(key == "crc")
+                entry.crc = uint16_t(std::strtoul(value.c_str(), nullptr, 16));
+            else if(key == "acked")
+                entry.acked = uint32_t(std::strtoul(value.c_str(), nullptr, 10));
+        }
+
+        return !entry.image.empty() && entry.size > 0;
+    }
+
+    // .tmp + fsync + rename: uma queda de energia deixa o diário velho ou o novo
+    bool save(const OtaJournalEntry& entry) const
+    {
+        std::string tmp = _path + ".tmp";
+        FILE* file = fopen(tmp.c_str(), "w");
+        if(!file)
+            return false;
+
+        fprintf(file, "image=%s\nsize=%u\ncrc=%04X\nacked=%u\n", entry.image.c_str(), entry.size, entry.crc,
+                entry.acked);
+
+        bool ok = fflush(file) == 0 && fsync(fileno(file)) == 0;
+        ok = (fclose(file) == 0) && ok;
+
+        return ok && std::rename(tmp.c_str(), _path.c_str()) == 0;
+    }
+
+    void clear() const
+    {
+        std::remove(_path.c_str());
+    }
+
+private:
+    std::string _path;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "ota_link.hpp"
+#include <cstring>
+
+extern "C"
+{
+#include "cmd.h"
+#include "utl_crc16.h"
+#include "utl_io.h"
+}
+
+size_t ota_build_frame(uint8_t* buf, uint8_t id, const uint8_t* payload, uint16_t len)
+{
+    if(len > 0)
+        std::memcpy(buf + CMD_HDR_SIZE, payload, len);
+
+    return ota_finish_frame(buf, id, len);
+}
+
+size_t ota_finish_frame(uint8_t* buf, uint8_t id, uint16_t len)
+{
+    uint8_t* p = buf;
+    utl_io_put8_tl_ap(CMD_SOF_1_BYTE, p);
+    utl_io_put8_tl_ap(CMD_SOF_2_BYTE, p);
+    utl_io_put8_tl_ap(ADDR_SLAVE, p);
+    utl_io_put8_tl_ap(ADDR_MASTER, p);
+    utl_io_put8_tl_ap(id, p);
+    utl_io_put16_tl_ap(len, p);
+    p += len;
+
+    uint16_t crc = utl_crc16_data(buf, p - buf, 0xFFFF);
+    utl_io_put16_tl_ap(crc, p);
+    return p - buf;
+}
+
+void ota_scan_frames(const uint8_t* rx, size_t len, const std::function<void(const OtaFrameView&)>& fn)
+{
+    size_t i = 0;
+    while(i + CMD_HDR_SIZE + CMD_TRAILER_SIZE <= len)
+    {
+        if(rx[i] != CMD_SOF_1_BYTE || rx[i + 1] != CMD_SOF_2_BYTE)
+        {
+            i++;
+            continue;
+        }
+
+        uint8_t* p = const_cast<uint8_t*>(rx + i);
+        uint16_t payload_len = utl_io_get16_fl(p + 5);
+        size_t total = CMD_HDR_SIZE + payload_len + CMD_TRAILER_SIZE;
+
+        if(i + total > len || utl_io_get16_fl(p + total - 2) != utl_crc16_data(p, total - 2, 0xFFFF))
+        {
+            i++; // SOF falso (dados) ou frame truncado
+            continue;
+        }
+
+        fn(OtaFrameView{p[4], p + CMD_HDR_SIZE, payload_len});
+        i += total;
+    }
+}
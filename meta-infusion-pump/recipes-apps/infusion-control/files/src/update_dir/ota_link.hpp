@@ -0,0 +1,68 @@
+#ifndef OTA_LINK_HPP
+#define OTA_LINK_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// ============================================================
+// Enlace do OTA
+// ============================================================
+//
+// Uma transação = espera a READY do STM32 e faz uma transferência SPI
+// full-duplex: o frame do hub sai em tx enquanto rx recebe o que o
+// bootloader tinha armado no DMA (ACKs do frame anterior, resultados).
+// O motor (ota_engine.hpp) não conhece o transporte: HalOtaLink
+// (stm32-updater), BridgeOtaLink (daemon) ou o bootloader simulado do
+// stm32-ota-bench.
+
+// Transação do protocolo legado e da negociação (DMA de 64 bytes no
+// bootloader); o v2 usa CMD_OTA_V2_XFER_SIZE(chunk) depois do START
+static constexpr size_t OTA_XFER_SIZE = 64;
+
+class OtaLink
+{
+public:
+    virtual ~OtaLink() = default;
+
+    // tx e rx com pelo menos 'len' bytes
+    virtual bool exchange(const uint8_t* tx, uint8_t* rx, size_t len) = 0;
+
+    // Clock do enlace (0 = o transporte não permite trocar)
+    virtual uint32_t speed() const
+    {
+        return 0;
+    }
+
+    virtual bool set_speed(uint32_t)
+    {
+        return false;
+    }
+};
+
+// ============================================================
+// Frames
+// ============================================================
+//
+// Mesmo formato do cmd.c: AA 55 DST SRC ID SIZE(2) PAYLOAD CRC16(2),
+// CRC sobre tudo desde o SOF (semente 0xFFFF).
+
+// Monta o frame em buf (FRAME_MAX_CMD_SIZE bytes). Retorna o tamanho.
+size_t ota_build_frame(uint8_t* buf, uint8_t id, const uint8_t* payload, uint16_t len);
+
+// Para payload já escrito em buf + CMD_HDR_SIZE (WCHUNK copiado direto da
+// imagem para o buffer de TX): só cabeçalho e CRC. Retorna o tamanho.
+size_t ota_finish_frame(uint8_t* buf, uint8_t id, uint16_t len);
+
+struct OtaFrameView
+{
+    uint8_t id;
+    const uint8_t* payload;
+    uint16_t len;
+};
+
+// Chama 'fn' para cada frame válido (CRC ok) em rx
+void ota_scan_frames(const uint8_t* rx, size_t len, const std::function<void(const OtaFrameView&)>& fn);
+
+#endif
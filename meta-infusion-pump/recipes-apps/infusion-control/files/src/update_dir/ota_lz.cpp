@@ -0,0 +1,158 @@
+#include "ota_lz.hpp"
+#include <algorithm>
+
+extern "C"
+{
+#include "cmd.h"
+#include "utl_io.h"
+}
+
+static constexpr unsigned HASH_BITS = 14;
+static constexpr unsigned MAX_CHAIN = 32;
+
+// Saída entregue ao sink em blocos (o consumidor acorda por bloco, não por item)
+static constexpr size_t SINK_BLOCK = 4096;
+
+static uint32_t hash3(const uint8_t* p)
+{
+    uint32_t v = uint32_t(p[0]) << 16 | uint32_t(p[1]) << 8 | p[2];
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+bool ota_lz_compress(const uint8_t* in, size_t len, unsigned window_bits, const OtaLzSink& sink)
+{
+    const size_t window = size_t(1) << window_bits;
+    const size_t max_match = CMD_OTA_LZ_MIN_MATCH + (size_t(1) << (16 - window_bits)) - 1;
+
+    std::vector<int32_t> head(size_t(1) << HASH_BITS, -1);
+    std::vector<int32_t> prev(len, -1);
+
+    auto insert = [&](size_t pos) {
+        if(pos + CMD_OTA_LZ_MIN_MATCH > len)
+            return;
+        uint32_t h = hash3(in + pos);
+        prev[pos] = head[h];
+        head[h] = int32_t(pos);
+    };
+
+    std::vector<uint8_t> pending;
+    pending.reserve(SINK_BLOCK + 17);
+
+    // Grupo atual: flags + até 8 itens (literal ou referência de 2 bytes)
+    uint8_t group[1 + 8 * 2];
+    size_t group_len = 1;
+    unsigned items = 0;
+    group[0] = 0;
+
+    auto close_group = [&]() {
+        pending.insert(pending.end(), group, group + group_len);
+        group[0] = 0;
+        group_len = 1;
+        items = 0;
+
+        if(pending.size() < SINK_BLOCK)
+            return true;
+
+        bool ok = sink(pending.data(), pending.size());
+        pending.clear();
+        return ok;
+    };
+
+    size_t i = 0;
+    while(i < len)
+    {
+        size_t best_len = 0;
+        size_t best_dist = 0;
+
+        if(i + CMD_OTA_LZ_MIN_MATCH <= len)
+        {
+            const size_t limit = std::min(max_match, len - i);
+            int32_t cand = head[hash3(in + i)];
+
+            for(unsigned c = 0; cand >= 0 && c < MAX_CHAIN && i - size_t(cand) <= window; c++, cand = prev[cand])
+            {
+                size_t n = 0;
+                while(n < limit && in[size_t(cand) + n] == in[i + n])
+                    n++;
+
+                if(n > best_len)
+                {
+                    best_len = n;
+                    best_dist = i - size_t(cand);
+                    if(n == limit)
+                        break;
+                }
+            }
+        }
+
+        if(best_len >= CMD_OTA_LZ_MIN_MATCH)
+        {
+            uint8_t* p = group + group_len;
+            group[0] |= uint8_t(1u << items);
+            utl_io_put16_tl_ap(uint16_t((best_dist - 1) | ((best_len - CMD_OTA_LZ_MIN_MATCH) << window_bits)), p);
+            group_len += 2;
+
+            for(size_t k = 0; k < best_len; k++)
+                insert(i + k);
+            i += best_len;
+        }
+        else
+        {
+            group[group_len++] = in[i];
+            insert(i);
+            i++;
+        }
+
+        if(++items == 8 && !close_group())
+            return false;
+    }
+
+    if(items > 0)
+        pending.insert(pending.end(), group, group + group_len);
+
+    return pending.empty() || sink(pending.data(), pending.size());
+}
+
+bool ota_lz_decompress(const uint8_t* in, size_t len, unsigned window_bits, std::vector<uint8_t>& out,
+                       size_t max_out)
+{
+    const uint16_t dist_mask = uint16_t((1u << window_bits) - 1);
+
+    out.clear();
+    out.reserve(max_out);
+
+    uint8_t* p = const_cast<uint8_t*>(in);
+    const uint8_t* end = in + len;
+
+    while(p < end)
+    {
+        uint8_t flags = utl_io_get8_fl_ap(p);
+
+        for(unsigned bit = 0; bit < 8 && p < end; bit++)
+        {
+            if(!(flags & (1u << bit)))
+            {
+                if(out.size() >= max_out)
+                    return false;
+                out.push_back(utl_io_get8_fl_ap(p));
+                continue;
+            }
+
+            if(end - p < 2)
+                return false;
+
+            uint16_t ref = utl_io_get16_fl_ap(p);
+            size_t dist = size_t(ref & dist_mask) + 1;
+            size_t n = size_t(ref >> window_bits) + CMD_OTA_LZ_MIN_MATCH;
+
+            if(dist > out.size() || out.size() + n > max_out)
+                return false;
+
+            // Byte a byte: a referência pode sobrepor o que está sendo escrito
+            for(size_t k = 0; k < n; k++)
+                out.push_back(out[out.size() - dist]);
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,35 @@
+#ifndef OTA_LZ_HPP
+#define OTA_LZ_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ============================================================
+// LZSS do OTA (formato em cmd.h, CMD_OTA_START_LZ)
+// ============================================================
+//
+// Janela pequena (2^8 .. 2^12 bytes) para caber na RAM do bootloader.
+// Código de firmware repete prólogos, tabelas e padding; na prática a
+// imagem cai para 50-70% do tamanho.
+
+static constexpr unsigned OTA_LZ_MIN_WINDOW_BITS = 8;
+static constexpr unsigned OTA_LZ_MAX_WINDOW_BITS = 12;
+
+// Pior caso (tudo literal): um byte de flags a cada 8
+constexpr size_t ota_lz_bound(size_t len)
+{
+    return len + (len + 7) / 8;
+}
+
+// Recebe a saída em blocos, à medida que sai; false interrompe a compressão
+using OtaLzSink = std::function<bool(const uint8_t* data, size_t len)>;
+
+bool ota_lz_compress(const uint8_t* in, size_t len, unsigned window_bits, const OtaLzSink& sink);
+
+// Referência do bootloader (mesmos limites). false = stream malformado.
+bool ota_lz_decompress(const uint8_t* in, size_t len, unsigned window_bits, std::vector<uint8_t>& out,
+                       size_t max_out);
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef OTA_SOURCE_HPP
+#define OTA_SOURCE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// ============================================================
+// Origem da imagem do OTA
+// ============================================================
+//
+// O motor só enxerga bytes por offset; de onde eles vêm (arquivo, staging
+// do upload, ...) fica atrás desta interface.
+
+class OtaSource
+{
+public:
+    virtual ~OtaSource() = default;
+
+    virtual uint32_t size() const = 0;
+
+    // Ponteiro para [offset, offset + len) válido até a próxima chamada
+    // (nullptr = fora da imagem)
+    virtual const uint8_t* data(uint32_t offset, size_t len) = 0;
+};
+
+// Imagem mapeada do arquivo (mmap): sem cópia para o heap, as páginas vêm
+// do page cache conforme os WCHUNK avançam e os frames são montados
+// direto do mapeamento. Quem troca a imagem deve gravar ao lado e fazer
+// rename (como o FirmwareStaging): truncar um arquivo mapeado é SIGBUS.
+class FileOtaSource : public OtaSource
+{
+public:
+    FileOtaSource() = default;
+
+    FileOtaSource(const FileOtaSource&) = delete;
+    FileOtaSource& operator=(const FileOtaSource&) = delete;
+
+    ~FileOtaSource() override
+    {
+        unmap();
+    }
+
+    bool open(const std::string& path)
+    {
+        unmap();
+        _image.clear();
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+            return false;
+
+        struct stat st;
+        if(fstat(fd, &st) != 0 || st.st_size <= 0 || uint64_t(st.st_size) > UINT32_MAX)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void* addr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // o mapeamento segura o arquivo
+        if(addr == MAP_FAILED)
+            return false;
+
+        // Envio quase sempre sequencial; o CRC da imagem já traz tudo para o cache
+        madvise(addr, size_t(st.st_size), MADV_SEQUENTIAL);
+
+        _map = addr;
+        _data = static_cast<const uint8_t*>(addr);
+        _size = uint32_t(st.st_size);
+        return true;
+    }
+
+    // Imagem que já está em memória (upload recém-gravado no staging)
+    void assign(std::vector<uint8_t> image)
+    {
+        unmap();
+        _image = std::move(image);
+        _data = _image.data();
+        _size = uint32_t(_image.size());
+    }
+
+    uint32_t size() const override
+    {
+        return _size;
+    }
+
+    const uint8_t* data(uint32_t offset, size_t len) override
+    {
+        if(size_t(offset) + len > _size)
+            return nullptr;
+        return _data + offset;
+    }
+
+private:
+    void* _map = nullptr;
+    std::vector<uint8_t> _image;
+    const uint8_t* _data = nullptr;
+    uint32_t _size = 0;
+
+    void unmap()
+    {
+        if(_map)
+            munmap(_map, _size);
+        _map = nullptr;
+        _data = nullptr;
+        _size = 0;
+    }
+};
+
+#endif
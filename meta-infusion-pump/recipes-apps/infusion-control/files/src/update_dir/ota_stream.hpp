@@ -0,0 +1,98 @@
+#ifndef OTA_STREAM_HPP
+#define OTA_STREAM_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// ============================================================
+// Bytes enviados nos WCHUNK
+// ============================================================
+//
+// Pronto de antemão (imagem, delta) ou produzido por outra thread enquanto
+// o envio já começou (compressão). O buffer do produtor é alocado com a
+// capacidade máxima no início: data() não muda e o motor pode reenviar
+// qualquer trecho já produzido sem cópia.
+
+class OtaStream
+{
+public:
+    OtaStream(const uint8_t* data, uint32_t size) : _data(data), _size(size), _state(State::Done) {}
+
+    explicit OtaStream(size_t capacity) : _buffer(capacity), _data(_buffer.data()) {}
+
+    OtaStream(const OtaStream&) = delete;
+    OtaStream& operator=(const OtaStream&) = delete;
+
+    const uint8_t* data() const
+    {
+        return _data;
+    }
+
+    uint32_t size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _size;
+    }
+
+    bool complete() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _state != State::Producing;
+    }
+
+    bool failed() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _state == State::Failed;
+    }
+
+    // Espera até haver 'end' bytes ou o produtor terminar. Retorna o tamanho atual.
+    uint32_t wait(uint32_t end) const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [&]() { return _size >= end || _state != State::Producing; });
+        return _size;
+    }
+
+    // ---- produtor ----
+
+    bool append(const uint8_t* data, size_t len)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_size + len > _buffer.size())
+            return false;
+
+        std::memcpy(_buffer.data() + _size, data, len);
+        _size += uint32_t(len);
+        _cv.notify_all();
+        return true;
+    }
+
+    void finish(bool ok)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _state = ok ? State::Done : State::Failed;
+        _cv.notify_all();
+    }
+
+private:
+    enum class State
+    {
+        Producing,
+        Done,
+        Failed,
+    };
+
+    std::vector<uint8_t> _buffer;
+    const uint8_t* _data;
+    uint32_t _size = 0;
+    State _state = State::Producing;
+
+    mutable std::mutex _mutex;
+    mutable std::condition_variable _cv;
+};
+
+#endif
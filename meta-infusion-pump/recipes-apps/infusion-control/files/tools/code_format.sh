@@ -1,7 +1,9 @@
 #!/bin/bash
 
 dirs=(
+    ../src/bench
     ../src/drivers  
+    ../src/dsp
     ../src/hal/gpio
     ../src/hal/i2c
     ../src/hal/spi